@@ -0,0 +1,690 @@
+// Benchmark do rasterizador com cenas geradas (reprodutiveis pela semente).
+//
+//   render_bench                      -> suite padrao, tabela no terminal
+//   render_bench --format json        -> saida para scripts/dashboards
+//   render_bench --cubes 5000 --lights 8 --size 1920x1080 --shading phong
+//                --camera near --frames 100
+//
+// Mede a latencia de cada frame (limpeza do framebuffer e Renderer::render
+// completo: culling, geometria, raster e shading) e reporta triangulos/s,
+// Mpixels/s, fragmentos sombreados/s e percentis de latencia. Os contadores
+// de trabalho vem de Renderer::frameCounters(); com a biblioteca compilada
+// com RENDER_STATS o JSON traz tambem os tempos medios de cada etapa.
+// Alocacoes no heap por frame (de todas as threads) sao contadas pelo
+// operator new deste executavel, incluindo as formas alinhadas: em regime
+// devem ser 0.
+#include "src/pipeline/Renderer.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+// ============ ALOCACOES ============
+// Substitui o operator new global so neste executavel; a biblioteca (e o
+// pool de threads) tambem passa por aqui.
+
+static std::atomic<long long> heapAllocations{0};
+
+// Todas as formas (simples, array, nothrow e alinhada com std::align_val_t)
+// contam: um alignas(32/64) no heap tambem e alocacao por frame.
+static void *countedAlloc(std::size_t size, std::size_t align) {
+  heapAllocations.fetch_add(1, std::memory_order_relaxed);
+  if (size == 0)
+    size = 1;
+  if (align <= alignof(std::max_align_t))
+    return std::malloc(size);
+  // aligned_alloc exige tamanho multiplo do alinhamento
+  align = std::max(align, sizeof(void *));
+  return std::aligned_alloc(align, (size + align - 1) / align * align);
+}
+
+static void *countedNew(std::size_t size, std::size_t align) {
+  if (void *p = countedAlloc(size, align))
+    return p;
+  throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size) {
+  return countedNew(size, alignof(std::max_align_t));
+}
+void *operator new[](std::size_t size) {
+  return countedNew(size, alignof(std::max_align_t));
+}
+void *operator new(std::size_t size, std::align_val_t align) {
+  return countedNew(size, static_cast<std::size_t>(align));
+}
+void *operator new[](std::size_t size, std::align_val_t align) {
+  return countedNew(size, static_cast<std::size_t>(align));
+}
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  return countedAlloc(size, alignof(std::max_align_t));
+}
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  return countedAlloc(size, alignof(std::max_align_t));
+}
+void *operator new(std::size_t size, std::align_val_t align,
+                   const std::nothrow_t &) noexcept {
+  return countedAlloc(size, static_cast<std::size_t>(align));
+}
+void *operator new[](std::size_t size, std::align_val_t align,
+                     const std::nothrow_t &) noexcept {
+  return countedAlloc(size, static_cast<std::size_t>(align));
+}
+
+// malloc e aligned_alloc liberam com free, entao todo delete e igual
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
+void operator delete(void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+  std::free(p);
+}
+void operator delete(void *p, std::align_val_t,
+                     const std::nothrow_t &) noexcept {
+  std::free(p);
+}
+void operator delete[](void *p, std::align_val_t,
+                       const std::nothrow_t &) noexcept {
+  std::free(p);
+}
+
+// ============ CENAS ============
+
+// Posicionamento da camera (e da geometria) de cada cena
+enum class CameraMode {
+  Orbit,    // camera fora da nuvem de cubos, girando em volta dela
+  Overdraw, // coluna de cubos alinhada ao eixo de visao, de tras para frente
+  Near      // camera dentro da nuvem: muitos triangulos cruzam o plano near
+};
+
+struct SceneSpec {
+  std::string name;
+  int cubes{1000};
+  int lights{2};
+  double lightRange{0.0}; // 0 = luzes sem alcance
+  int width{1280}, height{720};
+  bool phong{true};
+  CameraMode camera{CameraMode::Orbit};
+  bool deferred{false};
+  bool occlusion{false};
+  int msaa{1}; // amostras por pixel
+  bool shadows{false};
+  bool temporal{false}; // cache temporal (deferred)
+  // Arco da camera nos frames medidos (orbit); 360 = uma volta
+  double orbitDegrees{360.0};
+};
+
+static const char *cameraName(CameraMode mode) {
+  switch (mode) {
+  case CameraMode::Overdraw:
+    return "overdraw";
+  case CameraMode::Near:
+    return "near";
+  default:
+    return "orbit";
+  }
+}
+
+static bool parseCamera(const char *s, CameraMode &mode) {
+  if (!std::strcmp(s, "orbit"))
+    mode = CameraMode::Orbit;
+  else if (!std::strcmp(s, "overdraw"))
+    mode = CameraMode::Overdraw;
+  else if (!std::strcmp(s, "near"))
+    mode = CameraMode::Near;
+  else
+    return false;
+  return true;
+}
+
+// Suite padrao: cobre flat x Phong, pouca e muita sobreposicao, plano near
+// e muitas luzes
+static std::vector<SceneSpec> defaultSuite() {
+  std::vector<SceneSpec> suite;
+  auto add = [&](const char *name, int cubes, int lights, bool phong,
+                 CameraMode camera) -> SceneSpec & {
+    SceneSpec spec;
+    spec.name = name;
+    spec.cubes = cubes;
+    spec.lights = lights;
+    spec.phong = phong;
+    spec.camera = camera;
+    suite.push_back(spec);
+    return suite.back();
+  };
+  add("orbit_flat_1k", 1000, 2, false, CameraMode::Orbit);
+  add("orbit_phong_1k", 1000, 2, true, CameraMode::Orbit);
+  add("orbit_phong_20k", 20000, 4, true, CameraMode::Orbit);
+  add("overdraw_phong", 2000, 2, true, CameraMode::Overdraw);
+  add("overdraw_phong_deferred", 2000, 2, true, CameraMode::Overdraw)
+      .deferred = true;
+  add("orbit_phong_1k_msaa4", 1000, 2, true, CameraMode::Orbit).msaa = 4;
+  add("orbit_phong_1k_shadows", 1000, 2, true, CameraMode::Orbit).shadows =
+      true;
+  // Cache temporal contra o frame normal, em orbita lenta (1 grau por
+  // frame com 30 frames), com e sem sombras
+  for (bool shadows : {false, true})
+    for (bool temporal : {false, true}) {
+      std::string name = std::string("orbit_slow_deferred") +
+                         (shadows ? "_shadows" : "") +
+                         (temporal ? "_temporal" : "");
+      SceneSpec &slow =
+          add(name.c_str(), 1000, 2, true, CameraMode::Orbit);
+      slow.deferred = true;
+      slow.shadows = shadows;
+      slow.temporal = temporal;
+      slow.orbitDegrees = 30.0;
+    }
+  add("near_phong", 5000, 2, true, CameraMode::Near);
+  SceneSpec &lights = add("many_lights", 2000, 512, true, CameraMode::Orbit);
+  lights.lightRange = 3.0;
+  SceneSpec &hd = add("orbit_phong_1080p", 5000, 4, true, CameraMode::Orbit);
+  hd.width = 1920;
+  hd.height = 1080;
+  return suite;
+}
+
+// Lado da regiao ocupada pelos cubos (densidade aproximadamente constante)
+static double sceneExtent(const SceneSpec &spec) {
+  return 2.0 * std::cbrt(static_cast<double>(spec.cubes));
+}
+
+static Scene buildScene(const SceneSpec &spec, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  Scene scene;
+  double extent = sceneExtent(spec);
+
+  scene.cubes.reserve(spec.cubes);
+  for (int i = 0; i < spec.cubes; ++i) {
+    Cube cube;
+    if (spec.camera == CameraMode::Overdraw) {
+      // Coluna ao longo de z, do fundo para a frente (pior caso do z-test)
+      double t = static_cast<double>(i) / std::max(1, spec.cubes - 1);
+      cube.position = Vec3{(uniform(rng) - 0.5) * 2.0,
+                           (uniform(rng) - 0.5) * 2.0,
+                           -extent * 4.0 * (1.0 - t)};
+      cube.scale = 1.5 + uniform(rng);
+    } else {
+      cube.position = Vec3{(uniform(rng) - 0.5) * extent,
+                           (uniform(rng) - 0.5) * extent,
+                           (uniform(rng) - 0.5) * extent};
+      cube.scale = 0.4 + 0.6 * uniform(rng);
+    }
+    cube.rotation = Vec3{uniform(rng) * 3.0, uniform(rng) * 3.0,
+                         uniform(rng) * 3.0};
+    cube.material.color = Vec3{0.3 + 0.7 * uniform(rng),
+                               0.3 + 0.7 * uniform(rng),
+                               0.3 + 0.7 * uniform(rng)};
+    cube.material.shininess = (i % 4 == 0) ? 12.5 : 32.0;
+    scene.cubes.push_back(cube);
+  }
+
+  for (int l = 0; l < spec.lights; ++l) {
+    Light light;
+    light.position = Vec3{(uniform(rng) - 0.5) * extent * 1.5,
+                          (uniform(rng) - 0.5) * extent * 1.5,
+                          (uniform(rng) - 0.5) * extent * 1.5};
+    light.color = Vec3{0.5 + 0.5 * uniform(rng), 0.5 + 0.5 * uniform(rng),
+                       0.5 + 0.5 * uniform(rng)};
+    light.intensity = spec.lightRange > 0 ? 1.0 : 1.0 / spec.lights;
+    light.range = spec.lightRange;
+    scene.lights.push_back(light);
+  }
+
+  Camera &camera = scene.camera;
+  camera.up = Vec3{0, 1, 0};
+  camera.fovY = 60.0;
+  camera.aspect = static_cast<double>(spec.width) / spec.height;
+  camera.farPlane = extent * 8.0;
+  camera.nearPlane = spec.camera == CameraMode::Near ? 0.1 : 1.0;
+  return scene;
+}
+
+// Camera do frame `frame` de `frames` (a cena gira spec.orbitDegrees)
+static void placeCamera(Scene &scene, const SceneSpec &spec, int frame,
+                        int frames) {
+  Camera &camera = scene.camera;
+  double extent = sceneExtent(spec);
+  double angle =
+      spec.orbitDegrees * M_PI / 180.0 * frame / std::max(1, frames);
+  switch (spec.camera) {
+  case CameraMode::Orbit:
+    camera.eye = Vec3{std::sin(angle) * extent * 1.2, extent * 0.4,
+                      std::cos(angle) * extent * 1.2};
+    camera.center = Vec3{0, 0, 0};
+    break;
+  case CameraMode::Overdraw:
+    camera.eye = Vec3{std::sin(angle) * 0.5, std::cos(angle) * 0.5, 6.0};
+    camera.center = Vec3{0, 0, -extent * 4.0};
+    break;
+  case CameraMode::Near:
+    camera.eye = Vec3{std::sin(angle) * extent * 0.1, 0.0,
+                      std::cos(angle) * extent * 0.1};
+    camera.center =
+        camera.eye + Vec3{std::sin(angle + 1.0), 0.1, std::cos(angle + 1.0)};
+    break;
+  }
+}
+
+// ============ MEDICAO ============
+
+struct BenchResult {
+  SceneSpec spec;
+  int frames{0};
+  double minMs{0}, meanMs{0}, p50Ms{0}, p90Ms{0}, p99Ms{0}, maxMs{0};
+  // Medias por frame
+  double trianglesSubmitted{0}, trianglesRasterized{0};
+  double fragmentsShaded{0}, depthPasses{0};
+  double heapAllocations{0}; // new/malloc do C++ durante o frame
+  double arenaBytes{0};      // usados da FrameArena do Renderer
+  double shadowFaces{0};     // faces de shadow map refeitas
+  // Cache temporal: pixels com o difuso do frame anterior e pixels que
+  // diferem em mais de 2 niveis do frame normal (render a parte, fora do
+  // tempo medido)
+  double temporalReused{0}, temporalDiffPixels{0};
+  // Vazao (sobre o tempo medio)
+  double trianglesPerSec{0}, mpixelsPerSec{0}, fragmentsPerSec{0};
+  // Medias das etapas (so com RENDER_ENABLE_STATS)
+  double cullMs{0}, transformMs{0}, binMs{0}, rasterMs{0}, shadeMs{0};
+  double overdraw{0};
+};
+
+// Percentil pelo metodo nearest-rank (amostras ordenadas)
+static double percentile(const std::vector<double> &sorted, double p) {
+  size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+  return sorted[std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+static BenchResult runScene(const SceneSpec &spec, int frames, int warmup,
+                            int threads, unsigned seed) {
+  Scene scene = buildScene(spec, seed);
+  Framebuffer fb(spec.width, spec.height);
+  Renderer renderer;
+  RenderOptions options;
+  options.usePhong = spec.phong;
+  options.deferred = spec.deferred;
+  options.occlusionCulling = spec.occlusion;
+  options.msaaSamples = spec.msaa;
+  options.shadows = spec.shadows;
+  options.temporal = spec.temporal;
+  options.numThreads = threads;
+
+  // Com o cache temporal, a mesma camera no modo normal para comparar
+  Framebuffer reference(spec.width, spec.height);
+  Renderer referenceRenderer;
+  RenderOptions referenceOptions = options;
+  referenceOptions.temporal = false;
+
+  // Aquecimento espalhado pelo caminho da camera: os buffers do Renderer
+  // ja chegam ao tamanho de pico antes da medicao
+  for (int f = 0; f < warmup; ++f) {
+    placeCamera(scene, spec, warmup > 1 ? f * (frames - 1) / (warmup - 1) : 0,
+                frames);
+    fb.clear(0xff000000);
+    renderer.render(scene, fb, options);
+  }
+
+  BenchResult result;
+  result.spec = spec;
+  result.frames = frames;
+  std::vector<double> times;
+  times.reserve(frames);
+  long long rasterized = 0, shaded = 0, passes = 0, arenaBytes = 0;
+  long long allocations = 0, shadowFaces = 0, reused = 0, differing = 0;
+  for (int f = 0; f < frames; ++f) {
+    placeCamera(scene, spec, f, frames);
+    long long allocsBefore = heapAllocations.load();
+    auto start = std::chrono::steady_clock::now();
+    fb.clear(0xff000000);
+    renderer.render(scene, fb, options);
+    auto end = std::chrono::steady_clock::now();
+    allocations += heapAllocations.load() - allocsBefore;
+    times.push_back(
+        std::chrono::duration<double, std::milli>(end - start).count());
+
+    const FrameCounters &counters = renderer.frameCounters();
+    rasterized += counters.trianglesRasterized;
+    shaded += counters.fragmentsShaded;
+    passes += counters.depthPasses;
+    arenaBytes += counters.arenaBytes;
+    shadowFaces += counters.shadowFacesRendered;
+    reused += counters.temporalReused;
+    if (spec.temporal) {
+      reference.clear(0xff000000);
+      referenceRenderer.render(scene, reference, referenceOptions);
+      for (size_t p = 0; p < static_cast<size_t>(spec.width) * spec.height;
+           ++p) {
+        uint32_t a = fb.color[p], b = reference.color[p];
+        for (int shift = 0; shift < 24; shift += 8)
+          if (std::abs(static_cast<int>((a >> shift) & 0xff) -
+                       static_cast<int>((b >> shift) & 0xff)) > 2) {
+            ++differing;
+            break;
+          }
+      }
+    }
+
+    const RenderStats &stats = renderer.renderStats();
+    result.cullMs += stats.cullMs / frames;
+    result.transformMs += stats.transformMs / frames;
+    result.binMs += stats.binMs / frames;
+    result.rasterMs += stats.rasterMs / frames;
+    result.shadeMs += stats.shadeMs / frames;
+    result.overdraw += stats.overdraw / frames;
+  }
+
+  double total = 0;
+  for (double t : times)
+    total += t;
+  std::sort(times.begin(), times.end());
+  result.minMs = times.front();
+  result.maxMs = times.back();
+  result.meanMs = total / frames;
+  result.p50Ms = percentile(times, 50);
+  result.p90Ms = percentile(times, 90);
+  result.p99Ms = percentile(times, 99);
+
+  result.trianglesSubmitted = 12.0 * spec.cubes;
+  result.trianglesRasterized = static_cast<double>(rasterized) / frames;
+  result.fragmentsShaded = static_cast<double>(shaded) / frames;
+  result.depthPasses = static_cast<double>(passes) / frames;
+  result.heapAllocations = static_cast<double>(allocations) / frames;
+  result.arenaBytes = static_cast<double>(arenaBytes) / frames;
+  result.shadowFaces = static_cast<double>(shadowFaces) / frames;
+  result.temporalReused = static_cast<double>(reused) / frames;
+  result.temporalDiffPixels = static_cast<double>(differing) / frames;
+
+  double seconds = result.meanMs / 1000.0;
+  result.trianglesPerSec = result.trianglesSubmitted / seconds;
+  result.mpixelsPerSec =
+      static_cast<double>(spec.width) * spec.height / seconds / 1e6;
+  result.fragmentsPerSec = result.fragmentsShaded / seconds;
+  return result;
+}
+
+// ============ SAIDA ============
+
+static void printText(FILE *out, const std::vector<BenchResult> &results) {
+  std::fprintf(out, "%-26s %9s %5s %6s %8s %8s %8s %8s %9s %8s %9s %7s\n",
+               "cena", "res", "luzes", "cubos", "p50 ms", "p90 ms", "p99 ms",
+               "media ms", "Mtri/s", "Mpix/s", "Mfrag/s", "aloc/f");
+  for (const BenchResult &r : results) {
+    char res[32];
+    std::snprintf(res, sizeof(res), "%dx%d", r.spec.width, r.spec.height);
+    std::fprintf(out,
+                 "%-26s %9s %5d %6d %8.2f %8.2f %8.2f %8.2f %9.2f %8.1f "
+                 "%9.1f %7.1f\n",
+                 r.spec.name.c_str(), res, r.spec.lights, r.spec.cubes,
+                 r.p50Ms, r.p90Ms, r.p99Ms, r.meanMs, r.trianglesPerSec / 1e6,
+                 r.mpixelsPerSec, r.fragmentsPerSec / 1e6, r.heapAllocations);
+  }
+}
+
+static const char *CSV_HEADER =
+    "scene,width,height,cubes,lights,light_range,shading,camera,deferred,"
+    "occlusion,msaa,shadows,temporal,orbit_degrees,frames,min_ms,mean_ms,p50_ms,p90_ms,p99_ms,max_ms,"
+    "triangles_submitted,triangles_rasterized,depth_passes,"
+    "fragments_shaded,heap_allocations,arena_bytes,shadow_faces,"
+    "temporal_reused,temporal_diff_pixels,triangles_per_s,"
+    "mpixels_per_s,fragments_per_s\n";
+
+static void printCsv(FILE *out, const std::vector<BenchResult> &results) {
+  std::fputs(CSV_HEADER, out);
+  for (const BenchResult &r : results) {
+    const SceneSpec &s = r.spec;
+    std::fprintf(out,
+                 "%s,%d,%d,%d,%d,%g,%s,%s,%d,%d,%d,%d,%d,%g,%d,%.4f,%.4f,"
+                 "%.4f,%.4f,%.4f,%.4f,%.0f,%.1f,%.1f,%.1f,%.2f,%.0f,%.2f,"
+                 "%.1f,%.1f,%.1f,%.3f,%.1f\n",
+                 s.name.c_str(), s.width, s.height, s.cubes, s.lights,
+                 s.lightRange, s.phong ? "phong" : "flat",
+                 cameraName(s.camera), s.deferred, s.occlusion, s.msaa,
+                 s.shadows, s.temporal, s.orbitDegrees, r.frames,
+                 r.minMs, r.meanMs, r.p50Ms, r.p90Ms, r.p99Ms, r.maxMs,
+                 r.trianglesSubmitted, r.trianglesRasterized, r.depthPasses,
+                 r.fragmentsShaded, r.heapAllocations, r.arenaBytes,
+                 r.shadowFaces, r.temporalReused, r.temporalDiffPixels,
+                 r.trianglesPerSec, r.mpixelsPerSec, r.fragmentsPerSec);
+  }
+}
+
+static void printJson(FILE *out, const std::vector<BenchResult> &results,
+                      int threads, unsigned seed) {
+  std::fprintf(out, "{\n  \"threads\": %d,\n  \"seed\": %u,\n", threads, seed);
+  std::fprintf(out, "  \"phong_kernel\": \"%s\",\n", phongPacketKernelName());
+  std::fprintf(out, "  \"depth\": \"%s\",\n",
+               sizeof(DepthValue) == sizeof(float) ? "float" : "double");
+  std::fprintf(out, "  \"scenes\": [");
+  for (size_t i = 0; i < results.size(); ++i) {
+    const BenchResult &r = results[i];
+    const SceneSpec &s = r.spec;
+    std::fprintf(out, "%s\n    {", i ? "," : "");
+    std::fprintf(out,
+                 "\"scene\": \"%s\", \"width\": %d, \"height\": %d, "
+                 "\"cubes\": %d, \"lights\": %d, \"light_range\": %g, "
+                 "\"shading\": \"%s\", \"camera\": \"%s\", "
+                 "\"deferred\": %s, \"occlusion\": %s, \"msaa\": %d, "
+                 "\"shadows\": %s, \"temporal\": %s, "
+                 "\"orbit_degrees\": %g, \"frames\": %d,\n",
+                 s.name.c_str(), s.width, s.height, s.cubes, s.lights,
+                 s.lightRange, s.phong ? "phong" : "flat",
+                 cameraName(s.camera), s.deferred ? "true" : "false",
+                 s.occlusion ? "true" : "false", s.msaa,
+                 s.shadows ? "true" : "false", s.temporal ? "true" : "false",
+                 s.orbitDegrees, r.frames);
+    std::fprintf(out,
+                 "     \"latency_ms\": {\"min\": %.4f, \"mean\": %.4f, "
+                 "\"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, "
+                 "\"max\": %.4f},\n",
+                 r.minMs, r.meanMs, r.p50Ms, r.p90Ms, r.p99Ms, r.maxMs);
+    std::fprintf(out,
+                 "     \"per_frame\": {\"triangles_submitted\": %.0f, "
+                 "\"triangles_rasterized\": %.1f, \"depth_passes\": %.1f, "
+                 "\"fragments_shaded\": %.1f, \"heap_allocations\": %.2f, "
+                 "\"arena_bytes\": %.0f, \"shadow_faces\": %.2f, "
+                 "\"temporal_reused\": %.1f, "
+                 "\"temporal_diff_pixels\": %.1f},\n",
+                 r.trianglesSubmitted, r.trianglesRasterized, r.depthPasses,
+                 r.fragmentsShaded, r.heapAllocations, r.arenaBytes,
+                 r.shadowFaces, r.temporalReused, r.temporalDiffPixels);
+    std::fprintf(out,
+                 "     \"throughput\": {\"triangles_per_s\": %.1f, "
+                 "\"mpixels_per_s\": %.3f, \"fragments_per_s\": %.1f}",
+                 r.trianglesPerSec, r.mpixelsPerSec, r.fragmentsPerSec);
+    if (RENDER_STATS_ENABLED)
+      std::fprintf(out,
+                   ",\n     \"stages_ms\": {\"cull\": %.4f, "
+                   "\"transform\": %.4f, \"bin\": %.4f, \"raster\": %.4f, "
+                   "\"shade\": %.4f}, \"overdraw\": %.3f",
+                   r.cullMs, r.transformMs, r.binMs, r.rasterMs, r.shadeMs,
+                   r.overdraw);
+    std::fprintf(out, "}");
+  }
+  std::fprintf(out, "\n  ]\n}\n");
+}
+
+// ============ LINHA DE COMANDO ============
+
+static void usage() {
+  std::fprintf(
+      stderr,
+      "uso: render_bench [opcoes]\n"
+      "  sem opcoes de cena roda a suite padrao\n"
+      "  --scene NOME         roda so a cena NOME da suite (--list mostra)\n"
+      "  --cubes N            cena propria com N cubos\n"
+      "  --lights N           numero de luzes (padrao 2)\n"
+      "  --light-range R      alcance das luzes (0 = infinito)\n"
+      "  --size LxA           resolucao (padrao 1280x720)\n"
+      "  --shading flat|phong\n"
+      "  --camera orbit|overdraw|near\n"
+      "  --deferred           modo deferred\n"
+      "  --occlusion          occlusion culling\n"
+      "  --msaa N             amostras por pixel: 1, 2, 4 ou 8\n"
+      "  --shadows            cube shadow maps nas luzes\n"
+      "  --temporal           cache temporal (com --deferred); compara cada\n"
+      "                       frame com o modo normal fora do tempo medido\n"
+      "  --orbit GRAUS        arco da camera nos frames medidos (padrao 360)\n"
+      "  --frames N           frames medidos (padrao 30)\n"
+      "  --warmup N           frames descartados antes (padrao 3)\n"
+      "  --threads N          threads dos tiles (0 = todas)\n"
+      "  --seed S             semente das cenas (padrao 1)\n"
+      "  --format text|json|csv\n"
+      "  --output ARQUIVO     escreve o resultado no arquivo\n");
+}
+
+int main(int argc, char **argv) {
+  SceneSpec custom;
+  custom.name = "custom";
+  bool useCustom = false;
+  std::string only, format = "text", output;
+  int frames = 30, warmup = 3, threads = 0;
+  unsigned seed = 1;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    auto value = [&]() -> const char * {
+      if (i + 1 >= argc) {
+        std::fprintf(stderr, "%s precisa de um valor\n", arg.c_str());
+        std::exit(2);
+      }
+      return argv[++i];
+    };
+    if (arg == "--scene")
+      only = value();
+    else if (arg == "--list") {
+      for (const SceneSpec &s : defaultSuite())
+        std::printf("%s\n", s.name.c_str());
+      return 0;
+    } else if (arg == "--cubes") {
+      custom.cubes = std::atoi(value());
+      useCustom = true;
+    } else if (arg == "--lights") {
+      custom.lights = std::atoi(value());
+      useCustom = true;
+    } else if (arg == "--light-range") {
+      custom.lightRange = std::atof(value());
+      useCustom = true;
+    } else if (arg == "--size") {
+      if (std::sscanf(value(), "%dx%d", &custom.width, &custom.height) != 2) {
+        usage();
+        return 2;
+      }
+      useCustom = true;
+    } else if (arg == "--shading") {
+      std::string s = value();
+      if (s != "flat" && s != "phong") {
+        usage();
+        return 2;
+      }
+      custom.phong = s == "phong";
+      useCustom = true;
+    } else if (arg == "--camera") {
+      if (!parseCamera(value(), custom.camera)) {
+        usage();
+        return 2;
+      }
+      useCustom = true;
+    } else if (arg == "--deferred") {
+      custom.deferred = true;
+      useCustom = true;
+    } else if (arg == "--occlusion") {
+      custom.occlusion = true;
+      useCustom = true;
+    } else if (arg == "--msaa") {
+      custom.msaa = std::atoi(value());
+      if (msaaSampleCount(custom.msaa) != custom.msaa) {
+        usage();
+        return 2;
+      }
+      useCustom = true;
+    } else if (arg == "--shadows") {
+      custom.shadows = true;
+      useCustom = true;
+    } else if (arg == "--temporal") {
+      custom.temporal = true;
+      useCustom = true;
+    } else if (arg == "--orbit") {
+      custom.orbitDegrees = std::atof(value());
+      useCustom = true;
+    } else if (arg == "--frames")
+      frames = std::atoi(value());
+    else if (arg == "--warmup")
+      warmup = std::atoi(value());
+    else if (arg == "--threads")
+      threads = std::atoi(value());
+    else if (arg == "--seed")
+      seed = static_cast<unsigned>(std::strtoul(value(), nullptr, 10));
+    else if (arg == "--format")
+      format = value();
+    else if (arg == "--output")
+      output = value();
+    else {
+      usage();
+      return arg == "--help" || arg == "-h" ? 0 : 2;
+    }
+  }
+  if (frames < 1 || warmup < 0 || custom.cubes < 0 || custom.lights < 0 ||
+      custom.width <= 0 || custom.height <= 0 ||
+      (format != "text" && format != "json" && format != "csv")) {
+    usage();
+    return 2;
+  }
+
+  std::vector<SceneSpec> scenes;
+  if (useCustom) {
+    scenes.push_back(custom);
+  } else {
+    for (const SceneSpec &s : defaultSuite())
+      if (only.empty() || s.name == only)
+        scenes.push_back(s);
+    if (scenes.empty()) {
+      std::fprintf(stderr, "cena desconhecida: %s\n", only.c_str());
+      return 2;
+    }
+  }
+
+  std::vector<BenchResult> results;
+  for (const SceneSpec &spec : scenes) {
+    if (format == "text")
+      std::fprintf(stderr, "%s...\n", spec.name.c_str());
+    results.push_back(runScene(spec, frames, warmup, threads, seed));
+  }
+
+  FILE *out = stdout;
+  if (!output.empty()) {
+    out = std::fopen(output.c_str(), "w");
+    if (!out) {
+      std::perror(output.c_str());
+      return 1;
+    }
+  }
+  int usedThreads = threads > 0 ? std::min(threads, ThreadPool::global().size())
+                                : ThreadPool::global().size();
+  if (format == "json")
+    printJson(out, results, usedThreads, seed);
+  else if (format == "csv")
+    printCsv(out, results);
+  else
+    printText(out, results);
+  if (out != stdout)
+    std::fclose(out);
+  return 0;
+}
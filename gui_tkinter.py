@@ -26,6 +26,25 @@ lib.render_api.argtypes = [
     ctypes.POINTER(ctypes.c_uint32)  # out_pixels
 ]
 
+# Contexto retido: cena e buffers ficam na biblioteca entre frames
+lib.render_context_create.restype = ctypes.c_void_p
+lib.render_context_create.argtypes = []
+lib.render_context_destroy.argtypes = [ctypes.c_void_p]
+lib.render_context_set_camera.argtypes = [ctypes.c_void_p] + [ctypes.c_double] * 9
+lib.render_context_set_cube_count.argtypes = [ctypes.c_void_p, ctypes.c_int]
+lib.render_context_set_cube.argtypes = [ctypes.c_void_p, ctypes.c_int,
+                                        ctypes.POINTER(ctypes.c_double)]
+lib.render_context_set_light_count.argtypes = [ctypes.c_void_p, ctypes.c_int]
+lib.render_context_set_light.argtypes = [ctypes.c_void_p, ctypes.c_int,
+                                         ctypes.POINTER(ctypes.c_double)]
+lib.render_context_set_light_range.argtypes = [ctypes.c_void_p, ctypes.c_int,
+                                               ctypes.c_double]
+lib.render_context_set_incremental.argtypes = [ctypes.c_void_p, ctypes.c_int]
+lib.render_context_render.argtypes = [
+    ctypes.c_void_p, ctypes.c_int, ctypes.c_int, ctypes.c_int,
+    ctypes.POINTER(ctypes.c_uint32)
+]
+
 class RenderApp:
     def __init__(self, root):
         self.root = root
@@ -57,10 +76,18 @@ class RenderApp:
         ]
         
         self.lights = [
-            {'pos': [5, 5, 5], 'color': [1, 1, 1], 'intensity': 1.0},
-            {'pos': [-3, 2, 3], 'color': [0.5, 0.5, 0.8], 'intensity': 0.5}
+            {'pos': [5, 5, 5], 'color': [1, 1, 1], 'intensity': 1.0,
+             'range': 0.0},
+            {'pos': [-3, 2, 3], 'color': [0.5, 0.5, 0.8], 'intensity': 0.5,
+             'range': 0.0}
         ]
         
+        # Contexto de render e buffer de saída alocados uma única vez
+        self.ctx = lib.render_context_create()
+        # Mover um cubo redesenha so a area dele (self.pixels e reaproveitado)
+        lib.render_context_set_incremental(self.ctx, 1)
+        self.pixels = np.zeros((self.height, self.width), dtype=np.uint32)
+        
         self.setup_ui()
         self.render()
     
@@ -167,39 +194,32 @@ class RenderApp:
         self.render()
     
     def render(self, *args):
-        # Preparar dados
-        cubes_data = []
-        for cube in self.cubes:
-            cubes_data.extend(cube['pos'])
-            cubes_data.extend(cube['rot'])
-            cubes_data.append(cube['scale'])
-            cubes_data.extend(cube['color'])
-            cubes_data.extend([cube['ka'], cube['kd'], cube['ks']])
-        
-        lights_data = []
-        for light in self.lights:
-            lights_data.extend(light['pos'])
-            lights_data.extend(light['color'])
-            lights_data.append(light['intensity'])
-        
-        # Arrays ctypes
-        cubes_arr = (ctypes.c_double * len(cubes_data))(*cubes_data)
-        lights_arr = (ctypes.c_double * len(lights_data))(*lights_data)
-        pixels = (ctypes.c_uint32 * (self.width * self.height))()
-        
-        # Chamar C++
-        lib.render_api(
-            self.width, self.height,
-            *self.camera['eye'], *self.camera['center'],
-            self.camera['fov'], self.camera['near'], self.camera['far'],
-            len(self.cubes), cubes_arr,
-            len(self.lights), lights_arr,
-            int(self.use_phong.get()),
-            pixels
-        )
+        ctx = self.ctx
+        
+        # Atualizar cena no contexto
+        lib.render_context_set_camera(
+            ctx, *self.camera['eye'], *self.camera['center'],
+            self.camera['fov'], self.camera['near'], self.camera['far'])
+        
+        lib.render_context_set_cube_count(ctx, len(self.cubes))
+        for i, cube in enumerate(self.cubes):
+            data = (cube['pos'] + cube['rot'] + [cube['scale']] +
+                    cube['color'] + [cube['ka'], cube['kd'], cube['ks']])
+            lib.render_context_set_cube(ctx, i, (ctypes.c_double * 13)(*data))
+        
+        lib.render_context_set_light_count(ctx, len(self.lights))
+        for i, light in enumerate(self.lights):
+            data = light['pos'] + light['color'] + [light['intensity']]
+            lib.render_context_set_light(ctx, i, (ctypes.c_double * 7)(*data))
+            lib.render_context_set_light_range(ctx, i, light.get('range', 0.0))
+        
+        # Renderizar direto no array numpy
+        lib.render_context_render(
+            ctx, self.width, self.height, int(self.use_phong.get()),
+            self.pixels.ctypes.data_as(ctypes.POINTER(ctypes.c_uint32)))
         
         # Converter para imagem
-        img_data = np.array(pixels, dtype=np.uint32).reshape((self.height, self.width))
+        img_data = self.pixels
         img_rgb = np.zeros((self.height, self.width, 3), dtype=np.uint8)
         img_rgb[:,:,0] = (img_data >> 16) & 0xFF  # R
         img_rgb[:,:,1] = (img_data >> 8) & 0xFF   # G
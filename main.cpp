@@ -1,7 +1,66 @@
+#include "render_api.h"
 #include "src/core/Scene.h"
-#include "src/pipeline/Rasterizer.h"
+#include "src/pipeline/AsyncRenderer.h"
+#include "src/pipeline/BatchRenderer.h"
+#include "src/pipeline/RenderContext.h"
 #include <cstdint>
-#include <cstring>
+#include <memory>
+#include <string>
+
+// Referencia da API C a uma malha (os contextos copiam o shared_ptr)
+struct render_mesh {
+  std::shared_ptr<const Mesh> mesh;
+};
+
+// ============ CONVERSAO DOS ARRAYS ============
+
+// [pos.x, pos.y, pos.z, rot.x, rot.y, rot.z, scale, color.r, color.g,
+//  color.b, ka, kd, ks]
+static Cube cubeFromData(const double *data) {
+  Cube cube;
+  cube.position = Vec3{data[0], data[1], data[2]};
+  cube.rotation = Vec3{data[3], data[4], data[5]};
+  cube.scale = data[6];
+  cube.material.color = Vec3{data[7], data[8], data[9]};
+  cube.material.ka = data[10];
+  cube.material.kd = data[11];
+  cube.material.ks = data[12];
+  cube.material.shininess = 32.0;
+  return cube;
+}
+
+// Mesmo array do cubo
+static MeshInstance meshInstanceFromData(const render_mesh_t *mesh,
+                                         const double *data) {
+  Cube cube = cubeFromData(data);
+  MeshInstance instance;
+  instance.mesh = mesh ? mesh->mesh : nullptr;
+  instance.position = cube.position;
+  instance.rotation = cube.rotation;
+  instance.scale = cube.scale;
+  instance.material = cube.material;
+  return instance;
+}
+
+// [pos.x, pos.y, pos.z, color.r, color.g, color.b, intensity]
+static Light lightFromData(const double *data) {
+  Light light;
+  light.position = Vec3{data[0], data[1], data[2]};
+  light.color = Vec3{data[3], data[4], data[5]};
+  light.intensity = data[6];
+  return light;
+}
+
+static void setCamera(Camera &camera, double eye_x, double eye_y, double eye_z,
+                      double center_x, double center_y, double center_z,
+                      double fov, double near_plane, double far_plane) {
+  camera.eye = Vec3{eye_x, eye_y, eye_z};
+  camera.center = Vec3{center_x, center_y, center_z};
+  camera.up = Vec3{0, 1, 0};
+  camera.fovY = fov;
+  camera.nearPlane = near_plane;
+  camera.farPlane = far_plane;
+}
 
 // Função que Python chamará via ctypes
 extern "C" {
@@ -10,11 +69,11 @@ void render_api(
     // Câmera
     double eye_x, double eye_y, double eye_z, double center_x, double center_y,
     double center_z, double fov, double near_plane, double far_plane,
-    // Cubos (máximo 10 cubos, 13 params cada)
+    // Cubos (13 params cada)
     int num_cubes,
     double *cubes_data, // [pos.x, pos.y, pos.z, rot.x, rot.y, rot.z, scale,
                         // color.r, color.g, color.b, ka, kd, ks]
-    // Luzes (máximo 5 luzes, 7 params cada)
+    // Luzes (7 params cada)
     int num_lights,
     double *lights_data, // [pos.x, pos.y, pos.z, color.r, color.g, color.b,
                          // intensity]
@@ -22,49 +81,469 @@ void render_api(
     int use_phong,
     // Saída
     uint32_t *out_pixels) {
-  // Criar cena
-  Scene scene;
+  // Contexto por thread: vetores da cena, z-buffer e buffers do pipeline
+  // sao reaproveitados entre chamadas
+  thread_local RenderContext ctx;
+  Scene &scene = ctx.scene;
 
   // Configurar câmera
-  scene.camera.eye = Vec3{eye_x, eye_y, eye_z};
-  scene.camera.center = Vec3{center_x, center_y, center_z};
-  scene.camera.up = Vec3{0, 1, 0};
-  scene.camera.fovY = fov;
-  scene.camera.aspect = (double)width / height;
-  scene.camera.nearPlane = near_plane;
-  scene.camera.farPlane = far_plane;
-
-  // Adicionar cubos
-  for (int i = 0; i < num_cubes; ++i) {
-    double *data = &cubes_data[i * 13];
-    Cube cube;
-    cube.position = Vec3{data[0], data[1], data[2]};
-    cube.rotation = Vec3{data[3], data[4], data[5]};
-    cube.scale = data[6];
-    cube.material.color = Vec3{data[7], data[8], data[9]};
-    cube.material.ka = data[10];
-    cube.material.kd = data[11];
-    cube.material.ks = data[12];
-    cube.material.shininess = 32.0;
-    scene.cubes.push_back(cube);
+  setCamera(scene.camera, eye_x, eye_y, eye_z, center_x, center_y, center_z,
+            fov, near_plane, far_plane);
+
+  // Cubos e luzes
+  scene.cubes.resize(num_cubes);
+  for (int i = 0; i < num_cubes; ++i)
+    scene.cubes[i] = cubeFromData(&cubes_data[i * 13]);
+  scene.lights.resize(num_lights);
+  for (int i = 0; i < num_lights; ++i)
+    scene.lights[i] = lightFromData(&lights_data[i * 7]);
+
+  // Renderizar direto na saída
+  ctx.options.usePhong = use_phong != 0;
+  ctx.render(width, height, out_pixels);
+}
+
+// ============ CONTEXTO RETIDO ============
+
+render_context_t *render_context_create(void) { return new RenderContext(); }
+
+void render_context_destroy(render_context_t *ctx) { delete ctx; }
+
+void render_context_set_camera(render_context_t *ctx, double eye_x,
+                               double eye_y, double eye_z, double center_x,
+                               double center_y, double center_z, double fov,
+                               double near_plane, double far_plane) {
+  if (!ctx)
+    return;
+  setCamera(ctx->scene.camera, eye_x, eye_y, eye_z, center_x, center_y,
+            center_z, fov, near_plane, far_plane);
+}
+
+int render_context_set_cube_count(render_context_t *ctx, int count) {
+  if (!ctx || count < 0)
+    return -1;
+  ctx->scene.cubes.resize(count);
+  return 0;
+}
+
+int render_context_set_cube(render_context_t *ctx, int index,
+                            const double *cube_data) {
+  if (!ctx || index < 0 || index >= (int)ctx->scene.cubes.size() ||
+      !cube_data)
+    return -1;
+  ctx->scene.cubes[index] = cubeFromData(cube_data);
+  // Anexado a um no: a transformacao volta a ser a do grafo no render
+  ctx->graph.cubeReplaced(index);
+  return 0;
+}
+
+int render_context_set_mesh_count(render_context_t *ctx, int count) {
+  if (!ctx || count < 0)
+    return -1;
+  ctx->scene.meshes.resize(count);
+  return 0;
+}
+
+int render_context_set_mesh(render_context_t *ctx, int index,
+                            const render_mesh_t *mesh,
+                            const double *instance_data) {
+  if (!ctx || index < 0 || index >= (int)ctx->scene.meshes.size() ||
+      !instance_data)
+    return -1;
+  ctx->scene.meshes[index] = meshInstanceFromData(mesh, instance_data);
+  ctx->graph.meshReplaced(index);
+  return 0;
+}
+
+int render_context_set_light_count(render_context_t *ctx, int count) {
+  if (!ctx || count < 0)
+    return -1;
+  ctx->scene.lights.resize(count);
+  return 0;
+}
+
+int render_context_set_light(render_context_t *ctx, int index,
+                             const double *light_data) {
+  if (!ctx || index < 0 || index >= (int)ctx->scene.lights.size() ||
+      !light_data)
+    return -1;
+  ctx->scene.lights[index] = lightFromData(light_data);
+  return 0;
+}
+
+int render_context_set_light_range(render_context_t *ctx, int index,
+                                   double range) {
+  if (!ctx || index < 0 || index >= (int)ctx->scene.lights.size() ||
+      range < 0.0)
+    return -1;
+  ctx->scene.lights[index].range = range;
+  return 0;
+}
+
+int render_context_set_light_shadow(render_context_t *ctx, int index,
+                                    int enabled) {
+  if (!ctx || index < 0 || index >= (int)ctx->scene.lights.size())
+    return -1;
+  ctx->scene.lights[index].castShadows = enabled != 0;
+  return 0;
+}
+
+// ============ GRAFO DE CENA ============
+
+static bool validNode(const render_context_t *ctx, int node) {
+  return node >= 0 && node < ctx->graph.nodeCount();
+}
+
+static bool validParent(const render_context_t *ctx, int parent) {
+  return parent == SceneGraph::NO_PARENT || validNode(ctx, parent);
+}
+
+int render_context_create_node(render_context_t *ctx, int parent) {
+  if (!ctx || !validParent(ctx, parent))
+    return -1;
+  return ctx->graph.addNode(parent);
+}
+
+int render_context_create_cube_node(render_context_t *ctx, int cube_index,
+                                    int parent) {
+  if (!ctx || cube_index < 0 ||
+      cube_index >= (int)ctx->scene.cubes.size() || !validParent(ctx, parent) ||
+      ctx->graph.cubeNode(cube_index) >= 0 ||
+      !(ctx->scene.cubes[cube_index].scale > 0.0))
+    return -1;
+  return ctx->graph.attachCube(cube_index, parent);
+}
+
+int render_context_create_mesh_node(render_context_t *ctx, int mesh_index,
+                                    int parent) {
+  if (!ctx || mesh_index < 0 ||
+      mesh_index >= (int)ctx->scene.meshes.size() ||
+      !validParent(ctx, parent) || ctx->graph.meshNode(mesh_index) >= 0 ||
+      !(ctx->scene.meshes[mesh_index].scale > 0.0))
+    return -1;
+  return ctx->graph.attachMesh(mesh_index, parent);
+}
+
+int render_context_set_node_parent(render_context_t *ctx, int node,
+                                   int parent) {
+  if (!ctx || !validNode(ctx, node) || !validParent(ctx, parent))
+    return -1;
+  // O novo pai nao pode ser o proprio no nem um descendente
+  for (int p = parent; p != SceneGraph::NO_PARENT; p = ctx->graph.parent(p))
+    if (p == node)
+      return -1;
+  ctx->graph.setParent(node, parent);
+  return 0;
+}
+
+int render_context_set_node_transform(render_context_t *ctx, int node,
+                                      const double *trs) {
+  if (!ctx || !validNode(ctx, node) || !trs || !(trs[6] > 0.0))
+    return -1;
+  ctx->graph.setLocal(node, Vec3{trs[0], trs[1], trs[2]},
+                      Vec3{trs[3], trs[4], trs[5]}, trs[6]);
+  return 0;
+}
+
+int render_context_render(render_context_t *ctx, int width, int height,
+                          int use_phong, uint32_t *out_pixels) {
+  if (!ctx || width <= 0 || height <= 0 || !out_pixels)
+    return -1;
+  ctx->options.usePhong = use_phong != 0;
+  ctx->render(width, height, out_pixels);
+  return 0;
+}
+
+int render_context_render_views(render_context_t *ctx, int num_views,
+                                const double *views_data, int width,
+                                int height, int use_phong,
+                                uint32_t *const *out_pixels) {
+  if (!ctx || num_views < 0 || (num_views > 0 && (!views_data || !out_pixels)) ||
+      width <= 0 || height <= 0)
+    return -1;
+  std::vector<Camera> cameras(num_views);
+  for (int v = 0; v < num_views; ++v) {
+    const double *d = &views_data[v * 12];
+    if (!out_pixels[v])
+      return -1;
+    setCamera(cameras[v], d[0], d[1], d[2], d[3], d[4], d[5], d[9], d[10],
+              d[11]);
+    cameras[v].up = Vec3{d[6], d[7], d[8]};
+  }
+  ctx->options.usePhong = use_phong != 0;
+  ctx->renderViews(cameras, width, height, out_pixels);
+  return 0;
+}
+
+int render_context_set_occlusion_culling(render_context_t *ctx, int enabled) {
+  if (!ctx)
+    return -1;
+  ctx->options.occlusionCulling = enabled != 0;
+  return 0;
+}
+
+int render_context_set_deferred(render_context_t *ctx, int enabled) {
+  if (!ctx)
+    return -1;
+  ctx->options.deferred = enabled != 0;
+  return 0;
+}
+
+int render_context_set_msaa(render_context_t *ctx, int samples) {
+  if (!ctx || msaaSampleCount(samples) != samples)
+    return -1;
+  ctx->options.msaaSamples = samples;
+  return 0;
+}
+
+int render_context_set_shadows(render_context_t *ctx, int enabled,
+                               int map_size, int pcf_radius) {
+  if (!ctx || map_size < 8 || map_size > 8192 || pcf_radius < 0 ||
+      pcf_radius > 8)
+    return -1;
+  ctx->options.shadows = enabled != 0;
+  ctx->options.shadowMapSize = map_size;
+  ctx->options.shadowPcf = pcf_radius;
+  return 0;
+}
+
+int render_context_set_frame_budget(render_context_t *ctx, double target_ms,
+                                    double min_scale) {
+  if (!ctx || !(target_ms >= 0.0) || !(min_scale > 0.0 && min_scale <= 1.0))
+    return -1;
+  ctx->resolution.setBudget(target_ms, min_scale);
+  return 0;
+}
+
+double render_context_get_render_scale(const render_context_t *ctx) {
+  return ctx ? ctx->lastRenderScale() : -1.0;
+}
+
+int render_context_set_temporal(render_context_t *ctx, int enabled) {
+  if (!ctx)
+    return -1;
+  ctx->options.temporal = enabled != 0;
+  return 0;
+}
+
+int render_context_set_incremental(render_context_t *ctx, int enabled) {
+  if (!ctx)
+    return -1;
+  ctx->incremental = enabled != 0;
+  return 0;
+}
+
+long long render_context_get_redrawn_pixels(const render_context_t *ctx) {
+  return ctx ? ctx->lastRedrawnPixels() : -1;
+}
+
+int render_context_get_occlusion_stats(const render_context_t *ctx,
+                                       render_occlusion_stats_t *out) {
+  if (!ctx || !out)
+    return -1;
+  const OcclusionStats &stats = ctx->occlusionStats();
+  out->cube_tests = stats.cubeTests;
+  out->cubes_rejected = stats.cubesRejected;
+  out->triangles_skipped = stats.trianglesSkipped;
+  return 0;
+}
+
+int render_context_get_frame_stats(const render_context_t *ctx,
+                                   render_frame_stats_t *out) {
+  if (!ctx || !out)
+    return -1;
+  const RenderStats &stats = ctx->renderStats();
+  const FrameCounters &c = stats.counters;
+  const PipelineCounters &p = stats.pipeline;
+  out->detailed = RENDER_STATS_ENABLED;
+  out->cubes_submitted = c.cubesSubmitted;
+  out->cubes_culled = c.cubesSubmitted - c.cubesDrawn;
+  out->triangles_backfacing = p.trianglesBackfacing;
+  out->triangles_near_clipped = p.trianglesNearClipped;
+  out->triangles_rejected = p.trianglesRejected;
+  out->triangles_rasterized = c.trianglesRasterized;
+  out->triangles_occluded = stats.occlusion.trianglesSkipped;
+  out->pixels_tested = p.pixelsTested;
+  out->pixels_covered = p.pixelsCovered;
+  out->depth_passes = c.depthPasses;
+  out->depth_fails = p.depthFails;
+  out->fragments_shaded = c.fragmentsShaded;
+  out->shading_packets = p.shadingPackets;
+  out->pixels_with_geometry = stats.pixelsWithGeometry;
+  out->overdraw = stats.overdraw;
+  out->cull_ms = stats.cullMs;
+  out->transform_ms = stats.transformMs;
+  out->bin_ms = stats.binMs;
+  out->raster_ms = stats.rasterMs;
+  out->shade_ms = stats.shadeMs;
+  out->total_ms = stats.totalMs;
+  out->arena_bytes = c.arenaBytes;
+  out->arena_heap_allocations = c.arenaHeapAllocations;
+  out->shadow_faces_rendered = c.shadowFacesRendered;
+  out->shadow_ms = stats.shadowMs;
+  out->temporal_reused = c.temporalReused;
+  return 0;
+}
+
+// ============ RENDER ASSINCRONO ============
+
+render_async_t *render_async_create(int num_buffers) {
+  if (num_buffers < 2)
+    return nullptr;
+  return new AsyncRenderer(num_buffers);
+}
+
+void render_async_destroy(render_async_t *async) { delete async; }
+
+static long long asyncSubmit(render_async_t *async, render_context_t *ctx,
+                             int width, int height, int use_phong,
+                             bool block) {
+  if (!async || !ctx || width <= 0 || height <= 0)
+    return 0;
+  ctx->graph.update();
+  RenderOptions options = ctx->options;
+  options.usePhong = use_phong != 0;
+  uint64_t ticket =
+      block ? async->submit(ctx->scene, options, width, height, ctx->clearColor)
+            : async->trySubmit(ctx->scene, options, width, height,
+                               ctx->clearColor);
+  return static_cast<long long>(ticket);
+}
+
+long long render_async_submit(render_async_t *async, render_context_t *ctx,
+                              int width, int height, int use_phong) {
+  return asyncSubmit(async, ctx, width, height, use_phong, true);
+}
+
+long long render_async_try_submit(render_async_t *async,
+                                  render_context_t *ctx, int width,
+                                  int height, int use_phong) {
+  return asyncSubmit(async, ctx, width, height, use_phong, false);
+}
+
+int render_async_poll(const render_async_t *async, long long ticket) {
+  if (!async)
+    return -1;
+  switch (async->poll(static_cast<uint64_t>(ticket))) {
+  case AsyncRenderer::Status::Ready:
+    return 1;
+  case AsyncRenderer::Status::Pending:
+    return 0;
+  default:
+    return -1;
+  }
+}
+
+const uint32_t *render_async_wait(render_async_t *async, long long ticket,
+                                  int *width, int *height) {
+  AsyncRenderer::Frame frame;
+  if (!async || !async->wait(static_cast<uint64_t>(ticket), frame))
+    return nullptr;
+  if (width)
+    *width = frame.width;
+  if (height)
+    *height = frame.height;
+  return frame.pixels;
+}
+
+int render_async_release(render_async_t *async, long long ticket) {
+  if (!async || !async->release(static_cast<uint64_t>(ticket)))
+    return -1;
+  return 0;
+}
+
+int render_async_set_callback(render_async_t *async,
+                              render_async_callback_t callback,
+                              void *user_data) {
+  if (!async)
+    return -1;
+  if (!callback) {
+    async->setCallback(nullptr);
+    return 0;
   }
+  async->setCallback([callback, user_data](const AsyncRenderer::Frame &f) {
+    callback(static_cast<long long>(f.ticket), f.pixels, f.width, f.height,
+             user_data);
+  });
+  return 0;
+}
+
+// ============ RENDER EM LOTE ============
+
+static thread_local std::string batchError;
+
+int render_batch(const char *scene_path, const char *output, int first_frame,
+                 int last_frame, int num_threads) {
+  if (!scene_path || !output) {
+    batchError = "caminho nulo";
+    return -1;
+  }
+  Animation anim;
+  FrameWriter writer;
+  BatchOptions options;
+  options.firstFrame = first_frame;
+  options.lastFrame = last_frame;
+  options.numThreads = num_threads;
+  bool ok = Animation::load(scene_path, anim, batchError) &&
+            writer.open(output, FrameWriter::formatFromPath(output),
+                        anim.width, anim.height, anim.fps, batchError) &&
+            renderAnimation(anim, writer, options, batchError) &&
+            writer.close(batchError);
+  if (!ok)
+    return -1;
+  batchError.clear();
+  return 0;
+}
 
-  // Adicionar luzes
-  for (int i = 0; i < num_lights; ++i) {
-    double *data = &lights_data[i * 7];
-    Light light;
-    light.position = Vec3{data[0], data[1], data[2]};
-    light.color = Vec3{data[3], data[4], data[5]};
-    light.intensity = data[6];
-    scene.lights.push_back(light);
+const char *render_batch_error(void) { return batchError.c_str(); }
+
+// ============ MALHAS ============
+
+static thread_local std::string meshError;
+
+static render_mesh_t *wrapMesh(std::shared_ptr<Mesh> mesh) {
+  if (!mesh)
+    return nullptr;
+  meshError.clear();
+  return new render_mesh{std::move(mesh)};
+}
+
+render_mesh_t *render_mesh_load(const char *path) {
+  if (!path) {
+    meshError = "caminho nulo";
+    return nullptr;
   }
+  return wrapMesh(Mesh::load(path, meshError));
+}
+
+render_mesh_t *render_mesh_create(const float *positions, int vertex_count,
+                                  const float *normals,
+                                  const uint32_t *indices,
+                                  int triangle_count) {
+  return wrapMesh(Mesh::fromArrays(positions, vertex_count, normals, indices,
+                                   triangle_count, meshError));
+}
+
+void render_mesh_destroy(render_mesh_t *mesh) { delete mesh; }
 
-  // Renderizar
-  Framebuffer fb(width, height);
-  fb.clear(0xff1a1a1a);
-  renderScene(scene, fb, use_phong != 0);
+int render_mesh_vertex_count(const render_mesh_t *mesh) {
+  return mesh ? mesh->mesh->vertexCount() : -1;
+}
 
-  // Copiar pixels
-  std::memcpy(out_pixels, fb.color.data(), width * height * sizeof(uint32_t));
+int render_mesh_triangle_count(const render_mesh_t *mesh) {
+  return mesh ? mesh->mesh->triangleCount() : -1;
 }
+
+int render_mesh_save_binary(const render_mesh_t *mesh, const char *path) {
+  if (!mesh || !path) {
+    meshError = "argumento nulo";
+    return -1;
+  }
+  if (!mesh->mesh->saveBinary(path, meshError))
+    return -1;
+  meshError.clear();
+  return 0;
+}
+
+const char *render_mesh_error(void) { return meshError.c_str(); }
 }
@@ -0,0 +1,480 @@
+// Modulo de extensao Python sobre a API C (render_api.h), alternativa ao
+// ctypes: a cena vem de arrays pelo buffer protocol (numpy, array, ctypes)
+// sem objetos Python por cubo, e a imagem sai direto num array do
+// chamador. O GIL fica solto durante o render, entao threads Python podem
+// renderizar varios contextos ao mesmo tempo.
+//
+//   import numpy as np, render_native
+//   ctx = render_native.Context()
+//   ctx.set_camera((0, 2, 8), (0, 0, 0), fov=60, near=0.1, far=100)
+//   cubes = np.zeros((n, 13))        # ou array estruturado de 13 float64
+//   ctx.set_cubes(cubes)             # guardado por referencia
+//   ctx.set_lights(np.array([[5, 5, 5, 1, 1, 1, 1]]))
+//   out = np.empty((600, 800, 4), np.uint8)   # RGBA; ou (600, 800) uint32
+//   ctx.render(out)
+//
+// Formatos: cubo com os 13 doubles da API C, luz com 7 (mais o alcance
+// como 8o campo, opcional). set_cubes/set_lights guardam uma view do array
+// (nao copiam); os valores sao lidos a cada render, entao basta alterar o
+// array no lugar e renderizar de novo.
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "render_api.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+// ============ FORMATOS DE BUFFER ============
+
+// Doubles por registro num formato do buffer protocol: "d", "<d", "13d" ou
+// estruturado "T{<d:px:<d:py:...}" (numpy, ctypes). -1 se tiver outro tipo
+// ou ordem de bytes diferente da nativa (little-endian).
+static int doublesPerItem(const char *format) {
+  if (!format)
+    return -1;
+  const char *f = format;
+  bool structured = f[0] == 'T' && f[1] == '{';
+  if (structured)
+    f += 2;
+  int count = 0;
+  while (*f && *f != '}') {
+    if (*f == '@' || *f == '=' || *f == '<') {
+      ++f;
+      continue;
+    }
+    int repeat = 0;
+    while (*f >= '0' && *f <= '9')
+      repeat = repeat * 10 + (*f++ - '0');
+    if (*f != 'd')
+      return -1;
+    ++f;
+    count += repeat ? repeat : 1;
+    if (*f == ':') { // nome do campo
+      const char *end = std::strchr(f + 1, ':');
+      if (!end)
+        return -1;
+      f = end + 1;
+    }
+  }
+  if (structured != (*f == '}') || (structured && f[1]))
+    return -1;
+  return count;
+}
+
+// Registros de minFields a maxFields doubles: array (N, campos) de float64
+// ou array estruturado (N,) so com campos float64, contiguo. Retorna N e
+// os campos em `fields`, ou -1 com a excecao.
+static Py_ssize_t recordCount(const Py_buffer &view, int minFields,
+                              int maxFields, int &fields, const char *what) {
+  int doubles = doublesPerItem(view.format);
+  if (doubles == 1 && view.itemsize == 8 && view.ndim == 2) {
+    fields = static_cast<int>(view.shape[1]);
+  } else if (doubles > 1 && view.itemsize == 8 * doubles && view.ndim == 1) {
+    fields = doubles;
+  } else {
+    PyErr_Format(PyExc_TypeError,
+                 "%s: esperado array (N, %d) de float64 ou estruturado com "
+                 "%d campos float64",
+                 what, minFields, minFields);
+    return -1;
+  }
+  if (fields < minFields || fields > maxFields) {
+    PyErr_Format(PyExc_ValueError, "%s: %d campos por registro (esperado %d)",
+                 what, fields, minFields);
+    return -1;
+  }
+  return view.shape[0];
+}
+
+// ============ CONTEXTO ============
+
+typedef struct {
+  PyObject_HEAD render_context_t *ctx;
+  // Views dos arrays da cena (obj == NULL: sem array)
+  Py_buffer cubes, lights;
+  Py_ssize_t cubeCount, lightCount;
+  int lightFields;
+  int phong, incremental;
+  // Ultimos valores das opcoes que a API C recebe juntas
+  int shadows, shadowMapSize, shadowPcf;
+  double frameBudget, minScale;
+  // Um render por vez: o GIL fica solto durante o render
+  std::atomic<bool> busy;
+} ContextObject;
+
+static bool claim(ContextObject *self) {
+  if (self->busy.exchange(true)) {
+    PyErr_SetString(PyExc_RuntimeError,
+                    "Context em uso por outra thread (um render por vez)");
+    return false;
+  }
+  return true;
+}
+
+static void releaseView(Py_buffer &view) {
+  if (view.obj)
+    PyBuffer_Release(&view);
+  view.obj = nullptr;
+}
+
+static PyObject *Context_new(PyTypeObject *type, PyObject *, PyObject *) {
+  ContextObject *self =
+      reinterpret_cast<ContextObject *>(type->tp_alloc(type, 0));
+  if (!self)
+    return nullptr;
+  self->ctx = render_context_create();
+  self->cubes.obj = self->lights.obj = nullptr;
+  self->cubeCount = self->lightCount = 0;
+  self->lightFields = 7;
+  self->phong = 1;
+  self->incremental = 0;
+  self->shadows = 0;
+  self->shadowMapSize = 512;
+  self->shadowPcf = 1;
+  self->frameBudget = 0.0;
+  self->minScale = 0.25;
+  new (&self->busy) std::atomic<bool>(false);
+  return reinterpret_cast<PyObject *>(self);
+}
+
+static void Context_dealloc(ContextObject *self) {
+  releaseView(self->cubes);
+  releaseView(self->lights);
+  render_context_destroy(self->ctx);
+  PyTypeObject *type = Py_TYPE(self);
+  type->tp_free(reinterpret_cast<PyObject *>(self));
+  Py_DECREF(type); // tipo criado com PyType_FromSpec
+}
+
+static bool parseVec3(PyObject *obj, double out[3], const char *what) {
+  if (!PyArg_ParseTuple(obj, "ddd", &out[0], &out[1], &out[2])) {
+    PyErr_Format(PyExc_TypeError, "%s: esperada tupla (x, y, z)", what);
+    return false;
+  }
+  return true;
+}
+
+static PyObject *Context_set_camera(ContextObject *self, PyObject *args,
+                                    PyObject *kwds) {
+  static const char *kwlist[] = {"eye", "center", "fov", "near", "far",
+                                 nullptr};
+  PyObject *eyeObj, *centerObj;
+  double fov = 60.0, nearPlane = 0.1, farPlane = 100.0;
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "OO|ddd",
+                                   const_cast<char **>(kwlist), &eyeObj,
+                                   &centerObj, &fov, &nearPlane, &farPlane))
+    return nullptr;
+  double eye[3], center[3];
+  if (!parseVec3(eyeObj, eye, "eye") || !parseVec3(centerObj, center, "center"))
+    return nullptr;
+  if (!claim(self))
+    return nullptr;
+  render_context_set_camera(self->ctx, eye[0], eye[1], eye[2], center[0],
+                            center[1], center[2], fov, nearPlane, farPlane);
+  self->busy = false;
+  Py_RETURN_NONE;
+}
+
+// Troca a view guardada em `slot` pela de `obj` (None esvazia)
+static bool setRecords(ContextObject *self, PyObject *obj, Py_buffer &slot,
+                       Py_ssize_t &count, int minFields, int maxFields,
+                       int *fieldsOut, const char *what) {
+  Py_buffer view;
+  view.obj = nullptr;
+  Py_ssize_t n = 0;
+  int fields = minFields;
+  if (obj != Py_None) {
+    if (PyObject_GetBuffer(obj, &view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) <
+        0)
+      return false;
+    n = recordCount(view, minFields, maxFields, fields, what);
+    if (n < 0 || n > INT32_MAX) {
+      if (n > INT32_MAX)
+        PyErr_Format(PyExc_ValueError, "%s: registros demais", what);
+      PyBuffer_Release(&view);
+      return false;
+    }
+  }
+  if (!claim(self)) {
+    releaseView(view);
+    return false;
+  }
+  releaseView(slot);
+  slot = view;
+  count = n;
+  if (fieldsOut)
+    *fieldsOut = fields;
+  self->busy = false;
+  return true;
+}
+
+static PyObject *Context_set_cubes(ContextObject *self, PyObject *obj) {
+  if (!setRecords(self, obj, self->cubes, self->cubeCount, 13, 13, nullptr,
+                  "cubes"))
+    return nullptr;
+  Py_RETURN_NONE;
+}
+
+static PyObject *Context_set_lights(ContextObject *self, PyObject *obj) {
+  if (!setRecords(self, obj, self->lights, self->lightCount, 7, 8,
+                  &self->lightFields, "lights"))
+    return nullptr;
+  Py_RETURN_NONE;
+}
+
+// Opcao booleana/inteira/real: None (ou ausente) deixa como esta
+static bool optionInt(PyObject *obj, int &value) {
+  if (!obj || obj == Py_None)
+    return true;
+  long v = PyLong_AsLong(obj);
+  if (v == -1 && PyErr_Occurred())
+    return false;
+  value = static_cast<int>(v);
+  return true;
+}
+
+static bool optionBool(PyObject *obj, int &value) {
+  if (!obj || obj == Py_None)
+    return true;
+  int v = PyObject_IsTrue(obj);
+  if (v < 0)
+    return false;
+  value = v;
+  return true;
+}
+
+static bool optionDouble(PyObject *obj, double &value) {
+  if (!obj || obj == Py_None)
+    return true;
+  double v = PyFloat_AsDouble(obj);
+  if (v == -1.0 && PyErr_Occurred())
+    return false;
+  value = v;
+  return true;
+}
+
+static PyObject *Context_set_options(ContextObject *self, PyObject *args,
+                                     PyObject *kwds) {
+  static const char *kwlist[] = {"phong",        "deferred",
+                                 "occlusion",    "msaa",
+                                 "shadows",      "shadow_map_size",
+                                 "shadow_pcf",   "temporal",
+                                 "incremental",  "frame_budget",
+                                 "min_scale",    nullptr};
+  PyObject *o[11] = {};
+  if (!PyArg_ParseTupleAndKeywords(
+          args, kwds, "|$OOOOOOOOOOO", const_cast<char **>(kwlist), &o[0],
+          &o[1], &o[2], &o[3], &o[4], &o[5], &o[6], &o[7], &o[8], &o[9],
+          &o[10]))
+    return nullptr;
+
+  int phong = self->phong, deferred = -1, occlusion = -1, msaa = -1,
+      temporal = -1, incremental = -1;
+  int shadows = self->shadows, mapSize = self->shadowMapSize,
+      pcf = self->shadowPcf;
+  double budget = self->frameBudget, minScale = self->minScale;
+  if (!optionBool(o[0], phong) || !optionBool(o[1], deferred) ||
+      !optionBool(o[2], occlusion) || !optionInt(o[3], msaa) ||
+      !optionBool(o[4], shadows) || !optionInt(o[5], mapSize) ||
+      !optionInt(o[6], pcf) || !optionBool(o[7], temporal) ||
+      !optionBool(o[8], incremental) || !optionDouble(o[9], budget) ||
+      !optionDouble(o[10], minScale))
+    return nullptr;
+  if (!claim(self))
+    return nullptr;
+
+  render_context_t *ctx = self->ctx;
+  const char *invalid = nullptr;
+  if (msaa != -1 && render_context_set_msaa(ctx, msaa) < 0)
+    invalid = "msaa: 1, 2, 4 ou 8";
+  else if ((o[4] || o[5] || o[6]) &&
+           render_context_set_shadows(ctx, shadows, mapSize, pcf) < 0)
+    invalid = "shadow_map_size: 8 a 8192, shadow_pcf: 0 a 8";
+  else if ((o[9] || o[10]) &&
+           render_context_set_frame_budget(ctx, budget, minScale) < 0)
+    invalid = "frame_budget >= 0, min_scale em (0, 1]";
+  if (invalid) {
+    self->busy = false;
+    PyErr_SetString(PyExc_ValueError, invalid);
+    return nullptr;
+  }
+  if (deferred != -1)
+    render_context_set_deferred(ctx, deferred);
+  if (occlusion != -1)
+    render_context_set_occlusion_culling(ctx, occlusion);
+  if (temporal != -1)
+    render_context_set_temporal(ctx, temporal);
+  if (incremental != -1) {
+    render_context_set_incremental(ctx, incremental);
+    self->incremental = incremental;
+  }
+  self->phong = phong;
+  self->shadows = shadows;
+  self->shadowMapSize = mapSize;
+  self->shadowPcf = pcf;
+  self->frameBudget = budget;
+  self->minScale = minScale;
+  self->busy = false;
+  Py_RETURN_NONE;
+}
+
+// Passa os arrays guardados para o contexto (sem o GIL: as views seguram
+// a memoria)
+static void uploadScene(ContextObject *self) {
+  render_context_t *ctx = self->ctx;
+  const double *cubes = static_cast<const double *>(self->cubes.buf);
+  render_context_set_cube_count(ctx, static_cast<int>(self->cubeCount));
+  for (Py_ssize_t i = 0; i < self->cubeCount; ++i)
+    render_context_set_cube(ctx, static_cast<int>(i), cubes + i * 13);
+
+  const double *lights = static_cast<const double *>(self->lights.buf);
+  const int stride = self->lightFields;
+  render_context_set_light_count(ctx, static_cast<int>(self->lightCount));
+  for (Py_ssize_t i = 0; i < self->lightCount; ++i) {
+    const double *light = lights + i * stride;
+    render_context_set_light(ctx, static_cast<int>(i), light);
+    if (stride > 7 && light[7] > 0.0)
+      render_context_set_light_range(ctx, static_cast<int>(i), light[7]);
+  }
+}
+
+// ARGB (bytes B, G, R, A na memoria) <-> RGBA: troca R e B, a mesma
+// operacao nos dois sentidos
+static void swapRedBlue(uint32_t *pixels, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    uint32_t p = pixels[i];
+    pixels[i] = (p & 0xff00ff00) | ((p >> 16) & 0xff) | ((p & 0xff) << 16);
+  }
+}
+
+static PyObject *Context_render(ContextObject *self, PyObject *obj) {
+  Py_buffer view;
+  if (PyObject_GetBuffer(obj, &view,
+                         PyBUF_C_CONTIGUOUS | PyBUF_FORMAT | PyBUF_WRITABLE) <
+      0)
+    return nullptr;
+  // uint32 (A, L) em ARGB ou uint8 (A, L, 4) em RGBA
+  const char *f = view.format ? view.format : "B";
+  if (*f == '@' || *f == '=' || *f == '<')
+    ++f;
+  bool argb = view.ndim == 2 && view.itemsize == 4 &&
+              (!std::strcmp(f, "I") || !std::strcmp(f, "L"));
+  bool rgba = view.ndim == 3 && view.itemsize == 1 && view.shape[2] == 4 &&
+              !std::strcmp(f, "B");
+  if ((!argb && !rgba) ||
+      reinterpret_cast<uintptr_t>(view.buf) % alignof(uint32_t) != 0 ||
+      view.shape[0] <= 0 || view.shape[1] <= 0 || view.shape[0] > INT32_MAX ||
+      view.shape[1] > INT32_MAX) {
+    PyBuffer_Release(&view);
+    PyErr_SetString(PyExc_TypeError,
+                    "saida: array contiguo (altura, largura) de uint32 ou "
+                    "(altura, largura, 4) de uint8");
+    return nullptr;
+  }
+  if (!claim(self)) {
+    PyBuffer_Release(&view);
+    return nullptr;
+  }
+
+  const int height = static_cast<int>(view.shape[0]);
+  const int width = static_cast<int>(view.shape[1]);
+  uint32_t *pixels = static_cast<uint32_t *>(view.buf);
+  const size_t count = static_cast<size_t>(width) * height;
+  Py_BEGIN_ALLOW_THREADS
+  uploadScene(self);
+  // Modo incremental: o contexto reaproveita o frame anterior do buffer,
+  // que precisa voltar a ARGB
+  if (rgba && self->incremental)
+    swapRedBlue(pixels, count);
+  render_context_render(self->ctx, width, height, self->phong, pixels);
+  if (rgba)
+    swapRedBlue(pixels, count);
+  Py_END_ALLOW_THREADS
+  self->busy = false;
+  PyBuffer_Release(&view);
+  Py_RETURN_NONE;
+}
+
+static PyObject *Context_get_render_scale(ContextObject *self, void *) {
+  return PyFloat_FromDouble(render_context_get_render_scale(self->ctx));
+}
+
+static PyObject *Context_get_redrawn_pixels(ContextObject *self, void *) {
+  return PyLong_FromLongLong(render_context_get_redrawn_pixels(self->ctx));
+}
+
+// Metodos com a assinatura real (self tipado, keywords) para a tabela
+template <typename Fn> static PyCFunction method(Fn fn) {
+  return reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(fn));
+}
+
+static PyMethodDef Context_methods[] = {
+    {"set_camera", method(Context_set_camera),
+     METH_VARARGS | METH_KEYWORDS,
+     "set_camera(eye, center, fov=60, near=0.1, far=100)"},
+    {"set_cubes", method(Context_set_cubes), METH_O,
+     "set_cubes(array): (N, 13) float64 ou estruturado; guardado por "
+     "referencia e lido a cada render (None esvazia)"},
+    {"set_lights", method(Context_set_lights), METH_O,
+     "set_lights(array): (N, 7) ou (N, 8) float64 (8o campo = alcance) ou "
+     "estruturado; guardado por referencia (None esvazia)"},
+    {"set_options", method(Context_set_options),
+     METH_VARARGS | METH_KEYWORDS,
+     "set_options(*, phong, deferred, occlusion, msaa, shadows, "
+     "shadow_map_size, shadow_pcf, temporal, incremental, frame_budget, "
+     "min_scale): so as passadas mudam"},
+    {"render", method(Context_render), METH_O,
+     "render(out): renderiza em out, (A, L) uint32 ARGB ou (A, L, 4) uint8 "
+     "RGBA, sem o GIL"},
+    {nullptr, nullptr, 0, nullptr}};
+
+static PyGetSetDef Context_getset[] = {
+    {"render_scale", reinterpret_cast<getter>(Context_get_render_scale),
+     nullptr, "Escala por eixo do ultimo render (resolucao dinamica)",
+     nullptr},
+    {"redrawn_pixels", reinterpret_cast<getter>(Context_get_redrawn_pixels),
+     nullptr, "Pixels redesenhados no ultimo render", nullptr},
+    {nullptr, nullptr, nullptr, nullptr, nullptr}};
+
+static PyType_Slot Context_slots[] = {
+    {Py_tp_doc,
+     const_cast<char *>(
+         "Contexto de render retido (render_context_* da API C)")},
+    {Py_tp_new, reinterpret_cast<void *>(Context_new)},
+    {Py_tp_dealloc, reinterpret_cast<void *>(Context_dealloc)},
+    {Py_tp_methods, Context_methods},
+    {Py_tp_getset, Context_getset},
+    {0, nullptr}};
+
+static PyType_Spec Context_spec = {"render_native.Context",
+                                   sizeof(ContextObject), 0,
+                                   Py_TPFLAGS_DEFAULT, Context_slots};
+
+// ============ MODULO ============
+
+static PyModuleDef renderModule = {PyModuleDef_HEAD_INIT,
+                                   "render_native",
+                                   "Renderizador (contexto retido) com "
+                                   "arrays pelo buffer protocol",
+                                   -1,
+                                   nullptr,
+                                   nullptr,
+                                   nullptr,
+                                   nullptr,
+                                   nullptr};
+
+PyMODINIT_FUNC PyInit_render_native(void) {
+  PyObject *module = PyModule_Create(&renderModule);
+  if (!module)
+    return nullptr;
+  PyObject *type = PyType_FromSpec(&Context_spec);
+  if (!type || PyModule_AddObject(module, "Context", type) < 0) {
+    Py_XDECREF(type);
+    Py_DECREF(module);
+    return nullptr;
+  }
+  return module;
+}
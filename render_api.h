@@ -0,0 +1,280 @@
+#pragma once
+#include <stdint.h>
+
+// API C da biblioteca de renderizacao (carregada pelo Python via ctypes).
+//
+// Formatos dos arrays:
+//   cubo (13 doubles): pos.x, pos.y, pos.z, rot.x, rot.y, rot.z, scale,
+//                      color.r, color.g, color.b, ka, kd, ks
+//   luz  (7 doubles):  pos.x, pos.y, pos.z, color.r, color.g, color.b,
+//                      intensity
+// Pixels de saida: width*height uint32 ARGB, linha a linha.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Render imediato: monta a cena a cada chamada
+void render_api(int width, int height, double eye_x, double eye_y,
+                double eye_z, double center_x, double center_y,
+                double center_z, double fov, double near_plane,
+                double far_plane, int num_cubes, double *cubes_data,
+                int num_lights, double *lights_data, int use_phong,
+                uint32_t *out_pixels);
+
+// ============ CONTEXTO RETIDO ============
+// A cena fica guardada no contexto; atualize so o que mudou e chame
+// render_context_render. Funcoes que retornam int devolvem 0 em sucesso e
+// -1 para argumentos invalidos (ex.: indice fora do intervalo, ctx NULL);
+// as que nao retornam nada ignoram ctx NULL.
+// Um contexto nao deve ser usado por duas threads ao mesmo tempo.
+
+typedef struct RenderContext render_context_t;
+typedef struct render_mesh render_mesh_t;
+
+render_context_t *render_context_create(void);
+void render_context_destroy(render_context_t *ctx);
+
+void render_context_set_camera(render_context_t *ctx, double eye_x,
+                               double eye_y, double eye_z, double center_x,
+                               double center_y, double center_z, double fov,
+                               double near_plane, double far_plane);
+
+int render_context_set_cube_count(render_context_t *ctx, int count);
+int render_context_set_cube(render_context_t *ctx, int index,
+                            const double *cube_data);
+
+// Instancias de malha (ver MALHAS): mesmo array de 13 doubles do cubo;
+// mesh = NULL esvazia a posicao. O contexto guarda sua propria referencia.
+int render_context_set_mesh_count(render_context_t *ctx, int count);
+int render_context_set_mesh(render_context_t *ctx, int index,
+                            const render_mesh_t *mesh,
+                            const double *instance_data);
+
+int render_context_set_light_count(render_context_t *ctx, int count);
+int render_context_set_light(render_context_t *ctx, int index,
+                             const double *light_data);
+// Alcance da luz `index`: a contribuicao cai suavemente a 0 em `range`.
+// 0 = alcance infinito (padrao; set_light volta a luz para infinito).
+int render_context_set_light_range(render_context_t *ctx, int index,
+                                   double range);
+// Com sombras ligadas, a luz `index` projeta sombra? (1 = sim, padrao;
+// set_light volta para 1)
+int render_context_set_light_shadow(render_context_t *ctx, int index,
+                                    int enabled);
+
+// Grafo de cena: hierarquia pai/filho sobre os cubos e malhas do contexto.
+// A transformacao de mundo de um no e a local composta com a do pai e e
+// gravada no cubo/malha anexado a cada render (e submit assincrono), so
+// para os nos que mudaram e seus descendentes. A posicao/rotacao/escala de
+// um cubo/malha anexado passam a vir do no; set_cube/set_mesh continuam
+// trocando o material (e a malha), e a transformacao passada e substituida
+// pela do no no proximo render. Transformacao local (7 doubles): pos.x, pos.y, pos.z, rot.x,
+// rot.y, rot.z, scale (> 0), como o inicio do array do cubo.
+// As funcoes de criacao retornam o indice do no (ou -1); parent = -1 e raiz.
+int render_context_create_node(render_context_t *ctx, int parent);
+// No para o cubo/malha `index` ja existente; a transformacao atual dele vira
+// a local do no. -1 se ele ja estiver anexado a outro no.
+int render_context_create_cube_node(render_context_t *ctx, int cube_index,
+                                    int parent);
+int render_context_create_mesh_node(render_context_t *ctx, int mesh_index,
+                                    int parent);
+// Novo pai (-1 = raiz), mantendo a transformacao local; -1 se criar ciclo
+int render_context_set_node_parent(render_context_t *ctx, int node,
+                                   int parent);
+int render_context_set_node_transform(render_context_t *ctx, int node,
+                                      const double *trs);
+
+// Renderiza direto em out_pixels (sem copia intermediaria)
+int render_context_render(render_context_t *ctx, int width, int height,
+                          int use_phong, uint32_t *out_pixels);
+
+// Multi-view: a cena do contexto vista por num_views cameras numa chamada
+// (par estereo, faces de cube map, varias cameras). A parte em mundo e
+// calculada uma vez e as vistas renderizam em paralelo; cada uma sai igual
+// a um render_context_render com a sua camera. A camera do contexto nao e
+// usada. Vista (12 doubles): eye.x/y/z, center.x/y/z, up.x/y/z, fov, near,
+// far. out_pixels[i]: width*height pixels da vista i.
+int render_context_render_views(render_context_t *ctx, int num_views,
+                                const double *views_data, int width,
+                                int height, int use_phong,
+                                uint32_t *const *out_pixels);
+
+// Occlusion culling (Hi-Z): cubos ordenados da frente para tras e ocultos
+// descartados antes da rasterizacao. Desligado por padrao.
+int render_context_set_occlusion_culling(render_context_t *ctx, int enabled);
+
+// Deferred shading (so Phong): G-buffer por tile e um resolve que sombreia
+// cada pixel visivel uma vez. Mesma imagem; desligado por padrao.
+int render_context_set_deferred(render_context_t *ctx, int enabled);
+
+// MSAA: 2, 4 ou 8 amostras por pixel (1 desliga, padrao). Cobertura e
+// profundidade por amostra, shading uma vez por pixel e triangulo e a media
+// das amostras na saida. Com MSAA o deferred usa o caminho direto.
+int render_context_set_msaa(render_context_t *ctx, int samples);
+
+// Sombras: cube shadow map de map_size x map_size por face (8 a 8192) para
+// cada luz que projeta sombra, filtrado com PCF de raio pcf_radius texels
+// (0 a 8; 1 = 3x3). Os mapas ficam em cache e so as faces alcancadas por
+// luzes ou objetos que mudaram sao refeitas. Desligado por padrao.
+int render_context_set_shadows(render_context_t *ctx, int enabled,
+                               int map_size, int pcf_radius);
+
+// Cache temporal (deferred sem MSAA, ate 4 luzes): com a camera andando
+// numa cena parada, o difuso e a sombra de cada pixel vem do frame
+// anterior reprojetado e so o especular e refeito; cada pixel volta a ser
+// sombreado por inteiro pelo menos a cada 8 frames. Mais lento que o
+// frame normal neste renderer (numeros no README). Desligado por padrao.
+int render_context_set_temporal(render_context_t *ctx, int enabled);
+
+// Resolucao dinamica: com target_ms > 0, render_context_render mede o custo
+// de cada frame e escolhe a resolucao interna do seguinte (entre min_scale e
+// 1 por eixo, com histerese: desce assim que estoura, sobe devagar com
+// folga) para caber em target_ms; a imagem sai ampliada com filtro bilinear
+// em width x height. Frames reduzidos sao sempre completos (sem modo
+// incremental). target_ms = 0 desliga (padrao); min_scale em (0, 1].
+int render_context_set_frame_budget(render_context_t *ctx, double target_ms,
+                                    double min_scale);
+// Escala por eixo do ultimo render (1 = resolucao cheia); -1 se ctx NULL
+double render_context_get_render_scale(const render_context_t *ctx);
+
+// Modo incremental: se desde o ultimo render so cubos ou instancias de
+// malha mudaram, redesenha apenas a area de tela que eles cobriam ou
+// passaram a cobrir. O buffer de saida deve ser o mesmo e nao ser alterado
+// entre renders. Desligado por padrao.
+int render_context_set_incremental(render_context_t *ctx, int enabled);
+// Pixels redesenhados no ultimo render
+long long render_context_get_redrawn_pixels(const render_context_t *ctx);
+
+// Contadores do occlusion culling no ultimo render (um teste = um cubo
+// contra um tile de tela que ele toca)
+typedef struct {
+  long long cube_tests;
+  long long cubes_rejected;
+  long long triangles_skipped;
+} render_occlusion_stats_t;
+
+int render_context_get_occlusion_stats(const render_context_t *ctx,
+                                       render_occlusion_stats_t *out);
+
+// Estatisticas do ultimo render. Contagens de cubos, triangulos e
+// fragmentos sempre; o resto so se a biblioteca foi compilada com
+// RENDER_STATS (detailed = 1), senao fica 0.
+typedef struct {
+  int detailed;
+  // Cubos
+  long long cubes_submitted;
+  long long cubes_culled; // frustum culling
+  // Triangulos
+  long long triangles_backfacing;  // detailed
+  long long triangles_near_clipped; // detailed
+  long long triangles_rejected;     // detailed: degenerados/fora da tela
+  long long triangles_rasterized;
+  long long triangles_occluded; // occlusion culling
+  // Pixels e fragmentos
+  long long pixels_tested;  // detailed: visitados pelo teste de aresta
+  long long pixels_covered; // detailed: dentro de algum triangulo
+  long long depth_passes;
+  long long depth_fails; // detailed
+  long long fragments_shaded;
+  long long shading_packets;      // detailed: chamadas do kernel Phong
+  long long pixels_with_geometry; // detailed
+  double overdraw;                // detailed: depth_passes / pixels
+  // Tempos em ms (detailed); shade_ms e a soma entre threads
+  double cull_ms, transform_ms, bin_ms, raster_ms, shade_ms, total_ms;
+  // Arena do frame (listas por tile): bytes usados e blocos pedidos ao
+  // heap (0 depois do aquecimento)
+  long long arena_bytes;
+  long long arena_heap_allocations;
+  // Sombras: faces de shadow map refeitas (0 com a cena parada) e o tempo
+  // da atualizacao dos mapas (detailed)
+  long long shadow_faces_rendered;
+  double shadow_ms;
+  // Cache temporal: pixels com o difuso reaproveitado do frame anterior
+  long long temporal_reused;
+} render_frame_stats_t;
+
+int render_context_get_frame_stats(const render_context_t *ctx,
+                                   render_frame_stats_t *out);
+
+// ============ RENDER ASSINCRONO ============
+// Uma thread de render dedicada com um anel de framebuffers: o chamador
+// consome o frame N (converte, codifica) enquanto o N+1 renderiza.
+// render_async_submit copia a cena e as opcoes atuais de um contexto e
+// retorna um ticket (> 0). O frame pronto fica no anel ate
+// render_async_release; com todos os buffers ocupados, submit bloqueia.
+// Frames ficam prontos na ordem de submissao.
+
+typedef struct AsyncRenderer render_async_t;
+
+// num_buffers >= 2 (3 = triple buffering)
+render_async_t *render_async_create(int num_buffers);
+// Espera o frame em andamento; frames ainda na fila sao descartados
+void render_async_destroy(render_async_t *async);
+
+// 0 se os argumentos forem invalidos. Aplica antes o grafo de cena do
+// contexto.
+long long render_async_submit(render_async_t *async, render_context_t *ctx,
+                              int width, int height, int use_phong);
+// Como submit, mas retorna 0 em vez de bloquear se nao ha buffer livre
+long long render_async_try_submit(render_async_t *async,
+                                  render_context_t *ctx, int width,
+                                  int height, int use_phong);
+
+// 1 = pronto, 0 = pendente, -1 = ticket invalido ou ja liberado
+int render_async_poll(const render_async_t *async, long long ticket);
+// Espera o frame e devolve seus pixels (validos ate release); NULL se o
+// ticket for invalido. width/height podem ser NULL.
+const uint32_t *render_async_wait(render_async_t *async, long long ticket,
+                                  int *width, int *height);
+int render_async_release(render_async_t *async, long long ticket);
+
+// Chamado na thread de render quando cada frame fica pronto (pode chamar
+// render_async_release, mas nao submit/wait). NULL desliga.
+typedef void (*render_async_callback_t)(long long ticket,
+                                        const uint32_t *pixels, int width,
+                                        int height, void *user_data);
+int render_async_set_callback(render_async_t *async,
+                              render_async_callback_t callback,
+                              void *user_data);
+
+
+// ============ RENDER EM LOTE ============
+// Renderiza uma animacao por keyframes (formato descrito em
+// src/core/Animation.h) direto para o disco, em paralelo entre frames e
+// com memoria limitada. O formato sai da extensao de `output`: .y4m,
+// .ppm (padrao printf com %d, um arquivo por frame) ou raw ARGB.
+// last_frame = -1 vai ate o fim; num_threads = 0 usa todas.
+// Retorna 0, ou -1 com a mensagem em render_batch_error().
+int render_batch(const char *scene_path, const char *output, int first_frame,
+                 int last_frame, int num_threads);
+// Mensagem do ultimo erro de render_batch na thread atual
+const char *render_batch_error(void);
+
+// ============ MALHAS ============
+// Malhas indexadas de triangulos, imutaveis e compartilhaveis entre
+// instancias e contextos. .rmesh e mapeado em memoria (abrir e quase
+// instantaneo); .obj e lido e convertido. Funcoes que criam malhas
+// retornam NULL com a mensagem em render_mesh_error().
+
+// Pela extensao: .obj ou .rmesh
+render_mesh_t *render_mesh_load(const char *path);
+// Copia os arrays: positions/normals com 3 floats por vertice (normals
+// NULL = normais suaves), indices com 3 por triangulo, anti-horario
+render_mesh_t *render_mesh_create(const float *positions, int vertex_count,
+                                  const float *normals,
+                                  const uint32_t *indices,
+                                  int triangle_count);
+// Libera a referencia do chamador; contextos que usam a malha a mantem
+void render_mesh_destroy(render_mesh_t *mesh);
+
+int render_mesh_vertex_count(const render_mesh_t *mesh);
+int render_mesh_triangle_count(const render_mesh_t *mesh);
+// Grava no formato .rmesh; 0 ou -1 com a mensagem em render_mesh_error()
+int render_mesh_save_binary(const render_mesh_t *mesh, const char *path);
+// Mensagem do ultimo erro de malha na thread atual
+const char *render_mesh_error(void);
+
+#ifdef __cplusplus
+}
+#endif
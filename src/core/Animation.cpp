@@ -0,0 +1,224 @@
+#include "Animation.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+// ============ INTERPOLACAO ============
+
+static Vec3 lerp(const Vec3 &a, const Vec3 &b, double t) {
+  return a + (b - a) * t;
+}
+
+// Segmento [k, k+1] de `keys` que contem `frame` e a fracao t dentro dele.
+// Fora do intervalo dos keyframes, t fica em 0 no primeiro ou no ultimo.
+template <typename Key>
+static const Key *segment(const std::vector<Key> &keys, int frame,
+                          const Key *&next, double &t) {
+  auto it = std::upper_bound(
+      keys.begin(), keys.end(), frame,
+      [](int f, const Key &k) { return f < k.frame; });
+  if (it == keys.begin()) {
+    next = &keys.front();
+    t = 0.0;
+    return &keys.front();
+  }
+  const Key *prev = &*(it - 1);
+  if (it == keys.end()) {
+    next = prev;
+    t = 0.0;
+    return prev;
+  }
+  next = &*it;
+  t = static_cast<double>(frame - prev->frame) / (next->frame - prev->frame);
+  return prev;
+}
+
+void Animation::sceneAt(int frame, Scene &out) const {
+  out.lights = base.lights;
+  out.camera = base.camera;
+  out.cubes = base.cubes;
+
+  if (!cameraKeys.empty()) {
+    const CameraKey *b;
+    double t;
+    const CameraKey *a = segment(cameraKeys, frame, b, t);
+    out.camera.eye = lerp(a->eye, b->eye, t);
+    out.camera.center = lerp(a->center, b->center, t);
+  }
+
+  for (size_t i = 0; i < cubeKeys.size(); ++i) {
+    const auto &keys = cubeKeys[i];
+    if (keys.empty())
+      continue;
+    const CubeKey *b;
+    double t;
+    const CubeKey *a = segment(keys, frame, b, t);
+    Cube &cube = out.cubes[i];
+    cube.position = lerp(a->position, b->position, t);
+    cube.rotation = lerp(a->rotation, b->rotation, t);
+    cube.scale = a->scale + (b->scale - a->scale) * t;
+  }
+}
+
+// ============ LEITURA ============
+
+// Limites do cabecalho: valores acima disso sao erro de digitacao ou arquivo
+// hostil e virariam alocacoes gigantes (ou estouro no cast para int)
+static const int MAX_SIDE = 16384;                    // largura/altura
+static const double MAX_PIXELS = 8192.0 * 8192.0;     // por frame
+static const int MAX_FRAMES = 1000000;                // tambem o teto de keyframe
+static const double MAX_TOTAL_PIXELS = 1099511627776; // 2^40, todos os frames
+static const int MAX_FPS = 1000;
+
+// Rejeita NaN junto (toda comparacao com NaN e falsa)
+static bool inRange(double x, double lo, double hi) {
+  return x >= lo && x <= hi;
+}
+
+bool Animation::load(const std::string &path, Animation &anim,
+                     std::string &error) {
+  std::ifstream in(path);
+  if (!in) {
+    error = "nao foi possivel abrir " + path;
+    return false;
+  }
+  return parse(in, anim, error);
+}
+
+bool Animation::parse(std::istream &in, Animation &anim, std::string &error) {
+  anim = Animation{};
+  Camera &camera = anim.base.camera;
+  camera.eye = Vec3{0, 0, 5};
+  camera.center = Vec3{0, 0, 0};
+  camera.up = Vec3{0, 1, 0};
+
+  std::string line;
+  int lineNo = 0;
+  auto fail = [&](const std::string &msg) {
+    error = "linha " + std::to_string(lineNo) + ": " + msg;
+    return false;
+  };
+
+  while (std::getline(in, line)) {
+    ++lineNo;
+    line = line.substr(0, line.find('#'));
+    std::istringstream ss(line);
+    std::string cmd;
+    if (!(ss >> cmd))
+      continue;
+
+    // Le exatamente `n` numeros (ou ate `n` com `optional` no fim)
+    std::vector<double> v;
+    auto numbers = [&](size_t n, size_t optional = 0) {
+      double x;
+      while (ss >> x)
+        v.push_back(x);
+      return ss.eof() && v.size() >= n && v.size() <= n + optional;
+    };
+
+    if (cmd == "size") {
+      if (!numbers(2) || !inRange(v[0], 1, MAX_SIDE) ||
+          !inRange(v[1], 1, MAX_SIDE))
+        return fail("size espera largura e altura entre 1 e " +
+                    std::to_string(MAX_SIDE));
+      if (std::floor(v[0]) * std::floor(v[1]) > MAX_PIXELS)
+        return fail("size acima de " +
+                    std::to_string(static_cast<long long>(MAX_PIXELS)) +
+                    " pixels");
+      anim.width = static_cast<int>(v[0]);
+      anim.height = static_cast<int>(v[1]);
+    } else if (cmd == "frames") {
+      if (!numbers(1) || !inRange(v[0], 1, MAX_FRAMES))
+        return fail("frames espera um numero entre 1 e " +
+                    std::to_string(MAX_FRAMES));
+      anim.frameCount = static_cast<int>(v[0]);
+    } else if (cmd == "fps") {
+      if (!numbers(1) || !inRange(v[0], 1, MAX_FPS))
+        return fail("fps espera um numero entre 1 e " +
+                    std::to_string(MAX_FPS));
+      anim.fps = static_cast<int>(v[0]);
+    } else if (cmd == "shading") {
+      std::string mode;
+      ss >> mode;
+      if (mode != "phong" && mode != "flat")
+        return fail("shading espera phong ou flat");
+      anim.usePhong = mode == "phong";
+    } else if (cmd == "background") {
+      std::string hex, rest;
+      ss >> hex;
+      char *end = nullptr;
+      unsigned long rgb = std::strtoul(hex.c_str(), &end, 16);
+      if (hex.size() != 6 || *end || (ss >> rest))
+        return fail("background espera uma cor RRGGBB");
+      anim.background = 0xff000000u | static_cast<uint32_t>(rgb);
+    } else if (cmd == "camera") {
+      if (!numbers(6, 3) || v.size() == 7 || v.size() == 8)
+        return fail("camera espera ex ey ez cx cy cz [fov near far]");
+      camera.eye = Vec3{v[0], v[1], v[2]};
+      camera.center = Vec3{v[3], v[4], v[5]};
+      if (v.size() == 9) {
+        camera.fovY = v[6];
+        camera.nearPlane = v[7];
+        camera.farPlane = v[8];
+      }
+    } else if (cmd == "light") {
+      if (!numbers(7, 1))
+        return fail("light espera x y z r g b intensidade [alcance]");
+      anim.base.lights.emplace_back(Vec3{v[0], v[1], v[2]},
+                                    Vec3{v[3], v[4], v[5]}, v[6],
+                                    v.size() > 7 ? v[7] : 0.0);
+    } else if (cmd == "cube") {
+      if (!numbers(13))
+        return fail("cube espera x y z rx ry rz escala r g b ka kd ks");
+      Cube cube;
+      cube.position = Vec3{v[0], v[1], v[2]};
+      cube.rotation = Vec3{v[3], v[4], v[5]};
+      cube.scale = v[6];
+      cube.material.color = Vec3{v[7], v[8], v[9]};
+      cube.material.ka = v[10];
+      cube.material.kd = v[11];
+      cube.material.ks = v[12];
+      anim.base.cubes.push_back(cube);
+    } else if (cmd == "camkey") {
+      if (!numbers(7) || !inRange(v[0], 0, MAX_FRAMES))
+        return fail("camkey espera frame ex ey ez cx cy cz");
+      anim.cameraKeys.push_back(CameraKey{static_cast<int>(v[0]),
+                                          Vec3{v[1], v[2], v[3]},
+                                          Vec3{v[4], v[5], v[6]}});
+    } else if (cmd == "cubekey") {
+      if (!numbers(9) || !inRange(v[0], 0, MAX_FRAMES) ||
+          !inRange(v[1], 0, MAX_FRAMES))
+        return fail("cubekey espera cubo frame x y z rx ry rz escala");
+      size_t cube = static_cast<size_t>(v[0]);
+      if (cube >= anim.base.cubes.size())
+        return fail("cubekey para cubo inexistente (declare o cube antes)");
+      if (anim.cubeKeys.size() < anim.base.cubes.size())
+        anim.cubeKeys.resize(anim.base.cubes.size());
+      anim.cubeKeys[cube].push_back(CubeKey{static_cast<int>(v[1]),
+                                            Vec3{v[2], v[3], v[4]},
+                                            Vec3{v[5], v[6], v[7]}, v[8]});
+    } else {
+      return fail("diretiva desconhecida '" + cmd + "'");
+    }
+  }
+
+  // size e frames podem vir em qualquer ordem: o total so e conhecido no fim.
+  // O texto nao carrega os pixels, entao o teto e fixo e nao o tamanho do
+  // arquivo; e o que o render em lote vai escrever na saida.
+  const double total = static_cast<double>(anim.width) * anim.height *
+                       anim.frameCount;
+  if (total > MAX_TOTAL_PIXELS)
+    return fail("size x frames acima de " +
+                std::to_string(static_cast<long long>(MAX_TOTAL_PIXELS)) +
+                " pixels no total");
+
+  // Keyframes em ordem de frame (ordem do arquivo desempata)
+  auto byFrame = [](const auto &a, const auto &b) { return a.frame < b.frame; };
+  std::stable_sort(anim.cameraKeys.begin(), anim.cameraKeys.end(), byFrame);
+  for (auto &keys : anim.cubeKeys)
+    std::stable_sort(keys.begin(), keys.end(), byFrame);
+  camera.aspect = static_cast<double>(anim.width) / anim.height;
+  return true;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "Scene.h"
+#include <istream>
+#include <string>
+#include <vector>
+
+// Cena animada por keyframes, usada pelo render em lote (render_batch).
+// Camera (eye/center) e cubos (posicao, rotacao, escala) sao interpolados
+// linearmente entre keyframes; antes do primeiro e depois do ultimo o valor
+// fica parado. Cubos sem keyframes usam o estado da cena base.
+//
+// Formato texto, uma diretiva por linha ('#' inicia comentario):
+//   size W H                  resolucao (padrao 640 480; lado ate 16384,
+//                             ate 8192x8192 pixels)
+//   frames N                  numero de frames (padrao 1; ate 1000000)
+//   fps N                     quadros por segundo (Y4M; padrao 30; ate 1000)
+//   shading phong|flat        (padrao phong)
+//   background RRGGBB         cor de fundo em hexadecimal
+//   camera ex ey ez cx cy cz [fov near far]
+//   light x y z r g b intensity [range]
+//   cube x y z rx ry rz scale r g b ka kd ks
+//   camkey FRAME ex ey ez cx cy cz
+//   cubekey CUBE FRAME x y z rx ry rz scale
+// Cubos sao numerados na ordem em que aparecem, a partir de 0.
+// W x H x N fica limitado a 2^40 pixels no total.
+
+struct CameraKey {
+  int frame;
+  Vec3 eye, center;
+};
+
+struct CubeKey {
+  int frame;
+  Vec3 position, rotation;
+  double scale;
+};
+
+struct Animation {
+  Scene base; // cena sem keyframes aplicados
+  int width{640}, height{480};
+  int frameCount{1};
+  int fps{30};
+  bool usePhong{true};
+  uint32_t background{0xff1a1a1a};
+  std::vector<CameraKey> cameraKeys;          // em ordem de frame
+  std::vector<std::vector<CubeKey>> cubeKeys; // por cubo, em ordem de frame
+
+  // Cena do frame `frame` em `out` (reaproveita a memoria de `out`)
+  void sceneAt(int frame, Scene &out) const;
+
+  // Retornam false com a mensagem (e linha) do primeiro erro
+  static bool parse(std::istream &in, Animation &anim, std::string &error);
+  static bool load(const std::string &path, Animation &anim,
+                   std::string &error);
+};
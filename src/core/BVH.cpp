@@ -0,0 +1,230 @@
+#include "BVH.h"
+#include <algorithm>
+#include <cmath>
+
+// Meia diagonal do cubo unitario escalado: |s| * sqrt(3) / 2
+static double cubeRadius(const Cube &cube) {
+  return std::abs(cube.scale) * 0.8660254037844386;
+}
+
+AABB CubeBVH::cubeBounds(const Cube &cube) {
+  return itemBounds(Item{cube.position, cubeRadius(cube), 0});
+}
+
+AABB CubeBVH::itemBounds(const Item &item) {
+  const Vec3 &c = item.center;
+  double r = item.radius;
+  AABB box;
+  box.min = Vec3{c.x - r, c.y - r, c.z - r};
+  box.max = Vec3{c.x + r, c.y + r, c.z + r};
+  return box;
+}
+
+// Area da superficie da caixa (custo esperado de visitar o no)
+static double surfaceArea(const AABB &box) {
+  Vec3 d = box.max - box.min;
+  return 2.0 * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+// Espalha os 10 bits baixos de v: bit k vai para a posicao 3k
+static uint32_t spreadBits(uint32_t v) {
+  v &= 0x3ff;
+  v = (v | (v << 16)) & 0x030000ff;
+  v = (v | (v << 8)) & 0x0300f00f;
+  v = (v | (v << 4)) & 0x030c30c3;
+  v = (v | (v << 2)) & 0x09249249;
+  return v;
+}
+
+// Radix sort LSD estavel pelo codigo de Morton (30 bits, 3 passadas de 10)
+void CubeBVH::radixSortKeys() {
+  size_t n = keys.size();
+  scratch.resize(n);
+  for (int shift = 32; shift < 62; shift += 10) {
+    uint32_t offsets[1025] = {};
+    for (uint64_t key : keys)
+      ++offsets[((key >> shift) & 1023) + 1];
+    for (int b = 0; b < 1024; ++b)
+      offsets[b + 1] += offsets[b];
+    for (uint64_t key : keys)
+      scratch[offsets[(key >> shift) & 1023]++] = key;
+    keys.swap(scratch);
+  }
+}
+
+void CubeBVH::build(const std::vector<Cube> &cubes) {
+  int n = static_cast<int>(cubes.size());
+  nodes.clear();
+  parents.clear();
+  items.resize(n);
+  itemOf.resize(n);
+  leafOf.resize(n);
+  if (n == 0)
+    return;
+
+  AABB centroids;
+  for (const Cube &cube : cubes)
+    centroids.expand(cube.position);
+  Vec3 size = centroids.max - centroids.min;
+  auto scaleOf = [](double s) { return s > 0 ? 1023.0 / s : 0.0; };
+  Vec3 scale{scaleOf(size.x), scaleOf(size.y), scaleOf(size.z)};
+
+  // Ordena os cubos pela curva de Morton dos centros: vizinhos na ordem
+  // ficam proximos no espaco, entao dividir a sequencia ao meio ja da uma
+  // boa hierarquia (sem particionar a cada nivel)
+  keys.resize(n);
+  for (int i = 0; i < n; ++i) {
+    Vec3 p = cubes[i].position - centroids.min;
+    uint32_t code = (spreadBits(uint32_t(p.x * scale.x)) << 2) |
+                    (spreadBits(uint32_t(p.y * scale.y)) << 1) |
+                    spreadBits(uint32_t(p.z * scale.z));
+    keys[i] = (uint64_t(code) << 32) | uint32_t(i);
+  }
+  radixSortKeys();
+
+  for (int i = 0; i < n; ++i) {
+    int c = int(uint32_t(keys[i]));
+    items[i] = Item{cubes[c].position, cubeRadius(cubes[c]), c};
+    itemOf[c] = i;
+  }
+  nodes.reserve(2 * (n / LEAF_SIZE + 1));
+  parents.reserve(nodes.capacity());
+  buildRange(-1, 0, n);
+  leafArea = 0.0;
+  for (const Node &node : nodes)
+    if (node.count > 0)
+      leafArea += surfaceArea(node.bounds);
+  builtLeafArea = leafArea;
+}
+
+int CubeBVH::buildRange(int parent, int begin, int end) {
+  int index = static_cast<int>(nodes.size());
+  nodes.push_back({});
+  parents.push_back(parent);
+
+  if (end - begin <= LEAF_SIZE) {
+    nodes[index] = {AABB{}, begin, end - begin};
+    for (int i = begin; i < end; ++i)
+      leafOf[i] = index;
+    nodes[index].bounds = nodeBounds(nodes[index]);
+    return index;
+  }
+
+  // Esquerdo logo apos o no, direito depois da subarvore esquerda;
+  // a caixa do no e a uniao das caixas dos filhos
+  int mid = begin + (end - begin) / 2;
+  int left = buildRange(index, begin, mid);
+  int right = buildRange(index, mid, end);
+  nodes[index] = {AABB{}, left, -right};
+  nodes[index].bounds = nodeBounds(nodes[index]);
+  return index;
+}
+
+AABB CubeBVH::nodeBounds(const Node &node) const {
+  AABB bounds;
+  if (node.count > 0) {
+    for (int i = node.first; i < node.first + node.count; ++i)
+      bounds.expand(itemBounds(items[i]));
+  } else {
+    bounds = nodes[node.first].bounds;
+    bounds.expand(nodes[-node.count].bounds);
+  }
+  return bounds;
+}
+
+static bool sameBox(const AABB &a, const AABB &b) {
+  return a.min.x == b.min.x && a.min.y == b.min.y && a.min.z == b.min.z &&
+         a.max.x == b.max.x && a.max.y == b.max.y && a.max.z == b.max.z;
+}
+
+void CubeBVH::update(const std::vector<Cube> &cubes,
+                     const std::vector<int> *changed) {
+  if (cubes.size() != items.size() || nodes.empty()) {
+    build(cubes);
+    return;
+  }
+
+  if (!changed) {
+    // Todos os itens; os filhos vem depois do pai (pre-ordem), entao de tras
+    // para frente cada no ja encontra os filhos prontos
+    for (Item &item : items) {
+      item.center = cubes[item.cube].position;
+      item.radius = cubeRadius(cubes[item.cube]);
+    }
+    leafArea = 0.0;
+    for (int i = nodeCount() - 1; i >= 0; --i) {
+      nodes[i].bounds = nodeBounds(nodes[i]);
+      if (nodes[i].count > 0)
+        leafArea += surfaceArea(nodes[i].bounds);
+    }
+  } else {
+    // So os cubos alterados: a folha de cada um e os ancestrais, parando no
+    // primeiro no cuja caixa nao mudou (os de cima ja estao certos)
+    for (int c : *changed) {
+      Item &item = items[itemOf[c]];
+      item.center = cubes[c].position;
+      item.radius = cubeRadius(cubes[c]);
+    }
+    for (int c : *changed) {
+      for (int n = leafOf[itemOf[c]]; n >= 0; n = parents[n]) {
+        AABB bounds = nodeBounds(nodes[n]);
+        if (sameBox(bounds, nodes[n].bounds))
+          break;
+        if (nodes[n].count > 0)
+          leafArea += surfaceArea(bounds) - surfaceArea(nodes[n].bounds);
+        nodes[n].bounds = bounds;
+      }
+    }
+  }
+
+  // Caixas espalhadas demais (cubos que andaram para longe dos vizinhos da
+  // ordem de Morton): a hierarquia nova sai mais barata que continuar
+  if (leafArea > REBUILD_GROWTH * builtLeafArea) {
+    build(cubes);
+    ++rebuilds;
+  }
+}
+
+void CubeBVH::cull(const Frustum &frustum, std::vector<int> &visible) const {
+  cull(frustum, visible, cullScratch);
+}
+
+void CubeBVH::cull(const Frustum &frustum, std::vector<int> &visible,
+                   CullScratch &scratch) const {
+  std::vector<int> &stack = scratch.stack;
+  visible.clear();
+  if (nodes.empty())
+    return;
+
+  // Pilha de pares (no, planos ainda a testar)
+  stack.clear();
+  stack.push_back(0);
+  stack.push_back(0x3f);
+  while (!stack.empty()) {
+    unsigned mask = static_cast<unsigned>(stack.back());
+    stack.pop_back();
+    int index = stack.back();
+    stack.pop_back();
+    const Node &node = nodes[index];
+
+    if (mask && !frustum.testAABB(node.bounds, mask))
+      continue;
+
+    if (node.count > 0) {
+      for (int i = node.first; i < node.first + node.count; ++i) {
+        unsigned itemMask = mask;
+        if (!itemMask || frustum.testAABB(itemBounds(items[i]), itemMask))
+          visible.push_back(items[i].cube);
+      }
+    } else {
+      stack.push_back(node.first);
+      stack.push_back(static_cast<int>(mask));
+      stack.push_back(-node.count);
+      stack.push_back(static_cast<int>(mask));
+    }
+  }
+
+  // Ordem crescente preserva a ordem de submissao dos cubos; cada cubo
+  // esta numa so folha, entao so os visiveis sao ordenados
+  std::sort(visible.begin(), visible.end());
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include "../math/Frustum.h"
+#include "Cube.h"
+#include <cstdint>
+#include <vector>
+
+// Hierarquia de volumes envolventes (BVH) sobre os cubos da cena.
+// Usada para rejeitar grupos inteiros de cubos fora do frustum: o custo do
+// culling acompanha o que esta visivel, nao o tamanho da cena.
+class CubeBVH {
+public:
+  // Caixa do cubo: esfera envolvente (meia diagonal) em volta da posicao,
+  // valida para qualquer rotacao e barata (sem trigonometria)
+  static AABB cubeBounds(const Cube &cube);
+
+  // Constroi a hierarquia (ordem de Morton dividida ao meio)
+  void build(const std::vector<Cube> &cubes);
+  // Acompanha a cena entre frames: com o mesmo numero de cubos da ultima
+  // construcao so reajusta as caixas (refit) e mantem a hierarquia.
+  // `changed`: indices dos unicos cubos que mudaram desde a chamada
+  // anterior (so as caixas deles e dos ancestrais sao refeitas); sem ele
+  // todas sao. Cubos que andam alargam as caixas (a ordem e a da
+  // construcao) e o culling visita mais nos: quando a soma das areas das
+  // folhas passa de REBUILD_GROWTH vezes a da construcao, ou o numero de
+  // cubos muda, reconstroi.
+  void update(const std::vector<Cube> &cubes,
+              const std::vector<int> *changed = nullptr);
+
+  // Memoria de trabalho do culling
+  struct CullScratch {
+    std::vector<int> stack;
+  };
+
+  // Indices (em ordem crescente) dos cubos que tocam o frustum
+  void cull(const Frustum &frustum, std::vector<int> &visible) const;
+  // Com memoria do chamador: varias threads podem fazer culling na mesma
+  // BVH ao mesmo tempo (uma vista por thread no multi-view)
+  void cull(const Frustum &frustum, std::vector<int> &visible,
+            CullScratch &scratch) const;
+
+  int nodeCount() const { return static_cast<int>(nodes.size()); }
+  // Reconstrucoes que update() fez porque as caixas cresceram demais
+  int rebuildCount() const { return rebuilds; }
+
+private:
+  struct Node {
+    AABB bounds;
+    int first; // folha: primeiro item; interno: filho esquerdo
+    int count; // folha: numero de itens; interno: -(filho direito)
+  };
+
+  // Item da construcao: centro e raio juntos do indice, para o
+  // particionamento nao precisar de acesso indireto
+  struct Item {
+    Vec3 center;
+    double radius;
+    int cube;
+  };
+
+  static constexpr int LEAF_SIZE = 4;
+  // Crescimento da area das folhas (refit) que dispara a reconstrucao
+  static constexpr double REBUILD_GROWTH = 2.0;
+
+  void radixSortKeys();
+  int buildRange(int parent, int begin, int end);
+  static AABB itemBounds(const Item &item);
+  // Caixa do no a partir dos itens (folha) ou dos filhos
+  AABB nodeBounds(const Node &node) const;
+
+  std::vector<Node> nodes;
+  std::vector<int> parents;    // por no (-1 na raiz)
+  std::vector<Item> items;     // agrupados por folha
+  std::vector<int> itemOf;     // por cubo: posicao em items
+  std::vector<int> leafOf;     // por item: folha que o contem
+  std::vector<uint64_t> keys; // (codigo de Morton << 32) | indice do cubo
+  std::vector<uint64_t> scratch;
+  // Soma das areas das caixas das folhas: na construcao e atual
+  double builtLeafArea{0.0}, leafArea{0.0};
+  int rebuilds{0};
+  mutable CullScratch cullScratch; // da versao sem memoria do chamador
+};
@@ -1,17 +1,37 @@
 #pragma once
 #include "../math/Vector.h"
+#include <algorithm>
+
+// Atenuacao pela distancia: janela (1 - d²/r²)², 1 no centro e 0 a partir
+// do alcance. invRange2 = 1/r² (0 = alcance infinito, atenuacao 1).
+// Mesma formula (e ordem de operacoes) nos kernels de shading.
+inline double rangeAttenuation(double dist2, double invRange2) {
+    double f = std::max(1.0 - dist2 * invRange2, 0.0);
+    return f * f;
+}
 
 // Estrutura de luz pontual
 struct Light {
     Vec3 position;      // Posição da luz no espaço mundo
     Vec3 color;         // Cor da luz (RGB em [0,1])
     double intensity;   // Intensidade da luz (multiplicador)
+    double range;       // Alcance (0 = infinito); fora dele a luz nao contribui
+    bool castShadows{true}; // com RenderOptions::shadows, ganha shadow map
     
     // Construtor padrão
-    Light() : position{0, 0, 0}, color{1, 1, 1}, intensity{1.0} {}
+    Light() : position{0, 0, 0}, color{1, 1, 1}, intensity{1.0}, range{0.0} {}
     
     // Construtor com parâmetros
-    Light(const Vec3& pos, const Vec3& col, double intens = 1.0)
-        : position(pos), color(col), intensity(intens) {}
+    Light(const Vec3& pos, const Vec3& col, double intens = 1.0,
+          double rng = 0.0)
+        : position(pos), color(col), intensity(intens), range(rng) {}
+
+    double invRange2() const { return range > 0 ? 1.0 / (range * range) : 0.0; }
+
+    // Fator de atenuacao num ponto do mundo
+    double attenuation(const Vec3& p) const {
+        double dx = position.x - p.x, dy = position.y - p.y, dz = position.z - p.z;
+        return rangeAttenuation(dx * dx + dy * dy + dz * dz, invRange2());
+    }
 };
 
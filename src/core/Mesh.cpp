@@ -0,0 +1,482 @@
+#include "Mesh.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// ============ FORMATO BINARIO ============
+
+namespace {
+
+struct MeshFileHeader {
+  char magic[8];     // "RMESH\0\0\0"
+  uint32_t version;  // MESH_FILE_VERSION
+  uint32_t byteOrder; // MESH_BYTE_ORDER na ordem de quem gravou
+  uint32_t vertexCount;
+  uint32_t triangleCount;
+  float boundsMin[3];
+  float boundsMax[3];
+  uint64_t positionsOffset; // bytes desde o inicio do arquivo
+  uint64_t normalsOffset;
+  uint64_t indicesOffset;
+};
+static_assert(sizeof(MeshFileHeader) == 72, "cabecalho .rmesh mudou");
+
+constexpr char MESH_MAGIC[8] = {'R', 'M', 'E', 'S', 'H', 0, 0, 0};
+constexpr uint32_t MESH_FILE_VERSION = 1;
+constexpr uint32_t MESH_BYTE_ORDER = 0x01020304;
+constexpr uint64_t MESH_ALIGN = 64;
+
+uint64_t alignUp(uint64_t v) { return (v + MESH_ALIGN - 1) / MESH_ALIGN * MESH_ALIGN; }
+
+} // namespace
+
+Mesh::~Mesh() {
+  if (!mapping)
+    return;
+#ifndef _WIN32
+  munmap(mapping, mappingSize);
+#else
+  std::free(mapping);
+#endif
+}
+
+void Mesh::adoptOwned() {
+  positionData = ownedPositions.data();
+  normalData = ownedNormals.data();
+  indexData = ownedIndices.data();
+}
+
+void Mesh::computeBounds() {
+  localBounds = AABB{};
+  for (int v = 0; v < numVertices; ++v) {
+    const float *p = &positionData[v * 3];
+    localBounds.expand(Vec3{p[0], p[1], p[2]});
+  }
+}
+
+void Mesh::computeNormals(const std::vector<uint8_t> &missing) {
+  std::vector<double> acc(static_cast<size_t>(numVertices) * 3, 0.0);
+  for (int t = 0; t < numTriangles; ++t) {
+    const uint32_t *idx = &ownedIndices[t * 3];
+    const float *a = &ownedPositions[idx[0] * 3];
+    const float *b = &ownedPositions[idx[1] * 3];
+    const float *c = &ownedPositions[idx[2] * 3];
+    Vec3 e1{double(b[0]) - a[0], double(b[1]) - a[1], double(b[2]) - a[2]};
+    Vec3 e2{double(c[0]) - a[0], double(c[1]) - a[1], double(c[2]) - a[2]};
+    Vec3 n = e1.cross(e2); // comprimento = 2 * area: pondera pela area
+    for (int k = 0; k < 3; ++k) {
+      acc[idx[k] * 3 + 0] += n.x;
+      acc[idx[k] * 3 + 1] += n.y;
+      acc[idx[k] * 3 + 2] += n.z;
+    }
+  }
+  for (int v = 0; v < numVertices; ++v) {
+    if (!missing.empty() && !missing[v])
+      continue;
+    double x = acc[v * 3], y = acc[v * 3 + 1], z = acc[v * 3 + 2];
+    double len = std::sqrt(x * x + y * y + z * z);
+    float *n = &ownedNormals[v * 3];
+    if (len > 0) {
+      n[0] = float(x / len);
+      n[1] = float(y / len);
+      n[2] = float(z / len);
+    } else {
+      n[0] = 0.0f; // vertice isolado ou so em triangulos degenerados
+      n[1] = 0.0f;
+      n[2] = 1.0f;
+    }
+  }
+}
+
+// ============ A PARTIR DE ARRAYS ============
+
+std::shared_ptr<Mesh> Mesh::fromArrays(const float *positions, int vertexCount,
+                                       const float *normals,
+                                       const uint32_t *indices,
+                                       int triangleCount, std::string &error) {
+  if (!positions || !indices || vertexCount <= 0 || triangleCount <= 0) {
+    error = "malha vazia";
+    return nullptr;
+  }
+  for (size_t i = 0; i < static_cast<size_t>(triangleCount) * 3; ++i)
+    if (indices[i] >= static_cast<uint32_t>(vertexCount)) {
+      error = "indice de vertice fora da malha";
+      return nullptr;
+    }
+  std::shared_ptr<Mesh> mesh(new Mesh());
+  mesh->numVertices = vertexCount;
+  mesh->numTriangles = triangleCount;
+  const size_t vertexFloats = static_cast<size_t>(vertexCount) * 3;
+  mesh->ownedPositions.assign(positions, positions + vertexFloats);
+  mesh->ownedIndices.assign(indices,
+                            indices + static_cast<size_t>(triangleCount) * 3);
+  if (normals)
+    mesh->ownedNormals.assign(normals, normals + vertexFloats);
+  else {
+    mesh->ownedNormals.resize(vertexFloats);
+    mesh->computeNormals({});
+  }
+  mesh->adoptOwned();
+  mesh->computeBounds();
+  return mesh;
+}
+
+// ============ OBJ ============
+
+// Le o arquivo inteiro (terminado em '\0' para strtof/strtol)
+static bool readFile(const std::string &path, std::string &data,
+                     std::string &error) {
+  std::FILE *f = std::fopen(path.c_str(), "rb");
+  if (!f) {
+    error = "nao foi possivel abrir " + path;
+    return false;
+  }
+  std::fseek(f, 0, SEEK_END);
+  long size = std::ftell(f);
+  std::fseek(f, 0, SEEK_SET);
+  data.resize(size > 0 ? static_cast<size_t>(size) : 0);
+  bool ok = size >= 0 && std::fread(&data[0], 1, data.size(), f) == data.size();
+  std::fclose(f);
+  if (!ok)
+    error = "erro ao ler " + path;
+  return ok;
+}
+
+static inline const char *skipSpaces(const char *p) {
+  while (*p == ' ' || *p == '\t' || *p == '\r')
+    ++p;
+  return p;
+}
+
+// Indice OBJ (1-based, negativo = relativo ao fim) para 0-based; -1 se
+// invalido
+static long objIndex(long value, size_t count) {
+  if (value > 0)
+    return value <= (long)count ? value - 1 : -1;
+  if (value < 0)
+    return -value <= (long)count ? (long)count + value : -1;
+  return -1;
+}
+
+std::shared_ptr<Mesh> Mesh::loadObj(const std::string &path,
+                                    std::string &error) {
+  std::string data;
+  if (!readFile(path, data, error))
+    return nullptr;
+
+  std::vector<float> positions, normals;
+  // Cantos das faces: (posicao, normal ou -1)
+  std::vector<std::pair<long, long>> corners;
+  std::vector<std::pair<long, long>> face;
+  bool anyNormalIndex = false;
+
+  const char *p = data.c_str();
+  int lineNo = 0;
+  auto fail = [&](const char *msg) -> std::shared_ptr<Mesh> {
+    error = path + ":" + std::to_string(lineNo) + ": " + msg;
+    return nullptr;
+  };
+
+  while (*p) {
+    ++lineNo;
+    const char *line = skipSpaces(p);
+    const char *end = std::strchr(line, '\n');
+    if (!end)
+      end = line + std::strlen(line);
+    p = *end ? end + 1 : end;
+
+    if (line[0] == 'v' && (line[1] == ' ' || line[1] == '\t')) {
+      char *q = const_cast<char *>(line + 2);
+      for (int k = 0; k < 3; ++k) {
+        char *next;
+        float v = std::strtof(q, &next);
+        if (next == q || next > end)
+          return fail("vertice com menos de 3 coordenadas");
+        positions.push_back(v);
+        q = next;
+      }
+    } else if (line[0] == 'v' && line[1] == 'n' &&
+               (line[2] == ' ' || line[2] == '\t')) {
+      char *q = const_cast<char *>(line + 3);
+      for (int k = 0; k < 3; ++k) {
+        char *next;
+        float v = std::strtof(q, &next);
+        if (next == q || next > end)
+          return fail("normal com menos de 3 coordenadas");
+        normals.push_back(v);
+        q = next;
+      }
+    } else if (line[0] == 'f' && (line[1] == ' ' || line[1] == '\t')) {
+      face.clear();
+      const char *q = skipSpaces(line + 2);
+      while (q < end && *q != '\n' && *q != '#') {
+        char *next;
+        long v = std::strtol(q, &next, 10);
+        if (next == q)
+          return fail("face invalida");
+        long vn = 0;
+        q = next;
+        if (*q == '/') {
+          ++q;
+          if (*q != '/') {
+            std::strtol(q, &next, 10); // vt, ignorado
+            q = next;
+          }
+          if (*q == '/') {
+            ++q;
+            vn = std::strtol(q, &next, 10);
+            if (next == q)
+              return fail("face invalida");
+            q = next;
+          }
+        }
+        long pi = objIndex(v, positions.size() / 3);
+        long ni = vn ? objIndex(vn, normals.size() / 3) : -1;
+        if (pi < 0 || (vn && ni < 0))
+          return fail("indice de face fora do arquivo");
+        anyNormalIndex |= ni >= 0;
+        face.emplace_back(pi, ni);
+        q = skipSpaces(q);
+      }
+      if (face.size() < 3)
+        return fail("face com menos de 3 vertices");
+      for (size_t k = 1; k + 1 < face.size(); ++k) {
+        corners.push_back(face[0]);
+        corners.push_back(face[k]);
+        corners.push_back(face[k + 1]);
+      }
+    }
+  }
+  if (corners.empty()) {
+    error = path + ": nenhuma face";
+    return nullptr;
+  }
+  if (positions.size() / 3 > UINT32_MAX || corners.size() / 3 > INT32_MAX) {
+    error = path + ": malha grande demais";
+    return nullptr;
+  }
+
+  std::shared_ptr<Mesh> mesh(new Mesh());
+  Mesh &m = *mesh;
+  m.numTriangles = static_cast<int>(corners.size() / 3);
+  m.ownedIndices.resize(corners.size());
+  std::vector<uint8_t> missing;
+
+  if (!anyNormalIndex) {
+    // Sem normais no arquivo: vertice = posicao, normais calculadas
+    m.ownedPositions = std::move(positions);
+    m.numVertices = static_cast<int>(m.ownedPositions.size() / 3);
+    for (size_t k = 0; k < corners.size(); ++k)
+      m.ownedIndices[k] = static_cast<uint32_t>(corners[k].first);
+    m.ownedNormals.resize(m.ownedPositions.size());
+  } else {
+    // Um vertice por par (posicao, normal) distinto
+    std::unordered_map<uint64_t, uint32_t> unique;
+    unique.reserve(positions.size() / 3 * 2);
+    for (size_t k = 0; k < corners.size(); ++k) {
+      uint64_t key = (uint64_t(corners[k].first) << 32) |
+                     uint32_t(corners[k].second + 1);
+      auto it = unique.emplace(key, static_cast<uint32_t>(unique.size()));
+      if (it.second) {
+        const float *pos = &positions[corners[k].first * 3];
+        m.ownedPositions.insert(m.ownedPositions.end(), pos, pos + 3);
+        if (corners[k].second >= 0) {
+          const float *n = &normals[corners[k].second * 3];
+          m.ownedNormals.insert(m.ownedNormals.end(), n, n + 3);
+          missing.push_back(0);
+        } else {
+          m.ownedNormals.insert(m.ownedNormals.end(), {0.0f, 0.0f, 0.0f});
+          missing.push_back(1);
+        }
+      }
+      m.ownedIndices[k] = it.first->second;
+    }
+    m.numVertices = static_cast<int>(unique.size());
+  }
+
+  // Normais calculadas so onde o arquivo nao tem
+  bool anyMissing = !anyNormalIndex;
+  for (uint8_t f : missing)
+    anyMissing |= f != 0;
+  if (anyMissing)
+    m.computeNormals(missing);
+  else
+    for (size_t v = 0; v < m.ownedNormals.size(); v += 3) {
+      float *n = &m.ownedNormals[v];
+      float len = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+      if (len > 0) {
+        n[0] /= len;
+        n[1] /= len;
+        n[2] /= len;
+      }
+    }
+  m.adoptOwned();
+  m.computeBounds();
+  return mesh;
+}
+
+// ============ BINARIO (.rmesh) ============
+
+bool Mesh::saveBinary(const std::string &path, std::string &error) const {
+  MeshFileHeader h{};
+  std::memcpy(h.magic, MESH_MAGIC, sizeof(MESH_MAGIC));
+  h.version = MESH_FILE_VERSION;
+  h.byteOrder = MESH_BYTE_ORDER;
+  h.vertexCount = static_cast<uint32_t>(numVertices);
+  h.triangleCount = static_cast<uint32_t>(numTriangles);
+  h.boundsMin[0] = float(localBounds.min.x);
+  h.boundsMin[1] = float(localBounds.min.y);
+  h.boundsMin[2] = float(localBounds.min.z);
+  h.boundsMax[0] = float(localBounds.max.x);
+  h.boundsMax[1] = float(localBounds.max.y);
+  h.boundsMax[2] = float(localBounds.max.z);
+  const uint64_t vertexBytes = uint64_t(numVertices) * 3 * sizeof(float);
+  const uint64_t indexBytes = uint64_t(numTriangles) * 3 * sizeof(uint32_t);
+  h.positionsOffset = alignUp(sizeof(h));
+  h.normalsOffset = alignUp(h.positionsOffset + vertexBytes);
+  h.indicesOffset = alignUp(h.normalsOffset + vertexBytes);
+
+  std::FILE *f = std::fopen(path.c_str(), "wb");
+  if (!f) {
+    error = "nao foi possivel criar " + path;
+    return false;
+  }
+  static const char zeros[MESH_ALIGN] = {};
+  uint64_t written = 0;
+  auto put = [&](uint64_t offset, const void *data, uint64_t size) {
+    bool ok = std::fwrite(zeros, 1, offset - written, f) == offset - written &&
+              std::fwrite(data, 1, size, f) == size;
+    written = offset + size;
+    return ok;
+  };
+  bool ok = put(0, &h, sizeof(h)) &&
+            put(h.positionsOffset, positionData, vertexBytes) &&
+            put(h.normalsOffset, normalData, vertexBytes) &&
+            put(h.indicesOffset, indexData, indexBytes);
+  ok = std::fclose(f) == 0 && ok;
+  if (!ok)
+    error = "erro ao gravar " + path;
+  return ok;
+}
+
+std::shared_ptr<Mesh> Mesh::loadBinary(const std::string &path,
+                                       std::string &error) {
+  void *base = nullptr;
+  size_t size = 0;
+#ifndef _WIN32
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    error = "nao foi possivel abrir " + path;
+    return nullptr;
+  }
+  struct stat st;
+  if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(MeshFileHeader)) {
+    size = static_cast<size_t>(st.st_size);
+    base = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (base == MAP_FAILED)
+      base = nullptr;
+  }
+  ::close(fd); // o mapeamento continua valido
+#else
+  // Sem mmap: le o arquivo inteiro (mesmo layout em memoria)
+  std::string data;
+  if (!readFile(path, data, error))
+    return nullptr;
+  if (data.size() >= sizeof(MeshFileHeader)) {
+    size = data.size();
+    base = std::malloc(size);
+    if (base)
+      std::memcpy(base, data.data(), size);
+  }
+#endif
+  if (!base) {
+    error = path + ": arquivo .rmesh invalido";
+    return nullptr;
+  }
+
+  std::shared_ptr<Mesh> mesh(new Mesh());
+  mesh->mapping = base; // liberado pelo destrutor em qualquer erro abaixo
+  mesh->mappingSize = size;
+
+  MeshFileHeader h;
+  std::memcpy(&h, base, sizeof(h));
+  if (std::memcmp(h.magic, MESH_MAGIC, sizeof(MESH_MAGIC)) != 0 ||
+      h.version != MESH_FILE_VERSION) {
+    error = path + ": nao e um arquivo .rmesh (versao " +
+            std::to_string(MESH_FILE_VERSION) + ")";
+    return nullptr;
+  }
+  if (h.byteOrder != MESH_BYTE_ORDER) {
+    error = path + ": gravado com outra ordem de bytes";
+    return nullptr;
+  }
+  const uint64_t vertexBytes = uint64_t(h.vertexCount) * 3 * sizeof(float);
+  const uint64_t indexBytes = uint64_t(h.triangleCount) * 3 * sizeof(uint32_t);
+  auto fits = [&](uint64_t offset, uint64_t bytes) {
+    return offset % alignof(float) == 0 && offset <= size &&
+           bytes <= size - offset;
+  };
+  if (h.vertexCount == 0 || h.triangleCount == 0 ||
+      h.vertexCount > INT32_MAX || h.triangleCount > INT32_MAX ||
+      !fits(h.positionsOffset, vertexBytes) ||
+      !fits(h.normalsOffset, vertexBytes) ||
+      !fits(h.indicesOffset, indexBytes)) {
+    error = path + ": cabecalho .rmesh inconsistente";
+    return nullptr;
+  }
+
+  const char *bytes = static_cast<const char *>(base);
+  mesh->numVertices = static_cast<int>(h.vertexCount);
+  mesh->numTriangles = static_cast<int>(h.triangleCount);
+  mesh->positionData = reinterpret_cast<const float *>(bytes + h.positionsOffset);
+  mesh->normalData = reinterpret_cast<const float *>(bytes + h.normalsOffset);
+  mesh->indexData = reinterpret_cast<const uint32_t *>(bytes + h.indicesOffset);
+  mesh->localBounds.min = Vec3{h.boundsMin[0], h.boundsMin[1], h.boundsMin[2]};
+  mesh->localBounds.max = Vec3{h.boundsMax[0], h.boundsMax[1], h.boundsMax[2]};
+  return mesh;
+}
+
+std::shared_ptr<Mesh> Mesh::load(const std::string &path, std::string &error) {
+  auto endsWith = [&](const char *ext) {
+    size_t n = std::strlen(ext);
+    return path.size() >= n && path.compare(path.size() - n, n, ext) == 0;
+  };
+  if (endsWith(".rmesh"))
+    return loadBinary(path, error);
+  if (endsWith(".obj"))
+    return loadObj(path, error);
+  error = path + ": extensao desconhecida (use .obj ou .rmesh)";
+  return nullptr;
+}
+
+// ============ INSTANCIA ============
+
+Mat4 MeshInstance::modelMatrix() const {
+  return Mat4::scale(scale) * Mat4::rotationX(rotation.x) *
+         Mat4::rotationY(rotation.y) * Mat4::rotationZ(rotation.z) *
+         Mat4::translation(position);
+}
+
+AABB MeshInstance::worldBounds() const {
+  AABB box;
+  if (!mesh)
+    return box;
+  const AABB &local = mesh->bounds();
+  Mat4 model = modelMatrix();
+  for (int c = 0; c < 8; ++c) {
+    Vec4 p{c & 1 ? local.max.x : local.min.x, c & 2 ? local.max.y : local.min.y,
+           c & 4 ? local.max.z : local.min.z, 1.0};
+    Vec4 w = model * p;
+    box.expand(Vec3{w.x, w.y, w.z});
+  }
+  return box;
+}
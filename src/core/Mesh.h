@@ -0,0 +1,87 @@
+#pragma once
+#include "../math/Frustum.h"
+#include "Cube.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Malha indexada de triangulos: posicoes e normais por vertice (float xyz)
+// e 3 indices por triangulo (anti-horario visto de fora = frente).
+// Os buffers sao da propria malha (OBJ, arrays) ou ficam direto num
+// arquivo .rmesh mapeado em memoria: abrir o arquivo so le o cabecalho e o
+// sistema carrega as paginas sob demanda, sem copia nem parsing.
+//
+// Formato .rmesh (ordem de bytes da maquina, conferida pelo cabecalho):
+//   MeshFileHeader | posicoes (float[3*V]) | normais (float[3*V]) |
+//   indices (uint32[3*T]), cada bloco alinhado em 64 bytes.
+// Indices nao sao validados na abertura; o Renderer descarta triangulos
+// com indice fora da malha.
+class Mesh {
+public:
+  ~Mesh();
+  Mesh(const Mesh &) = delete;
+  Mesh &operator=(const Mesh &) = delete;
+
+  int vertexCount() const { return numVertices; }
+  int triangleCount() const { return numTriangles; }
+  const float *positions() const { return positionData; }
+  const float *normals() const { return normalData; }
+  const uint32_t *indices() const { return indexData; }
+  // Caixa em espaco do objeto
+  const AABB &bounds() const { return localBounds; }
+  // Arquivo mapeado (.rmesh) em vez de buffers proprios
+  bool isMapped() const { return mapping != nullptr; }
+
+  // Copia os arrays; sem `normals` as normais sao suaves (media das faces
+  // ponderada pela area). Retornam nullptr com a mensagem em `error`.
+  static std::shared_ptr<Mesh> fromArrays(const float *positions,
+                                          int vertexCount,
+                                          const float *normals,
+                                          const uint32_t *indices,
+                                          int triangleCount,
+                                          std::string &error);
+  // Wavefront OBJ: v, vn e f (poligonos viram leques; vt e o resto sao
+  // ignorados). Vertices com o mesmo par posicao/normal sao compartilhados.
+  static std::shared_ptr<Mesh> loadObj(const std::string &path,
+                                       std::string &error);
+  static std::shared_ptr<Mesh> loadBinary(const std::string &path,
+                                          std::string &error);
+  // Pela extensao: .obj ou .rmesh
+  static std::shared_ptr<Mesh> load(const std::string &path,
+                                    std::string &error);
+
+  bool saveBinary(const std::string &path, std::string &error) const;
+
+private:
+  Mesh() = default;
+  void adoptOwned(); // aponta os ponteiros para os vetores proprios
+  void computeBounds();
+  // Normais suaves dos vertices com flag em `missing` (todos se vazio)
+  void computeNormals(const std::vector<uint8_t> &missing);
+
+  int numVertices{0}, numTriangles{0};
+  const float *positionData{nullptr};
+  const float *normalData{nullptr};
+  const uint32_t *indexData{nullptr};
+  AABB localBounds;
+
+  std::vector<float> ownedPositions, ownedNormals;
+  std::vector<uint32_t> ownedIndices;
+  void *mapping{nullptr}; // arquivo mapeado (ou lido, sem mmap)
+  size_t mappingSize{0};
+};
+
+// Instancia de uma malha na cena. Transformacao na mesma convencao do Cube
+// (escala uniforme, rotacao em X, Y, Z e translacao).
+struct MeshInstance {
+  std::shared_ptr<const Mesh> mesh;
+  Vec3 position;
+  Vec3 rotation; // em radianos
+  double scale{1.0};
+  Material material;
+
+  Mat4 modelMatrix() const;
+  // Caixa em mundo (cantos da caixa local transformados)
+  AABB worldBounds() const;
+};
@@ -2,10 +2,44 @@
 #include "Camera.h"
 #include "Cube.h"
 #include "Light.h"
+#include "Mesh.h"
 #include <vector>
 
 struct Scene {
   Camera camera;
   std::vector<Cube> cubes;
   std::vector<Light> lights;
+  std::vector<MeshInstance> meshes; // desenhadas depois dos cubos
 };
+
+// ============ COMPARACAO ============
+// Igualdade exata, campo a campo, de tudo que muda a imagem (quem compara
+// a cena com a de um frame anterior)
+
+inline bool sameVec3(const Vec3 &a, const Vec3 &b) {
+  return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+inline bool sameMaterial(const Material &a, const Material &b) {
+  return sameVec3(a.color, b.color) && a.ka == b.ka && a.kd == b.kd &&
+         a.ks == b.ks && a.shininess == b.shininess;
+}
+
+inline bool sameCube(const Cube &a, const Cube &b) {
+  return sameVec3(a.position, b.position) &&
+         sameVec3(a.rotation, b.rotation) && a.scale == b.scale &&
+         sameMaterial(a.material, b.material);
+}
+
+// Mesma malha = mesmo objeto; o conteudo de uma Mesh nao muda
+inline bool sameMesh(const MeshInstance &a, const MeshInstance &b) {
+  return a.mesh == b.mesh && sameVec3(a.position, b.position) &&
+         sameVec3(a.rotation, b.rotation) && a.scale == b.scale &&
+         sameMaterial(a.material, b.material);
+}
+
+inline bool sameLight(const Light &a, const Light &b) {
+  return sameVec3(a.position, b.position) && sameVec3(a.color, b.color) &&
+         a.intensity == b.intensity && a.range == b.range &&
+         a.castShadows == b.castShadows;
+}
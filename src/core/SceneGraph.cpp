@@ -0,0 +1,262 @@
+#include "SceneGraph.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+// Matriz local S * Rx * Ry * Rz * T (mesma de Cube::modelMatrix)
+static Mat4 trsMatrix(const Vec3 &position, const Vec3 &rotation,
+                      double scale) {
+  return Mat4::scale(scale) * Mat4::rotationX(rotation.x) *
+         Mat4::rotationY(rotation.y) * Mat4::rotationZ(rotation.z) *
+         Mat4::translation(position);
+}
+
+// Inverso de trsMatrix para uma matriz escala uniforme * rotacao * T, com
+// escala > 0 (o grafo rejeita as outras): o comprimento da linha e a escala.
+// Linha 0 de Rx*Ry*Rz = [cb*cg, cb*sg, -sb]; R[1][2] = sa*cb e
+// R[2][2] = ca*cb. Com cb ~ 0 (gimbal lock) so a + g (ou a - g) importa:
+// usa g = 0 e tira a da linha 1.
+static void decomposeTrs(const Mat4 &m, Vec3 &position, Vec3 &rotation,
+                         double &scale) {
+  scale = std::sqrt(m.m[0][0] * m.m[0][0] + m.m[0][1] * m.m[0][1] +
+                    m.m[0][2] * m.m[0][2]);
+  position = {m.m[3][0], m.m[3][1], m.m[3][2]};
+  if (scale == 0.0) {
+    rotation = {};
+    return;
+  }
+  double r[3][3];
+  for (int i = 0; i < 3; ++i)
+    for (int j = 0; j < 3; ++j)
+      r[i][j] = m.m[i][j] / scale;
+
+  double sb = std::clamp(-r[0][2], -1.0, 1.0);
+  rotation.y = std::asin(sb);
+  if (std::abs(sb) < 1.0 - 1e-12) {
+    rotation.x = std::atan2(r[1][2], r[2][2]);
+    rotation.z = std::atan2(r[0][1], r[0][0]);
+  } else {
+    double s = sb > 0 ? 1.0 : -1.0;
+    rotation.x = std::atan2(r[1][0] * s, r[1][1]);
+    rotation.z = 0.0;
+  }
+}
+
+static void checkScale(double scale) {
+  if (!(scale > 0.0))
+    throw std::invalid_argument("SceneGraph: escala deve ser > 0");
+}
+
+int SceneGraph::pushNode(int parent, const Vec3 &position,
+                         const Vec3 &rotation, double scale) {
+  if (parent < NO_PARENT || parent >= nodeCount())
+    throw std::out_of_range("SceneGraph: pai inexistente");
+  checkScale(scale);
+  Node node;
+  node.parent = parent;
+  node.position = position;
+  node.rotation = rotation;
+  node.scale = scale;
+  // Pai ja esta em `order`: no fim o filho fica depois dele
+  node.rank = static_cast<int>(order.size());
+  nodes.push_back(node);
+  order.push_back(nodeCount() - 1);
+  return nodeCount() - 1;
+}
+
+int SceneGraph::addNode(int parent, const Vec3 &position,
+                        const Vec3 &rotation, double scale) {
+  return pushNode(parent, position, rotation, scale);
+}
+
+void SceneGraph::claim(std::vector<int> &owners, int index, int node) {
+  if (static_cast<int>(owners.size()) <= index)
+    owners.resize(index + 1, -1);
+  owners[index] = node;
+}
+
+int SceneGraph::addCube(const Cube &cube, int parent) {
+  int id = pushNode(parent, cube.position, cube.rotation, cube.scale);
+  nodes[id].attachment = Attachment::Cube;
+  nodes[id].index = static_cast<int>(scene.cubes.size());
+  claim(cubeNodes, nodes[id].index, id);
+  scene.cubes.push_back(cube);
+  return id;
+}
+
+int SceneGraph::addMesh(const MeshInstance &mesh, int parent) {
+  int id = pushNode(parent, mesh.position, mesh.rotation, mesh.scale);
+  nodes[id].attachment = Attachment::Mesh;
+  nodes[id].index = static_cast<int>(scene.meshes.size());
+  claim(meshNodes, nodes[id].index, id);
+  scene.meshes.push_back(mesh);
+  return id;
+}
+
+int SceneGraph::attachCube(int cubeIndex, int parent) {
+  if (cubeIndex < 0 || cubeIndex >= static_cast<int>(scene.cubes.size()))
+    throw std::out_of_range("SceneGraph: cubo inexistente");
+  if (cubeNode(cubeIndex) >= 0)
+    throw std::invalid_argument("SceneGraph: cubo ja anexado");
+  const Cube &cube = scene.cubes[cubeIndex];
+  int id = pushNode(parent, cube.position, cube.rotation, cube.scale);
+  nodes[id].attachment = Attachment::Cube;
+  nodes[id].index = cubeIndex;
+  claim(cubeNodes, cubeIndex, id);
+  return id;
+}
+
+int SceneGraph::attachMesh(int meshIndex, int parent) {
+  if (meshIndex < 0 || meshIndex >= static_cast<int>(scene.meshes.size()))
+    throw std::out_of_range("SceneGraph: malha inexistente");
+  if (meshNode(meshIndex) >= 0)
+    throw std::invalid_argument("SceneGraph: malha ja anexada");
+  const MeshInstance &mesh = scene.meshes[meshIndex];
+  int id = pushNode(parent, mesh.position, mesh.rotation, mesh.scale);
+  nodes[id].attachment = Attachment::Mesh;
+  nodes[id].index = meshIndex;
+  claim(meshNodes, meshIndex, id);
+  return id;
+}
+
+void SceneGraph::cubeReplaced(int cubeIndex) {
+  int node = cubeNode(cubeIndex);
+  if (node >= 0)
+    markDirty(node);
+}
+
+void SceneGraph::meshReplaced(int meshIndex) {
+  int node = meshNode(meshIndex);
+  if (node >= 0)
+    markDirty(node);
+}
+
+int SceneGraph::cubeIndex(int node) const {
+  return nodes[node].attachment == Attachment::Cube ? nodes[node].index : -1;
+}
+
+int SceneGraph::meshIndex(int node) const {
+  return nodes[node].attachment == Attachment::Mesh ? nodes[node].index : -1;
+}
+
+void SceneGraph::markDirty(int node) {
+  nodes[node].localDirty = true;
+  firstDirty = std::min(firstDirty, nodes[node].rank);
+}
+
+void SceneGraph::setParent(int node, int parent) {
+  if (node < 0 || node >= nodeCount() || parent < NO_PARENT ||
+      parent >= nodeCount())
+    throw std::out_of_range("SceneGraph: no inexistente");
+  for (int p = parent; p != NO_PARENT; p = nodes[p].parent)
+    if (p == node)
+      throw std::invalid_argument("SceneGraph: ciclo na hierarquia");
+  if (nodes[node].parent == parent)
+    return;
+  nodes[node].parent = parent;
+  // Um filho pode ter ficado antes do novo pai em `order`
+  orderDirty = true;
+  markDirty(node);
+}
+
+void SceneGraph::rebuildOrder() {
+  // Profundidade de cada no (memorizada subindo ate um no ja conhecido)
+  const int count = nodeCount();
+  std::vector<int> depth(count, -1), path;
+  for (int i = 0; i < count; ++i) {
+    int n = i;
+    while (n != NO_PARENT && depth[n] < 0) {
+      path.push_back(n);
+      n = nodes[n].parent;
+    }
+    int d = n == NO_PARENT ? -1 : depth[n];
+    for (auto it = path.rbegin(); it != path.rend(); ++it)
+      depth[*it] = ++d;
+    path.clear();
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [&](int a, int b) { return depth[a] < depth[b]; });
+  for (int r = 0; r < count; ++r)
+    nodes[order[r]].rank = r;
+  orderDirty = false;
+}
+
+void SceneGraph::setPosition(int node, const Vec3 &position) {
+  nodes[node].position = position;
+  markDirty(node);
+}
+
+void SceneGraph::setRotation(int node, const Vec3 &rotation) {
+  nodes[node].rotation = rotation;
+  markDirty(node);
+}
+
+void SceneGraph::setScale(int node, double scale) {
+  checkScale(scale);
+  nodes[node].scale = scale;
+  markDirty(node);
+}
+
+void SceneGraph::setLocal(int node, const Vec3 &position,
+                          const Vec3 &rotation, double scale) {
+  checkScale(scale);
+  Node &n = nodes[node];
+  n.position = position;
+  n.rotation = rotation;
+  n.scale = scale;
+  markDirty(node);
+}
+
+void SceneGraph::writeBack(const Node &node) {
+  Vec3 position, rotation;
+  double scale;
+  if (node.parent == NO_PARENT) {
+    // Raiz: mundo = local, sem passar pela decomposicao
+    position = node.position;
+    rotation = node.rotation;
+    scale = node.scale;
+  } else {
+    decomposeTrs(node.world, position, rotation, scale);
+  }
+  auto apply = [&](auto &target) {
+    target.position = position;
+    target.rotation = rotation;
+    target.scale = scale;
+  };
+  if (node.attachment == Attachment::Cube &&
+      node.index < static_cast<int>(scene.cubes.size()))
+    apply(scene.cubes[node.index]);
+  else if (node.attachment == Attachment::Mesh &&
+           node.index < static_cast<int>(scene.meshes.size()))
+    apply(scene.meshes[node.index]);
+}
+
+int SceneGraph::update() {
+  if (orderDirty) {
+    rebuildOrder();
+    firstDirty = 0; // as posicoes mudaram
+  }
+  int recomputed = 0;
+  int count = nodeCount();
+  for (int r = firstDirty; r < count; ++r) {
+    Node &node = nodes[order[r]];
+    bool parentChanged =
+        node.parent != NO_PARENT && nodes[node.parent].worldChanged;
+    node.worldChanged = node.localDirty || parentChanged;
+    if (!node.worldChanged)
+      continue;
+    if (node.localDirty)
+      node.local = trsMatrix(node.position, node.rotation, node.scale);
+    node.world = node.parent == NO_PARENT
+                     ? node.local
+                     : node.local * nodes[node.parent].world;
+    node.localDirty = false;
+    writeBack(node);
+    ++recomputed;
+  }
+  // So nos a partir de firstDirty podem ter worldChanged ligado
+  for (int r = firstDirty; r < count; ++r)
+    nodes[order[r]].worldChanged = false;
+  firstDirty = count;
+  return recomputed;
+}
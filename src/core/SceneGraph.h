@@ -0,0 +1,115 @@
+#pragma once
+#include "Scene.h"
+#include <vector>
+
+// Grafo de cena: hierarquia pai/filho de transformacoes sobre os cubos e
+// malhas de uma Scene. Cada no tem uma transformacao local na convencao do
+// Cube (escala uniforme, rotacao em X, Y, Z e translacao) e guarda em cache
+// as matrizes local e de mundo (mundo = local * mundo do pai, linha-vetor).
+// Alterar um no so o marca como sujo; update() recalcula apenas os nos sujos
+// e seus descendentes e escreve na cena so os cubos/malhas que mudaram, de
+// modo que o RenderContext incremental ve exatamente o que se moveu.
+//
+// update() percorre os nos em ordem de profundidade (pai antes dos filhos),
+// entao uma unica passada propaga as mudancas; a ordem so e refeita quando
+// um no troca de pai. A composicao de escalas uniformes positivas e
+// rotacoes continua sendo escala uniforme + rotacao, e a transformacao de
+// mundo e gravada de volta como posicao/rotacao/escala. Escalas <= 0
+// (espelhamento) nao sao aceitas: a decomposicao perderia o sinal.
+//
+// O RenderContext tem um grafo sobre a sua cena e chama update() antes de
+// cada render.
+class SceneGraph {
+public:
+  static constexpr int NO_PARENT = -1;
+
+  // Os cubos/malhas anexados sao indices em `scene`, que deve viver mais
+  // que o grafo
+  explicit SceneGraph(Scene &scene) : scene(scene) {}
+
+  // No sem geometria (grupo/pivo). `parent` deve ser um no existente ou
+  // NO_PARENT (std::out_of_range) e a escala > 0 (std::invalid_argument).
+  // Retornam o indice do no.
+  int addNode(int parent = NO_PARENT, const Vec3 &position = {},
+              const Vec3 &rotation = {}, double scale = 1.0);
+  // Acrescenta o cubo/malha a cena; a transformacao dele vira a local do no
+  int addCube(const Cube &cube, int parent = NO_PARENT);
+  int addMesh(const MeshInstance &mesh, int parent = NO_PARENT);
+  // No para um cubo/malha que ja esta na cena (indice em scene.cubes ou
+  // scene.meshes); a transformacao atual dele vira a local do no. Se a cena
+  // encolher, nos com indice alem do fim deixam de gravar. Cada cubo/malha
+  // pertence a no maximo um no (std::invalid_argument).
+  int attachCube(int cubeIndex, int parent = NO_PARENT);
+  int attachMesh(int meshIndex, int parent = NO_PARENT);
+
+  // O cubo/malha foi sobrescrito fora do grafo (ex.: material novo): se
+  // estiver anexado, o no regrava a transformacao de mundo no proximo
+  // update()
+  void cubeReplaced(int cubeIndex);
+  void meshReplaced(int meshIndex);
+
+  // Novo pai (NO_PARENT = raiz); a transformacao local e mantida.
+  // std::invalid_argument se `parent` for o proprio no ou um descendente.
+  void setParent(int node, int parent);
+
+  // Escala > 0 (std::invalid_argument)
+  void setPosition(int node, const Vec3 &position);
+  void setRotation(int node, const Vec3 &rotation);
+  void setScale(int node, double scale);
+  void setLocal(int node, const Vec3 &position, const Vec3 &rotation,
+                double scale);
+
+  int nodeCount() const { return static_cast<int>(nodes.size()); }
+  int parent(int node) const { return nodes[node].parent; }
+  // Indice do cubo/malha do no na cena (-1 se nao for desse tipo)
+  int cubeIndex(int node) const;
+  int meshIndex(int node) const;
+  // No dono do cubo/malha (-1 se nao estiver anexado)
+  int cubeNode(int cubeIndex) const { return ownerOf(cubeNodes, cubeIndex); }
+  int meshNode(int meshIndex) const { return ownerOf(meshNodes, meshIndex); }
+
+  // Matrizes em cache (validas apos update())
+  const Mat4 &localMatrix(int node) const { return nodes[node].local; }
+  const Mat4 &worldMatrix(int node) const { return nodes[node].world; }
+
+  // Recalcula os nos sujos e seus descendentes e atualiza a cena.
+  // Retorna quantos nos tiveram a matriz de mundo recalculada.
+  int update();
+
+private:
+  enum class Attachment { None, Cube, Mesh };
+
+  struct Node {
+    int parent;
+    Vec3 position, rotation;
+    double scale;
+    Attachment attachment{Attachment::None};
+    int index{-1}; // em scene.cubes ou scene.meshes
+    Mat4 local, world;
+    int rank{0}; // posicao em `order`
+    bool localDirty{true};
+    bool worldChanged{false}; // na passada atual de update()
+  };
+
+  int pushNode(int parent, const Vec3 &position, const Vec3 &rotation,
+               double scale);
+  void markDirty(int node);
+  // Ordena os nos por profundidade depois de uma troca de pai
+  void rebuildOrder();
+  // Registra `node` como dono de owners[index]
+  void claim(std::vector<int> &owners, int index, int node);
+  static int ownerOf(const std::vector<int> &owners, int index) {
+    return index >= 0 && index < static_cast<int>(owners.size())
+               ? owners[index]
+               : -1;
+  }
+  // Grava a transformacao de mundo no cubo/malha anexado
+  void writeBack(const Node &node);
+
+  Scene &scene;
+  std::vector<Node> nodes;
+  std::vector<int> cubeNodes, meshNodes; // por indice na cena: no ou -1
+  std::vector<int> order;  // pais antes dos filhos
+  int firstDirty{0};       // nenhum no antes desta posicao de `order` esta sujo
+  bool orderDirty{false};  // algum no trocou de pai
+};
@@ -0,0 +1,88 @@
+#pragma once
+#include "Matrix.h"
+#include "Vector.h"
+#include <algorithm>
+#include <cmath>
+
+//Caixa alinhada aos eixos (AABB) em espaco mundo
+struct AABB {
+  Vec3 min{1e300, 1e300, 1e300};
+  Vec3 max{-1e300, -1e300, -1e300};
+
+  void expand(const AABB &b) {
+    min = Vec3{std::min(min.x, b.min.x), std::min(min.y, b.min.y),
+               std::min(min.z, b.min.z)};
+    max = Vec3{std::max(max.x, b.max.x), std::max(max.y, b.max.y),
+               std::max(max.z, b.max.z)};
+  }
+  void expand(const Vec3 &p) {
+    min = Vec3{std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z)};
+    max = Vec3{std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z)};
+  }
+  Vec3 center() const { return (min + max) * 0.5; }
+  Vec3 extent() const { return (max - min) * 0.5; }
+};
+
+//Frustum de visao como 6 planos a*x + b*y + c*z + d >= 0 (dentro)
+//Extraidos da view-projection (convencao linha-vetor: clip = p * VP).
+//Na camera deste pipeline w = z de visao, negativo na frente da camera, e
+//NDC = clip/w em [-1,1] equivale a  w <= x <= -w  (idem para y).
+struct Frustum {
+  double planes[6][4];
+
+  enum { Left, Right, Bottom, Top, Near, Far };
+
+  static Frustum fromViewProj(const Mat4 &vp, double nearPlane,
+                              double farPlane) {
+    return fromViewProj(vp, nearPlane, farPlane, -1.0, -1.0, 1.0, 1.0);
+  }
+
+  //Frustum restrito ao retangulo [x0,x1] x [y0,y1] em NDC (parte da tela).
+  //NDC >= a equivale a  a*w - x >= 0  e NDC <= b a  x - b*w >= 0  (w < 0).
+  static Frustum fromViewProj(const Mat4 &vp, double nearPlane,
+                              double farPlane, double x0, double y0,
+                              double x1, double y1) {
+    //Coluna j da VP: coeficientes da coordenada de clip j
+    auto col = [&](int j, double out[4]) {
+      for (int i = 0; i < 4; ++i)
+        out[i] = vp.m[i][j];
+    };
+    double cx[4], cy[4], cw[4];
+    col(0, cx);
+    col(1, cy);
+    col(3, cw);
+
+    Frustum f;
+    for (int i = 0; i < 4; ++i) {
+      f.planes[Left][i] = cx[i] - x1 * cw[i];  // x - w >= 0 (tela toda)
+      f.planes[Right][i] = x0 * cw[i] - cx[i]; // -w - x >= 0
+      f.planes[Bottom][i] = cy[i] - y1 * cw[i];
+      f.planes[Top][i] = y0 * cw[i] - cy[i];
+      f.planes[Near][i] = -cw[i]; // -w >= near
+      f.planes[Far][i] = cw[i];   // -w <= far
+    }
+    f.planes[Near][3] -= nearPlane;
+    f.planes[Far][3] += farPlane;
+    return f;
+  }
+
+  //Resultado do teste de uma caixa contra os planos ativos em `mask`
+  //(bit k = plano k ainda precisa ser testado). Retorna false se a caixa
+  //esta toda fora; remove de `mask` os planos que a contem inteira.
+  bool testAABB(const AABB &box, unsigned &mask) const {
+    Vec3 c = box.center(), e = box.extent();
+    for (int k = 0; k < 6; ++k) {
+      if (!(mask & (1u << k)))
+        continue;
+      const double *p = planes[k];
+      double dist = p[0] * c.x + p[1] * c.y + p[2] * c.z + p[3];
+      double radius =
+          std::abs(p[0]) * e.x + std::abs(p[1]) * e.y + std::abs(p[2]) * e.z;
+      if (dist + radius < 0)
+        return false; // toda fora deste plano
+      if (dist - radius >= 0)
+        mask &= ~(1u << k); // toda dentro: filhos nao precisam testar
+    }
+    return true;
+  }
+};
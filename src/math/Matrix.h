@@ -1,22 +1,22 @@
 #pragma once
 #include "Vector.h"
 
-//Struct Mat4, que representa uma matriz 4x4 de doubles
-struct Mat4 {
+//Struct Mat4, que representa uma matriz 4x4 (Mat4 = doubles, Mat4f = floats)
+template <typename T> struct Mat4T {
   //Erray bi dimensional 4x4({} zera por padrao)
-  double m[4][4]{};
+  T m[4][4]{};
 
   //Matriz identidade
-  static Mat4 identity() {
-    Mat4 r{};
+  static Mat4T identity() {
+    Mat4T r{};
     for (int i = 0; i < 4; ++i)
-      r.m[i][i] = 1.0;
+      r.m[i][i] = T(1);
     return r;
   }
   
   //Matriz de Translacao
-  static Mat4 translation(const Vec3 &t) {
-    Mat4 r = identity();
+  static Mat4T translation(const Vec3T<T> &t) {
+    Mat4T r = identity();
     r.m[3][0] = t.x;
     r.m[3][1] = t.y;
     r.m[3][2] = t.z;
@@ -24,17 +24,17 @@ struct Mat4 {
   }
   
   //Funcao que cria a martriz de escala
-  static Mat4 scale(double s) {
-    Mat4 r{};
+  static Mat4T scale(T s) {
+    Mat4T r{};
     r.m[0][0] = r.m[1][1] = r.m[2][2] = s;
-    r.m[3][3] = 1.0;
+    r.m[3][3] = T(1);
     return r;
   }
 
   //Funcao que cria a matriz de rotacao em torno de X
-  static Mat4 rotationX(double rad) {
-    Mat4 r = identity();
-    double c = std::cos(rad), s = std::sin(rad);
+  static Mat4T rotationX(T rad) {
+    Mat4T r = identity();
+    T c = std::cos(rad), s = std::sin(rad);
     r.m[1][1] = c;
     r.m[1][2] = s;
     r.m[2][1] = -s;
@@ -43,9 +43,9 @@ struct Mat4 {
   }
   
   //Funcao que cria a matriz de rotacao em torno de Y
-  static Mat4 rotationY(double rad) {
-    Mat4 r = identity();
-    double c = std::cos(rad), s = std::sin(rad);
+  static Mat4T rotationY(T rad) {
+    Mat4T r = identity();
+    T c = std::cos(rad), s = std::sin(rad);
     r.m[0][0] = c;
     r.m[0][2] = -s;
     r.m[2][0] = s;
@@ -54,19 +54,28 @@ struct Mat4 {
   }
 
   //Funcao que cria a matriz de rotacao em torno de Z
-  static Mat4 rotationZ(double rad) {
-    Mat4 r = identity();
-    double c = std::cos(rad), s = std::sin(rad);
+  static Mat4T rotationZ(T rad) {
+    Mat4T r = identity();
+    T c = std::cos(rad), s = std::sin(rad);
     r.m[0][0] = c;
     r.m[0][1] = s;
     r.m[1][0] = -s;
     r.m[1][1] = c;
     return r;
   }
+
+  //Conversao explicita entre precisoes
+  template <typename U> explicit operator Mat4T<U>() const {
+    Mat4T<U> r;
+    for (int i = 0; i < 4; ++i)
+      for (int j = 0; j < 4; ++j)
+        r.m[i][j] = static_cast<U>(m[i][j]);
+    return r;
+  }
   
   
-  Mat4 operator*(const Mat4 &o) const {
-    Mat4 r{};
+  Mat4T operator*(const Mat4T &o) const {
+    Mat4T r{};
     for (int i = 0; i < 4; ++i)
       for (int j = 0; j < 4; ++j)
         for (int k = 0; k < 4; ++k)
@@ -74,8 +83,8 @@ struct Mat4 {
     return r;
   }
 
-  Vec4 operator*(const Vec4 &v) const {
-    Vec4 r;
+  Vec4T<T> operator*(const Vec4T<T> &v) const {
+    Vec4T<T> r;
     r.x = v.x * m[0][0] + v.y * m[1][0] + v.z * m[2][0] + v.w * m[3][0];
     r.y = v.x * m[0][1] + v.y * m[1][1] + v.z * m[2][1] + v.w * m[3][1];
     r.z = v.x * m[0][2] + v.y * m[1][2] + v.z * m[2][2] + v.w * m[3][2];
@@ -83,3 +92,6 @@ struct Mat4 {
     return r;
   }
 };
+
+using Mat4 = Mat4T<double>;
+using Mat4f = Mat4T<float>;
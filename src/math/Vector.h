@@ -2,23 +2,30 @@
 #include <cmath>
 
 //Estrutura que representa um vetor 3D com componentes x,y,z
-struct Vec3 {
-  double x{}, y{}, z{};//{} inicializa cada cordenada com 0.0
+//Parametrizada pelo tipo escalar (double no pipeline, float onde banda de
+//memoria importa); Vec3 = Vec3T<double>, Vec3f = Vec3T<float>
+template <typename T> struct Vec3T {
+  T x{}, y{}, z{};//{} inicializa cada cordenada com 0
 
-  Vec3() = default; //construtor padrao
-  Vec3(double x_, double y_, double z_) : x(x_), y(y_), z(z_) {}//Construtor que recebe 3 doubles
+  Vec3T() = default; //construtor padrao
+  Vec3T(T x_, T y_, T z_) : x(x_), y(y_), z(z_) {}//Construtor que recebe 3 escalares
+
+  //Conversao explicita entre precisoes (ex.: Vec3f(v))
+  template <typename U>
+  explicit Vec3T(const Vec3T<U> &v)
+      : x(static_cast<T>(v.x)), y(static_cast<T>(v.y)), z(static_cast<T>(v.z)) {}
   
   //Uma função que soma/subtrai/etc este Vec3 com outro Vec3 passado como referência 
   //constante, não altera nenhum dos dois, e retorna um novo Vec3 com o resultado.
-  Vec3 operator+(const Vec3 &v) const { return {x + v.x, y + v.y, z + v.z}; }
-  Vec3 operator-(const Vec3 &v) const { return {x - v.x, y - v.y, z - v.z}; }
+  Vec3T operator+(const Vec3T &v) const { return {x + v.x, y + v.y, z + v.z}; }
+  Vec3T operator-(const Vec3T &v) const { return {x - v.x, y - v.y, z - v.z}; }
   
-  Vec3 operator*(double s) const { return {x * s, y * s, z * s}; }
-  Vec3 operator/(double s) const { return {x / s, y / s, z / s}; }
+  Vec3T operator*(T s) const { return {x * s, y * s, z * s}; }
+  Vec3T operator/(T s) const { return {x / s, y / s, z / s}; }
   
   //Soma o vetor v ao vetor atual(modifica this)
   //Retorna uma referência para o próprio objeto para permitir encadeamento.
-  Vec3 &operator+=(const Vec3 &v) {
+  Vec3T &operator+=(const Vec3T &v) {
     x += v.x;
     y += v.y;
     z += v.z;
@@ -26,29 +33,39 @@ struct Vec3 {
   }
   
   //Produto escalar
-  double dot(const Vec3 &v) const { return x * v.x + y * v.y + z * v.z; }
+  T dot(const Vec3T &v) const { return x * v.x + y * v.y + z * v.z; }
   
   //produto vetorial
-  Vec3 cross(const Vec3 &v) const {
+  Vec3T cross(const Vec3T &v) const {
     return {y * v.z - z * v.y, z * v.x - x * v.z, x * v.y - y * v.x};
   }
 
   //Calculo do modulo(norma) do vetor
-  double length() const { return std::sqrt(x * x + y * y + z * z); }
+  T length() const { return std::sqrt(x * x + y * y + z * z); }
 
   //Retorna o vetor normalizado(vetor unitario)
-  Vec3 normalized() const {
-    double len = length();
-    if (len == 0.0)//Evita divisao por 0
+  Vec3T normalized() const {
+    T len = length();
+    if (len == T(0))//Evita divisao por 0
       return *this;
     return {x / len, y / len, z / len};
   }
 };
 
 //Estrutura do Vetor 4D
-struct Vec4 {
-  double x{}, y{}, z{}, w{};
-  Vec4() = default;
-  Vec4(double x_, double y_, double z_, double w_ = 1.0)
+template <typename T> struct Vec4T {
+  T x{}, y{}, z{}, w{};
+  Vec4T() = default;
+  Vec4T(T x_, T y_, T z_, T w_ = T(1))
       : x(x_), y(y_), z(z_), w(w_) {}
+
+  template <typename U>
+  explicit Vec4T(const Vec4T<U> &v)
+      : x(static_cast<T>(v.x)), y(static_cast<T>(v.y)),
+        z(static_cast<T>(v.z)), w(static_cast<T>(v.w)) {}
 };
+
+using Vec3 = Vec3T<double>;
+using Vec4 = Vec4T<double>;
+using Vec3f = Vec3T<float>;
+using Vec4f = Vec4T<float>;
@@ -0,0 +1,207 @@
+#include "AsyncRenderer.h"
+#include <algorithm>
+
+AsyncRenderer::AsyncRenderer(int numBuffers, ThreadPool &pool)
+    : renderer(pool) {
+  for (int i = 0; i < std::max(2, numBuffers); ++i)
+    slots.push_back(std::make_unique<Slot>());
+  thread = std::thread([this] { renderLoop(); });
+}
+
+AsyncRenderer::~AsyncRenderer() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+    // Frames na fila nao serao renderizados
+    for (Slot *slot : queue)
+      slot->state = SlotState::Free;
+    queue.clear();
+  }
+  queued.notify_all();
+  finished.notify_all();
+  slotFreed.notify_all();
+  thread.join();
+  // Quem estava em wait/submit ainda precisa do mutex para sair
+  std::unique_lock<std::mutex> lock(mutex);
+  finished.wait(lock, [&] { return waiting == 0; });
+}
+
+// ============ SUBMISSAO ============
+
+AsyncRenderer::Slot *AsyncRenderer::freeSlot() {
+  for (auto &slot : slots)
+    if (slot->state == SlotState::Free)
+      return slot.get();
+  return nullptr;
+}
+
+AsyncRenderer::Slot *AsyncRenderer::findSlot(uint64_t ticket) const {
+  for (const auto &slot : slots)
+    if (slot->ticket == ticket && slot->state != SlotState::Free &&
+        slot->state != SlotState::Filling)
+      return slot.get();
+  return nullptr;
+}
+
+// Copia fora do lock (o buffer ja esta reservado como Filling)
+uint64_t AsyncRenderer::submitTo(Slot *slot, const Scene &scene,
+                                 const RenderOptions &options, int width,
+                                 int height, uint32_t clearColor) {
+  slot->scene = scene;
+  slot->scene.camera.aspect = (double)width / height;
+  slot->options = options;
+  slot->clearColor = clearColor;
+  slot->fb.resize(width, height);
+
+  uint64_t ticket;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    ticket = nextTicket++;
+    slot->ticket = ticket;
+    slot->state = SlotState::Queued;
+    queue.push_back(slot);
+  }
+  queued.notify_one();
+  return ticket;
+}
+
+uint64_t AsyncRenderer::submit(const Scene &scene, const RenderOptions &options,
+                               int width, int height, uint32_t clearColor) {
+  if (width <= 0 || height <= 0)
+    return 0;
+  Slot *slot;
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    ++waiting;
+    slotFreed.wait(lock,
+                   [&] { return stopping || (slot = freeSlot()) != nullptr; });
+    if (--waiting == 0 && stopping)
+      finished.notify_all();
+    if (stopping)
+      return 0;
+    slot->state = SlotState::Filling;
+  }
+  return submitTo(slot, scene, options, width, height, clearColor);
+}
+
+uint64_t AsyncRenderer::trySubmit(const Scene &scene,
+                                  const RenderOptions &options, int width,
+                                  int height, uint32_t clearColor) {
+  if (width <= 0 || height <= 0)
+    return 0;
+  Slot *slot;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    slot = freeSlot();
+    if (!slot)
+      return 0;
+    slot->state = SlotState::Filling;
+  }
+  return submitTo(slot, scene, options, width, height, clearColor);
+}
+
+// ============ CONSUMO ============
+
+AsyncRenderer::Status AsyncRenderer::poll(uint64_t ticket) const {
+  std::lock_guard<std::mutex> lock(mutex);
+  const Slot *slot = findSlot(ticket);
+  if (!slot || slot->state == SlotState::Released)
+    return Status::Invalid;
+  return slot->state == SlotState::Ready ? Status::Ready : Status::Pending;
+}
+
+bool AsyncRenderer::wait(uint64_t ticket, Frame &out) {
+  std::unique_lock<std::mutex> lock(mutex);
+  Slot *slot = findSlot(ticket);
+  if (!slot || slot->state == SlotState::Released)
+    return false;
+  // Outra thread pode liberar o frame enquanto esperamos; o destrutor
+  // descarta os que ainda nao foram renderizados
+  ++waiting;
+  finished.wait(lock, [&] {
+    return stopping || slot->ticket != ticket ||
+           slot->state == SlotState::Ready ||
+           slot->state == SlotState::Released ||
+           slot->state == SlotState::Free;
+  });
+  if (--waiting == 0 && stopping)
+    finished.notify_all();
+  if (stopping || slot->ticket != ticket || slot->state != SlotState::Ready)
+    return false;
+  out = Frame{ticket, slot->fb.width, slot->fb.height, slot->fb.color};
+  return true;
+}
+
+bool AsyncRenderer::release(uint64_t ticket) {
+  std::lock_guard<std::mutex> lock(mutex);
+  Slot *slot = findSlot(ticket);
+  if (!slot || slot->state == SlotState::Released)
+    return false;
+  if (slot->state == SlotState::Queued) {
+    // Ainda nao comecou: sai da fila e nao e renderizado
+    queue.erase(std::find(queue.begin(), queue.end(), slot));
+    slot->state = SlotState::Free;
+  } else if (slot->state == SlotState::Rendering || slot->inCallback) {
+    // A thread de render ainda usa o buffer (render ou callback): ela o
+    // devolve ao anel quando terminar
+    slot->state = SlotState::Released;
+    finished.notify_all();
+    return true;
+  } else {
+    slot->state = SlotState::Free;
+  }
+  slotFreed.notify_one();
+  finished.notify_all();
+  return true;
+}
+
+void AsyncRenderer::setCallback(Callback cb) {
+  std::lock_guard<std::mutex> lock(mutex);
+  callback = std::move(cb);
+}
+
+// ============ THREAD DE RENDER ============
+
+void AsyncRenderer::renderLoop() {
+  for (;;) {
+    Slot *slot;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      queued.wait(lock, [&] { return stopping || !queue.empty(); });
+      if (stopping)
+        return; // frames ainda na fila sao descartados
+      slot = queue.front();
+      queue.pop_front();
+      slot->state = SlotState::Rendering;
+    }
+
+    slot->fb.clear(slot->clearColor);
+    renderer.render(slot->scene, slot->fb, slot->options);
+
+    Callback cb;
+    Frame frame{slot->ticket, slot->fb.width, slot->fb.height, slot->fb.color};
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (slot->state == SlotState::Released) {
+        slot->state = SlotState::Free; // liberado durante o render
+        slotFreed.notify_one();
+        continue;
+      }
+      slot->state = SlotState::Ready;
+      cb = callback;
+      slot->inCallback = static_cast<bool>(cb);
+    }
+    finished.notify_all();
+    if (!cb)
+      continue;
+    cb(frame);
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      slot->inCallback = false;
+      if (slot->state != SlotState::Released)
+        continue;
+      slot->state = SlotState::Free; // liberado durante o callback
+    }
+    slotFreed.notify_one();
+  }
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include "Rasterizer.h"
+#include "Renderer.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Producao de frames assincrona.
+// Uma thread de render dedicada percorre um anel de framebuffers
+// pre-alocados: enquanto o chamador converte/codifica o frame N, o frame
+// N+1 ja esta sendo renderizado. Cada submit copia a cena (snapshot), entao
+// o chamador pode alterar a sua logo em seguida.
+//
+// Ciclo de um buffer: livre -> na fila -> renderizando -> pronto -> livre
+// (release). Frames ficam prontos na ordem de submissao. O destrutor espera
+// o frame em andamento (e o seu callback), descarta os que ainda estao na
+// fila e acorda quem esperava por eles (wait retorna false).
+class AsyncRenderer {
+public:
+  // Frame pronto; `pixels` (width*height ARGB) vale ate release(ticket)
+  struct Frame {
+    uint64_t ticket;
+    int width, height;
+    const uint32_t *pixels;
+  };
+
+  enum class Status { Invalid, Pending, Ready };
+
+  // Chamado na thread de render assim que um frame fica pronto (pode chamar
+  // release, mas nao submit/wait). O buffer do frame so volta ao anel
+  // depois que o callback retorna, mesmo que outra thread o libere antes.
+  using Callback = std::function<void(const Frame &)>;
+
+  // numBuffers >= 2 (3 = triple buffering)
+  explicit AsyncRenderer(int numBuffers = 3,
+                         ThreadPool &pool = ThreadPool::global());
+  ~AsyncRenderer();
+
+  AsyncRenderer(const AsyncRenderer &) = delete;
+  AsyncRenderer &operator=(const AsyncRenderer &) = delete;
+
+  // Copia cena e opcoes para um buffer livre e enfileira o frame. Bloqueia
+  // enquanto todos os buffers estiverem em uso (ate algum release).
+  // Retorna o ticket do frame (> 0; 0 se o AsyncRenderer for destruido
+  // durante a espera).
+  uint64_t submit(const Scene &scene, const RenderOptions &options, int width,
+                  int height, uint32_t clearColor);
+  // Como submit, mas retorna 0 em vez de bloquear
+  uint64_t trySubmit(const Scene &scene, const RenderOptions &options,
+                     int width, int height, uint32_t clearColor);
+
+  Status poll(uint64_t ticket) const;
+  // Espera o frame ficar pronto; false se o ticket nao existe, ja foi
+  // liberado ou o AsyncRenderer esta sendo destruido
+  bool wait(uint64_t ticket, Frame &out);
+  // Devolve o buffer do frame ao anel (pronto ou ainda pendente)
+  bool release(uint64_t ticket);
+
+  void setCallback(Callback cb);
+
+private:
+  enum class SlotState { Free, Filling, Queued, Rendering, Ready, Released };
+
+  struct Slot {
+    SlotState state{SlotState::Free};
+    uint64_t ticket{0};
+    Scene scene;
+    RenderOptions options;
+    uint32_t clearColor{0};
+    Framebuffer fb{0, 0};
+    // Callback lendo fb: um release nesse meio tempo so marca Released e
+    // a thread de render devolve o buffer quando o callback retorna
+    bool inCallback{false};
+  };
+
+  uint64_t submitTo(Slot *slot, const Scene &scene,
+                    const RenderOptions &options, int width, int height,
+                    uint32_t clearColor);
+  Slot *freeSlot();
+  Slot *findSlot(uint64_t ticket) const;
+  void renderLoop();
+
+  mutable std::mutex mutex;
+  std::condition_variable slotFreed; // submit espera buffer livre
+  std::condition_variable queued;    // thread de render espera trabalho
+  std::condition_variable finished;  // wait espera frame pronto
+  std::vector<std::unique_ptr<Slot>> slots;
+  std::deque<Slot *> queue; // ordem de submissao
+  uint64_t nextTicket{1};
+  bool stopping{false};
+  int waiting{0}; // threads em wait/submit (o destrutor espera sairem)
+  Callback callback;
+
+  Renderer renderer; // so usado pela thread de render
+  std::thread thread;
+};
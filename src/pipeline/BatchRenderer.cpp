@@ -0,0 +1,110 @@
+#include "BatchRenderer.h"
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+bool renderAnimation(const Animation &anim, FrameWriter &writer,
+                     const BatchOptions &options, std::string &error,
+                     ThreadPool &pool) {
+  const int first = std::max(0, options.firstFrame);
+  const int last = options.lastFrame < 0
+                       ? anim.frameCount - 1
+                       : std::min(options.lastFrame, anim.frameCount - 1);
+  if (first > last) {
+    error = "intervalo de frames vazio";
+    return false;
+  }
+  const int count = last - first + 1;
+
+  int threads = options.numThreads > 0 ? std::min(options.numThreads, pool.size())
+                                       : pool.size();
+  threads = std::min(threads, count);
+  int window = options.maxFramesInFlight > 0
+                   ? std::max(options.maxFramesInFlight, threads)
+                   : 2 * threads;
+  window = std::min(window, count);
+
+  // Com menos frames que threads sobra pool para os tiles de cada frame
+  RenderOptions renderOptions = options.render;
+  renderOptions.usePhong = anim.usePhong;
+  renderOptions.numThreads = std::max(1, pool.size() / threads);
+
+  std::vector<Framebuffer> buffers;
+  buffers.reserve(window);
+  for (int i = 0; i < window; ++i)
+    buffers.emplace_back(anim.width, anim.height);
+  std::vector<char> ready(window, 0);
+
+  // Estado compartilhado (indices relativos a `first`)
+  std::mutex mutex;
+  std::condition_variable changed;
+  int next = 0;    // proximo frame a renderizar
+  int written = 0; // frames ja gravados (sempre em ordem)
+  bool failed = false;
+
+  // ============ ESCRITA ============
+  std::thread writerThread([&] {
+    for (int f = 0; f < count; ++f) {
+      const int slot = f % window;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&] { return failed || ready[slot]; });
+        if (failed)
+          return;
+      }
+      std::string writeError;
+      bool ok = writer.write(first + f, buffers[slot].color, writeError);
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        ready[slot] = 0;
+        if (ok) {
+          ++written;
+        } else {
+          failed = true;
+          error = writeError;
+        }
+      }
+      changed.notify_all();
+      if (!ok)
+        return;
+      if (options.progress)
+        options.progress(first + f, f + 1, count);
+    }
+  });
+
+  // ============ RENDER ============
+  pool.parallelFor(
+      threads,
+      [&](int) {
+        Renderer renderer(pool);
+        Scene scene;
+        for (;;) {
+          int f;
+          {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&] {
+              return failed || next >= count || next - written < window;
+            });
+            if (failed || next >= count)
+              return;
+            f = next++;
+          }
+          Framebuffer &fb = buffers[f % window];
+          anim.sceneAt(first + f, scene);
+          scene.camera.aspect = static_cast<double>(anim.width) / anim.height;
+          fb.clear(anim.background);
+          renderer.render(scene, fb, renderOptions);
+          {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready[f % window] = 1;
+          }
+          changed.notify_all();
+        }
+      },
+      threads);
+
+  writerThread.join();
+  return !failed;
+}
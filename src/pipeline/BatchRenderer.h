@@ -0,0 +1,32 @@
+#pragma once
+#include "../core/Animation.h"
+#include "FrameWriter.h"
+#include "Renderer.h"
+#include <functional>
+#include <string>
+
+// Render em lote de uma animacao, paralelo entre frames.
+// Cada thread renderiza frames inteiros (tiles seriais, um Renderer por
+// thread), o que escala melhor que paralelizar os tiles de um frame so:
+// sem barreira por frame e sem tiles vazios esperando os mais pesados.
+//
+// Memoria limitada: ha no maximo `maxFramesInFlight` framebuffers. Frames
+// terminam fora de ordem, mas sao escritos em ordem por uma thread de
+// escrita; um frame so comeca quando o buffer dele ja foi gravado, entao
+// threads rapidas esperam o disco em vez de acumular frames.
+struct BatchOptions {
+  int firstFrame{0};
+  int lastFrame{-1};        // inclusivo; -1 = ultimo da animacao
+  int numThreads{0};        // frames renderizados ao mesmo tempo (0 = pool)
+  int maxFramesInFlight{0}; // buffers em memoria (0 = 2 por thread)
+  // Opcoes do pipeline; usePhong vem da animacao e numThreads e recalculado
+  RenderOptions render;
+  // Chamado na thread de escrita depois de cada frame gravado
+  std::function<void(int frame, int written, int total)> progress;
+};
+
+// Retorna false com a mensagem em `error` (intervalo vazio ou erro de
+// escrita; neste caso os frames ja gravados continuam no disco)
+bool renderAnimation(const Animation &anim, FrameWriter &writer,
+                     const BatchOptions &options, std::string &error,
+                     ThreadPool &pool = ThreadPool::global());
@@ -0,0 +1,146 @@
+#include "DynamicResolution.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// ============ CONTROLE DA ESCALA ============
+
+// Maior passo da grade que nao passa de `s`
+static double quantizeDown(double s) {
+  return std::floor(s * DYNRES_STEPS + 1e-9) / DYNRES_STEPS;
+}
+
+void DynamicResolution::setBudget(double ms, double minScale_) {
+  budgetMs = std::max(ms, 0.0);
+  minScale = std::clamp(minScale_, 1.0 / DYNRES_STEPS, 1.0);
+  current = enabled() ? std::clamp(current, minScale, 1.0) : 1.0;
+  fullCost = 0.0;
+  quietFrames = 0;
+}
+
+void DynamicResolution::renderSize(int width, int height, int &w,
+                                   int &h) const {
+  if (current >= 1.0) {
+    w = width;
+    h = height;
+    return;
+  }
+  w = std::max(1, static_cast<int>(width * current + 0.5));
+  h = std::max(1, static_cast<int>(height * current + 0.5));
+}
+
+void DynamicResolution::frameDone(double ms) {
+  if (!enabled())
+    return;
+  // Custo estimado do mesmo frame na escala 1
+  const double cost = ms / (current * current);
+
+  // Estourou: desce ja, pelo menos um passo
+  if (ms > budgetMs) {
+    double target = quantizeDown(std::sqrt(budgetMs * DYNRES_HEADROOM / cost));
+    current = std::max(minScale,
+                       std::min(target, current - 1.0 / DYNRES_STEPS));
+    fullCost = 0.0;
+    quietFrames = 0;
+    return;
+  }
+  // Faixa de histerese: fica
+  if (ms >= budgetMs * DYNRES_RAISE || current >= 1.0) {
+    fullCost = 0.0;
+    quietFrames = 0;
+    return;
+  }
+  // Folga por varios frames seguidos: sobe pelo pior deles
+  fullCost = std::max(fullCost, cost);
+  if (++quietFrames < DYNRES_RAISE_FRAMES)
+    return;
+  double target =
+      quantizeDown(std::sqrt(budgetMs * DYNRES_HEADROOM / fullCost));
+  current = std::max(current,
+                     std::min({1.0, target, current + DYNRES_MAX_RAISE}));
+  fullCost = 0.0;
+  quietFrames = 0;
+}
+
+// ============ AMPLIACAO BILINEAR ============
+
+void BilinearUpscaler::buildTaps(std::vector<Tap> &taps, int srcSize,
+                                 int dstSize) {
+  taps.resize(dstSize);
+  const double ratio = static_cast<double>(srcSize) / dstSize;
+  for (int i = 0; i < dstSize; ++i) {
+    // Centro do pixel de destino na fonte
+    double pos = std::max((i + 0.5) * ratio - 0.5, 0.0);
+    int i0 = std::min(static_cast<int>(pos), srcSize - 1);
+    taps[i].i0 = i0;
+    taps[i].i1 = std::min(i0 + 1, srcSize - 1);
+    taps[i].w = static_cast<uint32_t>((pos - i0) * 256.0 + 0.5);
+  }
+}
+
+// Mistura de dois ARGB com peso w/256 no segundo: R e B num registro, A e G
+// no outro (cada canal com 16 bits de folga)
+static inline uint32_t lerpARGB(uint32_t p, uint32_t q, uint32_t w) {
+  const uint32_t iw = 256 - w;
+  uint32_t rb = (((p & 0xff00ff) * iw + (q & 0xff00ff) * w) >> 8) & 0xff00ff;
+  uint32_t ag = (((p >> 8) & 0xff00ff) * iw + ((q >> 8) & 0xff00ff) * w) &
+                0xff00ff00;
+  return rb | ag;
+}
+
+void BilinearUpscaler::upscale(const uint32_t *src, int sw, int sh,
+                               uint32_t *dst, int dw, int dh) {
+  if (sw == dw && sh == dh) {
+    std::memcpy(dst, src, static_cast<size_t>(dw) * dh * sizeof(uint32_t));
+    return;
+  }
+  if (srcW != sw || dstW != dw) {
+    buildTaps(columns, sw, dw);
+    srcW = sw;
+    dstW = dw;
+  }
+  if (srcH != sh || dstH != dh) {
+    buildTaps(rows, sh, dh);
+    srcH = sh;
+    dstH = dh;
+  }
+
+  // Separavel: cada linha da fonte e interpolada na horizontal uma vez por
+  // faixa (serve a ~dh/sh linhas de destino) e a vertical mistura duas
+  // linhas ja prontas, sem acessos espalhados
+  constexpr int BAND = 16; // linhas por tarefa
+  const Tap *cols = columns.data();
+  pool.parallelFor((dh + BAND - 1) / BAND, [&](int band) {
+    thread_local std::vector<uint32_t> lines[2];
+    int held[2] = {-1, -1};
+    for (auto &line : lines)
+      if (line.size() < static_cast<size_t>(dw))
+        line.resize(dw);
+    auto horizontal = [&](int k, int sy) {
+      const uint32_t *in = src + static_cast<size_t>(sy) * sw;
+      uint32_t *line = lines[k].data();
+      for (int x = 0; x < dw; ++x)
+        line[x] = lerpARGB(in[cols[x].i0], in[cols[x].i1], cols[x].w);
+      held[k] = sy;
+    };
+
+    const int y1 = std::min(dh, (band + 1) * BAND);
+    for (int y = band * BAND; y < y1; ++y) {
+      const Tap &r = rows[y];
+      if (held[0] != r.i0) {
+        if (held[1] == r.i0) { // descendo: a de baixo vira a de cima
+          std::swap(lines[0], lines[1]);
+          std::swap(held[0], held[1]);
+        } else {
+          horizontal(0, r.i0);
+        }
+      }
+      if (held[1] != r.i1)
+        horizontal(1, r.i1);
+      const uint32_t *a = lines[0].data(), *b = lines[1].data();
+      uint32_t *out = dst + static_cast<size_t>(y) * dw;
+      for (int x = 0; x < dw; ++x)
+        out[x] = lerpARGB(a[x], b[x], r.w);
+    }
+  });
+}
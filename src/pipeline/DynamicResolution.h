@@ -0,0 +1,78 @@
+#pragma once
+#include "ThreadPool.h"
+#include <cstdint>
+#include <vector>
+
+// ============ RESOLUCAO DINAMICA ============
+// Para segurar uma taxa de quadros com a carga da maquina mudando: o
+// contexto mede quanto cada frame custou e escolhe a resolucao interna do
+// proximo, renderiza nela e amplia para o tamanho pedido.
+//
+// O custo do frame e tomado como proporcional aos pixels (escala²), o que
+// superestima a escala cheia quando ha custo fixo (transformacao, shadow
+// maps) e so deixa o controle mais conservador ao subir. Com histerese:
+// - acima do orcamento desce ja no frame seguinte, direto para a escala
+//   estimada com folga (DYNRES_HEADROOM);
+// - abaixo de DYNRES_RAISE do orcamento por DYNRES_RAISE_FRAMES frames
+//   seguidos sobe, no maximo DYNRES_MAX_RAISE por vez;
+// - entre os dois fica onde esta.
+// A escala anda em passos de 1/DYNRES_STEPS para nao oscilar entre tamanhos
+// quase iguais (cada tamanho novo refaz os buffers do frame).
+
+// Alvo depois de ajustar: fracao do orcamento
+constexpr double DYNRES_HEADROOM = 0.85;
+// Frames abaixo de DYNRES_RAISE * orcamento antes de subir a escala
+constexpr double DYNRES_RAISE = 0.75;
+constexpr int DYNRES_RAISE_FRAMES = 8;
+constexpr double DYNRES_MAX_RAISE = 0.125;
+constexpr int DYNRES_STEPS = 32;
+
+class DynamicResolution {
+public:
+  // Orcamento por frame em ms (0 = desligado, escala 1) e menor escala por
+  // eixo aceita, em (0, 1]. Mantem a escala atual (dentro do novo minimo).
+  void setBudget(double ms, double minScale);
+  bool enabled() const { return budgetMs > 0.0; }
+
+  // Escala por eixo do proximo frame
+  double scale() const { return current; }
+  // Tamanho interno para uma saida width x height (pelo menos 1x1)
+  void renderSize(int width, int height, int &w, int &h) const;
+  // Custo (ms) do frame que acabou de sair com scale(); escolhe a escala do
+  // proximo
+  void frameDone(double ms);
+
+private:
+  double budgetMs{0.0};
+  double minScale{0.25};
+  double current{1.0};
+  // Custo medio estimado na escala 1 nos frames abaixo de DYNRES_RAISE
+  double fullCost{0.0};
+  int quietFrames{0};
+};
+
+// Amplia `src` (sw x sh ARGB) para `dst` (dw x dh) com filtro bilinear
+// (centros de pixel alinhados, bordas presas), em faixas de linhas no
+// pool. Pesos de 8 bits; os vetores de coordenadas sao reaproveitados entre
+// chamadas (sem alocar no tamanho de sempre).
+class BilinearUpscaler {
+public:
+  explicit BilinearUpscaler(ThreadPool &pool = ThreadPool::global())
+      : pool(pool) {}
+
+  void upscale(const uint32_t *src, int sw, int sh, uint32_t *dst, int dw,
+               int dh);
+
+private:
+  // Por coluna/linha de destino: primeiro texel da fonte e peso do segundo
+  // (0 a 256); o segundo e o seguinte, preso a borda
+  struct Tap {
+    int i0, i1;
+    uint32_t w;
+  };
+  static void buildTaps(std::vector<Tap> &taps, int srcSize, int dstSize);
+
+  ThreadPool &pool;
+  std::vector<Tap> columns, rows;
+  int srcW{0}, dstW{0}, srcH{0}, dstH{0};
+};
@@ -0,0 +1,57 @@
+#include "FrameArena.h"
+#include <algorithm>
+
+// Bloco minimo pedido ao heap
+static constexpr size_t MIN_BLOCK = 64 * 1024;
+
+static size_t alignUp(uintptr_t address, size_t align) {
+  return static_cast<size_t>((address + align - 1) & ~uintptr_t(align - 1));
+}
+
+void *FrameArena::allocateBytes(size_t bytes, size_t align) {
+  uintptr_t base = reinterpret_cast<uintptr_t>(block.get());
+  size_t start = alignUp(base + offset, align) - base;
+  if (overflow.empty() && block && start + bytes <= blockSize) {
+    used += start + bytes - offset;
+    offset = start + bytes;
+    return block.get() + start;
+  }
+  return allocateOverflow(bytes, align);
+}
+
+void *FrameArena::allocateOverflow(size_t bytes, size_t align) {
+  if (!overflow.empty()) {
+    uintptr_t base = reinterpret_cast<uintptr_t>(overflow.back().get());
+    size_t start = alignUp(base + overflowOffset, align) - base;
+    if (start + bytes <= overflowSize) {
+      used += start + bytes - overflowOffset;
+      overflowOffset = start + bytes;
+      return overflow.back().get() + start;
+    }
+  }
+  // Novo bloco extra, no minimo do tamanho do principal
+  size_t size = std::max({bytes + align, blockSize, MIN_BLOCK});
+  overflow.emplace_back(new unsigned char[size]);
+  ++frameHeapAllocations;
+  overflowSize = size;
+  uintptr_t base = reinterpret_cast<uintptr_t>(overflow.back().get());
+  size_t start = alignUp(base, align) - base;
+  overflowOffset = start + bytes;
+  used += overflowOffset;
+  return overflow.back().get() + start;
+}
+
+void FrameArena::reset() {
+  if (!overflow.empty()) {
+    // O frame nao coube: um bloco so com o pico + 50% para os proximos
+    size_t size = std::max(MIN_BLOCK, used + used / 2);
+    overflow.clear();
+    block.reset(new unsigned char[size]);
+    blockSize = size;
+    frameHeapAllocations = 1;
+  } else {
+    frameHeapAllocations = 0;
+  }
+  offset = 0;
+  used = 0;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+// Trecho contiguo de um array da FrameArena (sem dono). Vale ate o
+// proximo reset() da arena.
+template <typename T> struct FrameSpan {
+  T *data{nullptr};
+  size_t count{0};
+
+  T *begin() const { return data; }
+  T *end() const { return data + count; }
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  T &operator[](size_t i) const { return data[i]; }
+};
+
+// Alocador linear por frame: cada alocacao so avanca um ponteiro dentro de
+// um bloco e reset() descarta tudo de uma vez (O(1), nada de destrutores:
+// so tipos trivialmente destrutiveis). Se um frame passa do bloco, as
+// alocacoes seguintes vao para blocos extras e o proximo reset() troca
+// tudo por um bloco unico com folga sobre o pico, entao depois do
+// aquecimento os frames nao pedem memoria ao heap.
+// Nao e thread-safe: aloque nas partes seriais do frame e deixe as tarefas
+// paralelas escreverem em fatias ja alocadas.
+class FrameArena {
+public:
+  FrameArena() = default;
+  FrameArena(const FrameArena &) = delete;
+  FrameArena &operator=(const FrameArena &) = delete;
+
+  // n elementos nao inicializados
+  template <typename T> T *allocate(size_t n) {
+    static_assert(std::is_trivially_destructible<T>::value,
+                  "FrameArena nao chama destrutores");
+    return static_cast<T *>(allocateBytes(n * sizeof(T), alignof(T)));
+  }
+
+  // n copias de `value`
+  template <typename T> FrameSpan<T> array(size_t n, const T &value) {
+    T *data = allocate<T>(n);
+    for (size_t i = 0; i < n; ++i)
+      new (data + i) T(value);
+    return {data, n};
+  }
+
+  // Libera tudo o que foi alocado desde o ultimo reset()
+  void reset();
+
+  // Bytes alocados desde o ultimo reset() (com alinhamento)
+  size_t bytesUsed() const { return used; }
+  size_t capacity() const { return blockSize; }
+  // Blocos pedidos ao heap desde o ultimo reset() (0 em regime)
+  long long heapAllocations() const { return frameHeapAllocations; }
+
+private:
+  void *allocateBytes(size_t bytes, size_t align);
+  void *allocateOverflow(size_t bytes, size_t align);
+
+  std::unique_ptr<unsigned char[]> block;
+  size_t blockSize{0};
+  size_t offset{0}; // proximo byte livre em `block`
+  // Blocos extras do frame atual (so quando `block` nao bastou)
+  std::vector<std::unique_ptr<unsigned char[]>> overflow;
+  size_t overflowSize{0}, overflowOffset{0}; // do ultimo bloco extra
+  size_t used{0};
+  long long frameHeapAllocations{0};
+};
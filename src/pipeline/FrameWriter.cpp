@@ -0,0 +1,189 @@
+#include "FrameWriter.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+FrameFormat FrameWriter::formatFromPath(const std::string &path) {
+  auto endsWith = [&](const char *ext) {
+    size_t n = std::strlen(ext);
+    return path.size() >= n && path.compare(path.size() - n, n, ext) == 0;
+  };
+  if (endsWith(".ppm"))
+    return FrameFormat::Ppm;
+  if (endsWith(".y4m"))
+    return FrameFormat::Y4m;
+  return FrameFormat::Raw;
+}
+
+// Padrao do PPM: exatamente uma conversao %d (com flags/largura opcionais)
+static bool validPattern(const std::string &pattern) {
+  size_t pos = pattern.find('%');
+  if (pos == std::string::npos || pattern.find('%', pos + 1) != std::string::npos)
+    return false;
+  size_t i = pos + 1;
+  while (i < pattern.size() && (pattern[i] == '0' || pattern[i] == '-' ||
+                                (pattern[i] >= '1' && pattern[i] <= '9')))
+    ++i;
+  return i < pattern.size() && pattern[i] == 'd';
+}
+
+bool FrameWriter::open(const std::string &outPath, FrameFormat fmt, int w,
+                       int h, int fps, std::string &error) {
+  close();
+  if (w <= 0 || h <= 0 || fps <= 0) {
+    error = "tamanho ou fps invalido";
+    return false;
+  }
+  format = fmt;
+  width = w;
+  height = h;
+  path = outPath;
+
+  if (format == FrameFormat::Ppm) {
+    if (path == "-") {
+      error = "PPM precisa de um caminho (um arquivo por frame)";
+      return false;
+    }
+    if (path.find('%') == std::string::npos) {
+      size_t dot = path.rfind('.');
+      size_t slash = path.find_last_of("/\\");
+      if (dot == std::string::npos ||
+          (slash != std::string::npos && dot < slash))
+        dot = path.size();
+      path = path.substr(0, dot) + "_%05d.ppm";
+    }
+    if (!validPattern(path)) {
+      error = "padrao PPM invalido: " + path + " (use um unico %d)";
+      return false;
+    }
+    return true;
+  }
+
+  if (path == "-") {
+    file = stdout;
+    ownsFile = false;
+  } else {
+    file = std::fopen(path.c_str(), "wb");
+    ownsFile = true;
+    if (!file) {
+      error = "nao foi possivel criar " + path + ": " + std::strerror(errno);
+      return false;
+    }
+  }
+  if (format == FrameFormat::Y4m) {
+    char header[128];
+    int n = std::snprintf(header, sizeof(header),
+                          "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width,
+                          height, fps);
+    if (!writeBytes(file, header, n, error))
+      return false;
+  }
+  return true;
+}
+
+bool FrameWriter::writeBytes(std::FILE *f, const void *data, size_t size,
+                             std::string &error) {
+  if (std::fwrite(data, 1, size, f) != size) {
+    error = "erro de escrita: " + std::string(std::strerror(errno));
+    return false;
+  }
+  return true;
+}
+
+// ============ CONVERSAO ============
+
+static inline int red(uint32_t c) { return (c >> 16) & 0xff; }
+static inline int green(uint32_t c) { return (c >> 8) & 0xff; }
+static inline int blue(uint32_t c) { return c & 0xff; }
+
+// BT.601 em faixa limitada (Y 16..235, Cb/Cr 16..240), aritmetica inteira
+static inline uint8_t lumaY(int r, int g, int b) {
+  return static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+}
+static inline uint8_t chromaU(int r, int g, int b) {
+  return static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+}
+static inline uint8_t chromaV(int r, int g, int b) {
+  return static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+}
+
+bool FrameWriter::write(int frame, const uint32_t *pixels,
+                        std::string &error) {
+  const size_t count = static_cast<size_t>(width) * height;
+
+  switch (format) {
+  case FrameFormat::Raw:
+    return file && writeBytes(file, pixels, count * sizeof(uint32_t), error);
+
+  case FrameFormat::Ppm: {
+    char name[4096];
+    std::snprintf(name, sizeof(name), path.c_str(), frame);
+    std::FILE *f = std::fopen(name, "wb");
+    if (!f) {
+      error = "nao foi possivel criar " + std::string(name) + ": " +
+              std::strerror(errno);
+      return false;
+    }
+    bytes.resize(count * 3);
+    for (size_t i = 0; i < count; ++i) {
+      bytes[i * 3 + 0] = static_cast<uint8_t>(red(pixels[i]));
+      bytes[i * 3 + 1] = static_cast<uint8_t>(green(pixels[i]));
+      bytes[i * 3 + 2] = static_cast<uint8_t>(blue(pixels[i]));
+    }
+    std::fprintf(f, "P6\n%d %d\n255\n", width, height);
+    bool ok = writeBytes(f, bytes.data(), bytes.size(), error);
+    if (std::fclose(f) != 0 && ok) {
+      error = "erro ao fechar " + std::string(name);
+      ok = false;
+    }
+    return ok;
+  }
+
+  case FrameFormat::Y4m: {
+    if (!file)
+      return false;
+    // Crominancia: media de cada bloco 2x2 (bordas repetem o ultimo pixel)
+    const int cw = (width + 1) / 2, ch = (height + 1) / 2;
+    bytes.resize(count + 2 * static_cast<size_t>(cw) * ch);
+    uint8_t *py = bytes.data();
+    uint8_t *pu = py + count;
+    uint8_t *pv = pu + static_cast<size_t>(cw) * ch;
+    for (size_t i = 0; i < count; ++i)
+      py[i] = lumaY(red(pixels[i]), green(pixels[i]), blue(pixels[i]));
+    for (int cy = 0; cy < ch; ++cy) {
+      int y0 = cy * 2, y1 = std::min(y0 + 1, height - 1);
+      for (int cx = 0; cx < cw; ++cx) {
+        int x0 = cx * 2, x1 = std::min(x0 + 1, width - 1);
+        uint32_t c[4] = {pixels[y0 * width + x0], pixels[y0 * width + x1],
+                         pixels[y1 * width + x0], pixels[y1 * width + x1]};
+        int r = (red(c[0]) + red(c[1]) + red(c[2]) + red(c[3]) + 2) >> 2;
+        int g = (green(c[0]) + green(c[1]) + green(c[2]) + green(c[3]) + 2) >> 2;
+        int b = (blue(c[0]) + blue(c[1]) + blue(c[2]) + blue(c[3]) + 2) >> 2;
+        pu[cy * cw + cx] = chromaU(r, g, b);
+        pv[cy * cw + cx] = chromaV(r, g, b);
+      }
+    }
+    static const char frameHeader[] = "FRAME\n";
+    return writeBytes(file, frameHeader, sizeof(frameHeader) - 1, error) &&
+           writeBytes(file, bytes.data(), bytes.size(), error);
+  }
+  }
+  return false;
+}
+
+bool FrameWriter::close(std::string &error) {
+  bool ok = true;
+  if (file) {
+    if (ownsFile ? std::fclose(file) != 0 : std::fflush(file) != 0) {
+      error = "erro ao fechar " + path;
+      ok = false;
+    }
+    file = nullptr;
+  }
+  return ok;
+}
+
+void FrameWriter::close() {
+  std::string ignored;
+  close(ignored);
+}
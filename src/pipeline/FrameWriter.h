@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Saida de sequencias de frames para disco, so com escrita sequencial
+// (append). Nada alem do frame atual fica em memoria.
+//   Raw: frames ARGB (uint32 na ordem da maquina) concatenados, sem cabecalho
+//   Ppm: um arquivo P6 por frame; o caminho e um padrao printf com o numero
+//        do frame ("quadros/f_%05d.ppm"); sem '%' vira "<nome>_%05d.ppm"
+//   Y4m: YUV4MPEG2 4:2:0 (BT.601, faixa limitada), lido por ffmpeg/mpv
+// Raw e Y4m aceitam "-" para escrever na saida padrao (pipe para o ffmpeg).
+enum class FrameFormat { Raw, Ppm, Y4m };
+
+class FrameWriter {
+public:
+  FrameWriter() = default;
+  ~FrameWriter() { close(); }
+
+  FrameWriter(const FrameWriter &) = delete;
+  FrameWriter &operator=(const FrameWriter &) = delete;
+
+  // Formato pela extensao (.ppm, .y4m; qualquer outra = Raw)
+  static FrameFormat formatFromPath(const std::string &path);
+
+  // Retornam false com a mensagem em `error`
+  bool open(const std::string &path, FrameFormat format, int width,
+            int height, int fps, std::string &error);
+  // `pixels` tem width*height ARGB; `frame` numera os arquivos PPM
+  bool write(int frame, const uint32_t *pixels, std::string &error);
+  bool close(std::string &error);
+  void close();
+
+private:
+  bool writeBytes(std::FILE *f, const void *data, size_t size,
+                  std::string &error);
+
+  FrameFormat format{FrameFormat::Raw};
+  std::string path;
+  int width{0}, height{0};
+  std::FILE *file{nullptr}; // Raw/Y4m
+  bool ownsFile{false};     // false para stdout
+  std::vector<uint8_t> bytes; // conversao RGB/YUV reaproveitada
+};
@@ -0,0 +1,268 @@
+#include "InstanceBatch.h"
+#include <cmath>
+
+// Versoes AVX2 e base dos lacos vetorizaveis, escolhidas pelo loader (ifunc)
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__linux__) &&          \
+    !defined(__clang__)
+#define VECTOR_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define VECTOR_CLONES
+#endif
+
+// Cantos do cubo unitario (mesma ordem de Cube::baseVertices)
+static const double cornerX[8] = {-0.5, 0.5, 0.5, -0.5, -0.5, 0.5, 0.5, -0.5};
+static const double cornerY[8] = {-0.5, -0.5, 0.5, 0.5, -0.5, -0.5, 0.5, 0.5};
+static const double cornerZ[8] = {-0.5, -0.5, -0.5, -0.5, 0.5, 0.5, 0.5, 0.5};
+
+void CubeInstanceBatch::assign(const std::vector<Cube> &cubes,
+                               const std::vector<int> *indices) {
+  size_t n = indices ? indices->size() : cubes.size();
+  shared = nullptr;
+  count = static_cast<int>(n);
+  // Capacidade para a cena inteira: o numero de cubos visiveis varia de
+  // frame a frame, mas assim nao realoca os ~30 arrays quando ele cresce
+  size_t capacity = cubes.size();
+  auto fit = [&](auto &v, size_t perInstance) {
+    v.reserve(capacity * perInstance);
+    v.resize(n * perInstance);
+  };
+  fit(cubeIndex, 1);
+  for (auto *v : {&posX, &posY, &posZ, &rotX, &rotY, &rotZ, &scale})
+    fit(*v, 1);
+  for (auto &m : model)
+    fit(m, 1);
+  for (auto *v : {&worldX, &worldY, &worldZ, &clipX, &clipY, &clipW})
+    fit(*v, 8);
+  for (auto *v : {&normalX, &normalY, &normalZ})
+    fit(*v, 6);
+  if (modelCache.size() < cubes.size())
+    modelCache.resize(cubes.size());
+
+  for (size_t i = 0; i < n; ++i) {
+    int c = indices ? (*indices)[i] : static_cast<int>(i);
+    const Cube &cube = cubes[c];
+    cubeIndex[i] = c;
+    posX[i] = cube.position.x;
+    posY[i] = cube.position.y;
+    posZ[i] = cube.position.z;
+    rotX[i] = cube.rotation.x;
+    rotY[i] = cube.rotation.y;
+    rotZ[i] = cube.rotation.z;
+    scale[i] = cube.scale;
+  }
+}
+
+void CubeInstanceBatch::assignShared(const CubeInstanceBatch &world,
+                                     const std::vector<int> *indices) {
+  size_t n = indices ? indices->size() : static_cast<size_t>(world.count);
+  shared = &world;
+  count = static_cast<int>(n);
+  cubeIndex.resize(n);
+  for (auto *v : {&clipX, &clipY, &clipW})
+    v->resize(n * 8);
+  for (size_t i = 0; i < n; ++i)
+    cubeIndex[i] = indices ? (*indices)[i] : static_cast<int>(i);
+}
+
+// ============ MATRIZ MODELO ============
+// S * Rx * Ry * Rz em forma fechada (linha-vetor):
+//   Rx*Ry = | cb       0    -sb    |
+//           | sa*sb    ca    sa*cb |
+//           | ca*sb   -sa    ca*cb |
+//   [p q r] * Rz = [p*cg - q*sg, p*sg + q*cg, r]
+// Instancias cujo cubo tem rotacao e escala iguais as do cache so copiam a
+// matriz; intervalos disjuntos tocam entradas disjuntas do cache.
+static void buildModel(const double *rx, const double *ry, const double *rz,
+                       const double *s, const int *cubeIndex,
+                       CubeInstanceBatch::CachedModel *cache,
+                       double *const m[9], int begin, int end) {
+  for (int i = begin; i < end; ++i) {
+    CubeInstanceBatch::CachedModel &cached = cache[cubeIndex[i]];
+    if (cached.valid && cached.rotX == rx[i] && cached.rotY == ry[i] &&
+        cached.rotZ == rz[i] && cached.scale == s[i]) {
+      for (int k = 0; k < 9; ++k)
+        m[k][i] = cached.m[k];
+      continue;
+    }
+    double sa = std::sin(rx[i]), ca = std::cos(rx[i]);
+    double sb = std::sin(ry[i]), cb = std::cos(ry[i]);
+    double sg = std::sin(rz[i]), cg = std::cos(rz[i]);
+    double rows[3][3] = {
+        {cb, 0.0, -sb}, {sa * sb, ca, sa * cb}, {ca * sb, -sa, ca * cb}};
+    for (int r = 0; r < 3; ++r) {
+      double p = rows[r][0], q = rows[r][1];
+      m[r * 3 + 0][i] = s[i] * (p * cg - q * sg);
+      m[r * 3 + 1][i] = s[i] * (p * sg + q * cg);
+      m[r * 3 + 2][i] = s[i] * rows[r][2];
+    }
+    cached = {rx[i], ry[i], rz[i], s[i], {}, true};
+    for (int k = 0; k < 9; ++k)
+      cached.m[k] = m[k][i];
+  }
+}
+
+// ============ CANTOS ============
+
+// Um canto de todas as instancias: mundo = canto * M + pos; clip = mundo * VP
+VECTOR_CLONES
+static void transformCorner(double cx, double cy, double cz,
+                            const double *const m[9],
+                            const double *__restrict px,
+                            const double *__restrict py,
+                            const double *__restrict pz, const double vp[4][4],
+                            double *__restrict wx, double *__restrict wy,
+                            double *__restrict wz, double *__restrict clx,
+                            double *__restrict cly, double *__restrict clw,
+                            int begin, int end) {
+  const double *__restrict m0 = m[0], *__restrict m1 = m[1],
+                           *__restrict m2 = m[2], *__restrict m3 = m[3],
+                           *__restrict m4 = m[4], *__restrict m5 = m[5],
+                           *__restrict m6 = m[6], *__restrict m7 = m[7],
+                           *__restrict m8 = m[8];
+  // Copia local da VP: o compilador nao precisa recarregar a cada iteracao
+  const double v00 = vp[0][0], v10 = vp[1][0], v20 = vp[2][0], v30 = vp[3][0];
+  const double v01 = vp[0][1], v11 = vp[1][1], v21 = vp[2][1], v31 = vp[3][1];
+  const double v03 = vp[0][3], v13 = vp[1][3], v23 = vp[2][3], v33 = vp[3][3];
+  for (int i = begin; i < end; ++i) {
+    double x = cx * m0[i] + cy * m3[i] + cz * m6[i] + px[i];
+    double y = cx * m1[i] + cy * m4[i] + cz * m7[i] + py[i];
+    double z = cx * m2[i] + cy * m5[i] + cz * m8[i] + pz[i];
+    wx[i] = x;
+    wy[i] = y;
+    wz[i] = z;
+    clx[i] = x * v00 + y * v10 + z * v20 + v30;
+    cly[i] = x * v01 + y * v11 + z * v21 + v31;
+    clw[i] = x * v03 + y * v13 + z * v23 + v33;
+  }
+}
+
+// Um canto, so em mundo (etapa compartilhada do multi-view)
+VECTOR_CLONES
+static void worldCorner(double cx, double cy, double cz,
+                        const double *const m[9], const double *__restrict px,
+                        const double *__restrict py,
+                        const double *__restrict pz, double *__restrict wx,
+                        double *__restrict wy, double *__restrict wz,
+                        int begin, int end) {
+  const double *__restrict m0 = m[0], *__restrict m1 = m[1],
+                           *__restrict m2 = m[2], *__restrict m3 = m[3],
+                           *__restrict m4 = m[4], *__restrict m5 = m[5],
+                           *__restrict m6 = m[6], *__restrict m7 = m[7],
+                           *__restrict m8 = m[8];
+  for (int i = begin; i < end; ++i) {
+    wx[i] = cx * m0[i] + cy * m3[i] + cz * m6[i] + px[i];
+    wy[i] = cx * m1[i] + cy * m4[i] + cz * m7[i] + py[i];
+    wz[i] = cx * m2[i] + cy * m5[i] + cz * m8[i] + pz[i];
+  }
+}
+
+// Um canto das instancias de uma vista: clip = mundo * VP, com o mundo
+// lido do lote compartilhado pelo indice do cubo (mesmas operacoes de
+// transformCorner)
+static void projectCorner(const int *__restrict cube,
+                          const double *__restrict wx,
+                          const double *__restrict wy,
+                          const double *__restrict wz, const double vp[4][4],
+                          double *__restrict clx, double *__restrict cly,
+                          double *__restrict clw, int begin, int end) {
+  const double v00 = vp[0][0], v10 = vp[1][0], v20 = vp[2][0], v30 = vp[3][0];
+  const double v01 = vp[0][1], v11 = vp[1][1], v21 = vp[2][1], v31 = vp[3][1];
+  const double v03 = vp[0][3], v13 = vp[1][3], v23 = vp[2][3], v33 = vp[3][3];
+  for (int i = begin; i < end; ++i) {
+    double x = wx[cube[i]], y = wy[cube[i]], z = wz[cube[i]];
+    clx[i] = x * v00 + y * v10 + z * v20 + v30;
+    cly[i] = x * v01 + y * v11 + z * v21 + v31;
+    clw[i] = x * v03 + y * v13 + z * v23 + v33;
+  }
+}
+
+// ============ NORMAIS ============
+
+// Normal de um eixo (linha `row` da matriz modelo) normalizada, +/-
+VECTOR_CLONES
+static void transformNormal(const double *__restrict mx,
+                            const double *__restrict my,
+                            const double *__restrict mz,
+                            double *__restrict posX, double *__restrict posY,
+                            double *__restrict posZ, double *__restrict negX,
+                            double *__restrict negY, double *__restrict negZ,
+                            int begin, int end) {
+  for (int i = begin; i < end; ++i) {
+    double x = mx[i], y = my[i], z = mz[i];
+    double len = std::sqrt(x * x + y * y + z * z);
+    double inv = len == 0.0 ? 1.0 : 1.0 / len; // Evita divisao por 0
+    posX[i] = x * inv;
+    posY[i] = y * inv;
+    posZ[i] = z * inv;
+    negX[i] = -x * inv;
+    negY[i] = -y * inv;
+    negZ[i] = -z * inv;
+  }
+}
+
+// Normais das 6 faces: front/back = linha 2, right/left = linha 0,
+// top/bottom = linha 1 da matriz modelo
+static void faceNormals(CubeInstanceBatch &b, double *const m[9], int begin,
+                        int end) {
+  const size_t n = static_cast<size_t>(b.count);
+  static const int axisRow[3] = {2, 0, 1};
+  for (int a = 0; a < 3; ++a) {
+    int r = axisRow[a];
+    size_t op = (2 * a) * n, on = (2 * a + 1) * n;
+    transformNormal(m[r * 3 + 0], m[r * 3 + 1], m[r * 3 + 2],
+                    b.normalX.data() + op, b.normalY.data() + op,
+                    b.normalZ.data() + op, b.normalX.data() + on,
+                    b.normalY.data() + on, b.normalZ.data() + on, begin, end);
+  }
+}
+
+void CubeInstanceBatch::transform(const Mat4 &viewProj, int begin, int end) {
+  const size_t n = static_cast<size_t>(count);
+  if (shared) {
+    const size_t worldCount = static_cast<size_t>(shared->count);
+    for (int c = 0; c < 8; ++c) {
+      size_t o = c * n, wo = c * worldCount;
+      projectCorner(cubeIndex.data(), shared->worldX.data() + wo,
+                    shared->worldY.data() + wo, shared->worldZ.data() + wo,
+                    viewProj.m, clipX.data() + o, clipY.data() + o,
+                    clipW.data() + o, begin, end);
+    }
+    return;
+  }
+  double *m[9];
+  for (int k = 0; k < 9; ++k)
+    m[k] = model[k].data();
+  buildModel(rotX.data(), rotY.data(), rotZ.data(), scale.data(),
+             cubeIndex.data(), modelCache.data(), m, begin, end);
+
+  const double *const cm[9] = {m[0], m[1], m[2], m[3], m[4],
+                               m[5], m[6], m[7], m[8]};
+  for (int c = 0; c < 8; ++c) {
+    size_t o = c * n;
+    transformCorner(cornerX[c], cornerY[c], cornerZ[c], cm, posX.data(),
+                    posY.data(), posZ.data(), viewProj.m, worldX.data() + o,
+                    worldY.data() + o, worldZ.data() + o, clipX.data() + o,
+                    clipY.data() + o, clipW.data() + o, begin, end);
+  }
+
+  faceNormals(*this, m, begin, end);
+}
+
+void CubeInstanceBatch::transformWorld(int begin, int end) {
+  const size_t n = static_cast<size_t>(count);
+  double *m[9];
+  for (int k = 0; k < 9; ++k)
+    m[k] = model[k].data();
+  buildModel(rotX.data(), rotY.data(), rotZ.data(), scale.data(),
+             cubeIndex.data(), modelCache.data(), m, begin, end);
+
+  const double *const cm[9] = {m[0], m[1], m[2], m[3], m[4],
+                               m[5], m[6], m[7], m[8]};
+  for (int c = 0; c < 8; ++c) {
+    size_t o = c * n;
+    worldCorner(cornerX[c], cornerY[c], cornerZ[c], cm, posX.data(),
+                posY.data(), posZ.data(), worldX.data() + o,
+                worldY.data() + o, worldZ.data() + o, begin, end);
+  }
+  faceNormals(*this, m, begin, end);
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include "../core/Cube.h"
+#include "../math/Matrix.h"
+#include <vector>
+
+// Lote de instancias de cubo em SoA (estrutura de arrays).
+// Em vez de montar S*Rx*Ry*Rz*T com quatro produtos de matrizes por cubo e
+// levar cada vertice ao clip space com tres produtos matriz-vetor, o lote
+// calcula a matriz modelo em forma fechada e transforma os 8 cantos de todas
+// as instancias com uma unica view-projection por frame. Os lacos internos
+// percorrem instancias contiguas (vetorizados pelo compilador) e intervalos
+// disjuntos podem ser transformados em paralelo.
+struct CubeInstanceBatch {
+  int count{0};
+
+  // Indice do cubo na cena de cada instancia (o lote pode conter so os
+  // cubos visiveis)
+  std::vector<int> cubeIndex;
+
+  // Entrada (uma entrada por instancia)
+  std::vector<double> posX, posY, posZ;
+  std::vector<double> rotX, rotY, rotZ;
+  std::vector<double> scale;
+
+  // Parte 3x3 da matriz modelo (escala * rotacao), m[linha*3 + coluna],
+  // mesma convencao linha-vetor de Mat4; a translacao e pos
+  std::vector<double> model[9];
+
+  // Cantos transformados: indice canto*count + instancia
+  std::vector<double> worldX, worldY, worldZ;
+  std::vector<double> clipX, clipY, clipW;
+
+  // Normais das 6 faces em mundo (normalizadas): indice face*count + inst.
+  // Mesma ordem de faces do Renderer (front, back, right, left, top, bottom)
+  std::vector<double> normalX, normalY, normalZ;
+
+  // Cache da parte 3x3 entre frames, por indice do cubo na cena: cubo com
+  // a mesma rotacao e escala da ultima vez nao recalcula seno/cosseno.
+  // A chave sao os proprios valores, entao o lote pode alternar entre cenas.
+  struct CachedModel {
+    double rotX, rotY, rotZ, scale;
+    double m[9];
+    bool valid{false};
+  };
+  std::vector<CachedModel> modelCache;
+
+  // Multi-view: lote com todos os cubos da cena (instancia = cubo) cuja
+  // parte em mundo ja foi feita por transformWorld(). Este lote entao so
+  // guarda cubeIndex e o clip space da sua camera; cantos em mundo e
+  // normais sao lidos de `shared` (ver worldSource/worldSlot).
+  const CubeInstanceBatch *shared{nullptr};
+
+  // Copia posicao/rotacao/escala dos cubos e dimensiona as saidas.
+  // Com `indices`, o lote recebe apenas esses cubos, nessa ordem.
+  void assign(const std::vector<Cube> &cubes,
+              const std::vector<int> *indices = nullptr);
+  // Como assign, mas com a parte em mundo de `world` (ver `shared`)
+  void assignShared(const CubeInstanceBatch &world,
+                    const std::vector<int> *indices = nullptr);
+
+  // Transforma as instancias [begin, end) com a view-projection do frame
+  // (com `shared`, so calcula o clip space)
+  void transform(const Mat4 &viewProj, int begin, int end);
+  // So a parte independente da camera: matriz modelo, cantos em mundo e
+  // normais (o clip space fica por conta dos lotes que compartilham este)
+  void transformWorld(int begin, int end);
+
+  // Lote que tem os cantos em mundo e as normais, e a instancia deles que
+  // corresponde a instancia `i` deste lote
+  const CubeInstanceBatch &worldSource() const {
+    return shared ? *shared : *this;
+  }
+  int worldSlot(int i) const { return shared ? cubeIndex[i] : i; }
+};
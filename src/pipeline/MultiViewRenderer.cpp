@@ -0,0 +1,65 @@
+#include "MultiViewRenderer.h"
+#include <algorithm>
+
+MultiViewRenderer::MultiViewRenderer(ThreadPool &pool) : pool(pool) {}
+
+void MultiViewRenderer::render(const Scene &scene,
+                               const std::vector<Camera> &cameras,
+                               const std::vector<Framebuffer *> &targets,
+                               const RenderOptions &options) {
+  const int views = static_cast<int>(std::min(cameras.size(), targets.size()));
+  while ((int)renderers.size() < views)
+    renderers.push_back(std::make_unique<Renderer>(pool));
+  if (views == 0)
+    return;
+
+  world.build(scene, pool);
+  world.shadows = nullptr;
+  if (options.shadows && !options.depthOnly) {
+    if (!shadows)
+      shadows = std::make_unique<ShadowMapCache>(pool);
+    shadows->update(scene, options);
+    world.shadows = shadows.get();
+  }
+
+  // Vistas em paralelo; o que sobra do pool vai para os tiles de cada uma
+  RenderOptions viewOptions = options;
+  if (viewOptions.numThreads == 0)
+    viewOptions.numThreads = std::max(1, pool.size() / views);
+  pool.parallelFor(views, [&](int v) {
+    renderers[v]->render(scene, cameras[v], world, *targets[v], viewOptions);
+  });
+}
+
+std::array<Camera, 6> MultiViewRenderer::cubeMapCameras(const Vec3 &position,
+                                                        double nearPlane,
+                                                        double farPlane) {
+  static const Vec3 directions[6] = {{1, 0, 0},  {-1, 0, 0}, {0, 1, 0},
+                                     {0, -1, 0}, {0, 0, 1},  {0, 0, -1}};
+  static const Vec3 ups[6] = {{0, 1, 0},  {0, 1, 0}, {0, 0, -1},
+                              {0, 0, 1},  {0, 1, 0}, {0, 1, 0}};
+  std::array<Camera, 6> faces;
+  for (int f = 0; f < 6; ++f) {
+    Camera &c = faces[f];
+    c.eye = position;
+    c.center = position + directions[f];
+    c.up = ups[f];
+    c.fovY = 90.0;
+    c.aspect = 1.0;
+    c.nearPlane = nearPlane;
+    c.farPlane = farPlane;
+  }
+  return faces;
+}
+
+std::array<Camera, 2> MultiViewRenderer::stereoCameras(const Camera &center,
+                                                       double separation) {
+  Vec3 right = (center.center - center.eye).cross(center.up).normalized();
+  Vec3 offset = right * (separation * 0.5);
+  std::array<Camera, 2> eyes{center, center};
+  eyes[0].eye = center.eye - offset;
+  eyes[0].center = center.center - offset;
+  eyes[1].eye = center.eye + offset;
+  eyes[1].center = center.center + offset;
+  return eyes;
+}
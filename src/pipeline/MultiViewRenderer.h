@@ -0,0 +1,49 @@
+#pragma once
+#include "Renderer.h"
+#include "Shadows.h"
+#include <array>
+#include <memory>
+#include <vector>
+
+// Render da mesma cena por varias cameras (par estereo, 6 faces de um cube
+// map, mosaico de cameras de vigilancia).
+// A etapa em mundo (BVH, matrizes modelo, cantos e normais dos cubos,
+// vertices das malhas) e feita uma vez por chamada (WorldStage); cada vista
+// so projeta, faz culling, monta os triangulos e rasteriza, com as vistas
+// em paralelo no pool e um Renderer por vista (buffers reaproveitados entre
+// chamadas). Cada vista sai identica a Renderer::render com a sua camera.
+// Com sombras os shadow maps tambem sao da chamada (um cache para todas as
+// vistas), nao de cada Renderer.
+class MultiViewRenderer {
+public:
+  explicit MultiViewRenderer(ThreadPool &pool = ThreadPool::global());
+
+  // Vista i: cameras[i] em *targets[i] (mesmo numero; framebuffers ja
+  // limpos pelo chamador, tamanhos podem diferir). scene.camera e ignorada.
+  void render(const Scene &scene, const std::vector<Camera> &cameras,
+              const std::vector<Framebuffer *> &targets,
+              const RenderOptions &options);
+
+  int viewCount() const { return static_cast<int>(renderers.size()); }
+  // Estatisticas da vista i no ultimo render
+  const RenderStats &viewStats(int i) const {
+    return renderers[i]->renderStats();
+  }
+
+  // Faces +X, -X, +Y, -Y, +Z, -Z de um cube map em `position` (90 graus,
+  // aspecto 1). Faces laterais com up +Y; +Y com up -Z e -Y com up +Z, de
+  // modo que as bordas de cima e de baixo encostam na face +Z.
+  static std::array<Camera, 6> cubeMapCameras(const Vec3 &position,
+                                              double nearPlane,
+                                              double farPlane);
+  // Olhos esquerdo e direito: `center` deslocada de -/+ separation/2 ao
+  // longo do eixo direito, com as direcoes de visao paralelas
+  static std::array<Camera, 2> stereoCameras(const Camera &center,
+                                             double separation);
+
+private:
+  ThreadPool &pool;
+  WorldStage world;
+  std::unique_ptr<ShadowMapCache> shadows; // criado com a 1a sombra
+  std::vector<std::unique_ptr<Renderer>> renderers; // um por vista
+};
@@ -1,214 +1,619 @@
 #include "Rasterizer.h"
+#include "RenderStats.h"
+#include "Renderer.h"
 #include "../core/Scene.h"
 #include "../math/Matrix.h"
 #include "../math/Vector.h"
 #include "Shading.h"
-#include "Transform.h"
+#include "Shadows.h"
 #include <algorithm>
-#include <array>
 #include <cmath>
-#include <cstdio>
 
 
 Framebuffer::Framebuffer(int w, int h)
-    : width(w), height(h), color(w * h, 0xff000000), depth(w * h, -1e9) {}
+    : width(w), height(h), color(nullptr), depth(w * h, DEPTH_CLEAR),
+      ownedColor(w * h, 0xff000000) {
+  color = ownedColor.data();
+  resetHiZ();
+}
+
+void Framebuffer::resize(int w, int h) {
+  bool external = color != ownedColor.data();
+  width = w;
+  height = h;
+  depth.resize(static_cast<size_t>(w) * h * samples, DEPTH_CLEAR);
+  if (samples > 1)
+    sampleColor.resize(static_cast<size_t>(w) * h * samples, 0xff000000);
+  if (!external) {
+    ownedColor.resize(static_cast<size_t>(w) * h, 0xff000000);
+    color = ownedColor.data();
+  }
+  resetHiZ();
+}
+
+void Framebuffer::resetHiZ() {
+  hiZWidth = (width + HIZ_BLOCK - 1) / HIZ_BLOCK;
+  hiZHeight = (height + HIZ_BLOCK - 1) / HIZ_BLOCK;
+  hiZ.assign(static_cast<size_t>(hiZWidth) * hiZHeight, DEPTH_CLEAR);
+}
+
+void Framebuffer::updateHiZ(int x0, int y0, int x1, int y1) {
+  x0 = std::max(x0, 0) / HIZ_BLOCK;
+  y0 = std::max(y0, 0) / HIZ_BLOCK;
+  x1 = std::min(x1, width - 1) / HIZ_BLOCK;
+  y1 = std::min(y1, height - 1) / HIZ_BLOCK;
+  for (int by = y0; by <= y1; ++by) {
+    int py1 = std::min(height, (by + 1) * HIZ_BLOCK);
+    for (int bx = x0; bx <= x1; ++bx) {
+      int px0 = bx * HIZ_BLOCK, px1 = std::min(width, px0 + HIZ_BLOCK);
+      // Com MSAA as amostras de um pixel sao contiguas
+      const int s0 = px0 * samples, s1 = px1 * samples;
+      DepthValue farthest =
+          depth[static_cast<size_t>(by) * HIZ_BLOCK * width * samples + s0];
+      for (int y = by * HIZ_BLOCK; y < py1; ++y) {
+        const DepthValue *row =
+            &depth[static_cast<size_t>(y) * width * samples];
+        for (int x = s0; x < s1; ++x)
+          farthest = std::min(farthest, row[x]);
+      }
+      hiZ[static_cast<size_t>(by) * hiZWidth + bx] = farthest;
+    }
+  }
+}
+
+void Framebuffer::attachColor(uint32_t *pixels) {
+  if (pixels) {
+    color = pixels;
+  } else {
+    ownedColor.resize(static_cast<size_t>(width) * height, 0xff000000);
+    color = ownedColor.data();
+  }
+}
+
+void Framebuffer::setSamples(int count) {
+  count = msaaSampleCount(count);
+  if (count == samples)
+    return;
+  const size_t pixels = static_cast<size_t>(width) * height;
+  std::vector<DepthValue> newDepth(pixels * count);
+  std::vector<uint32_t> newColor(count > 1 ? pixels * count : 0);
+  for (size_t p = 0; p < pixels; ++p) {
+    // Profundidade mais proxima das amostras antigas (o Hi-Z continua
+    // conservador)
+    DepthValue d = depth[p * samples];
+    for (int k = 1; k < samples; ++k)
+      d = std::max(d, depth[p * samples + k]);
+    for (int k = 0; k < count; ++k)
+      newDepth[p * count + k] = d;
+    if (count > 1)
+      std::fill_n(&newColor[p * count], count, color[p]);
+  }
+  samples = count;
+  depth.swap(newDepth);
+  sampleColor.swap(newColor);
+}
+
+// Media por canal, arredondada; pixel com todas as amostras iguais (o caso
+// comum, longe das bordas) e so copiado
+void Framebuffer::resolve(int x0, int y0, int x1, int y1) {
+  if (samples == 1)
+    return;
+  const int shift = samples == 8 ? 3 : samples == 4 ? 2 : 1;
+  const uint32_t half = samples / 2;
+  for (int y = y0; y < y1; ++y) {
+    size_t p = static_cast<size_t>(y) * width + x0;
+    const uint32_t *in = &sampleColor[p * samples];
+    for (int x = x0; x < x1; ++x, ++p, in += samples) {
+      bool uniform = true;
+      for (int k = 1; k < samples; ++k)
+        uniform &= in[k] == in[0];
+      if (uniform) {
+        color[p] = in[0];
+        continue;
+      }
+      uint32_t r = half, g = half, b = half;
+      for (int k = 0; k < samples; ++k) {
+        r += (in[k] >> 16) & 0xff;
+        g += (in[k] >> 8) & 0xff;
+        b += in[k] & 0xff;
+      }
+      color[p] = 0xff000000 | ((r >> shift) << 16) | ((g >> shift) << 8) |
+                 (b >> shift);
+    }
+  }
+}
 
 void Framebuffer::clear(uint32_t c) {
-  std::fill(color.begin(), color.end(), c);
-  std::fill(depth.begin(), depth.end(), -1e9);
+  std::fill(color, color + static_cast<size_t>(width) * height, c);
+  std::fill(sampleColor.begin(), sampleColor.end(), c);
+  std::fill(depth.begin(), depth.end(), DEPTH_CLEAR);
+  std::fill(hiZ.begin(), hiZ.end(), DEPTH_CLEAR);
+}
+
+void Framebuffer::clearRect(int x0, int y0, int x1, int y1, uint32_t c) {
+  x0 = std::max(x0, 0);
+  y0 = std::max(y0, 0);
+  x1 = std::min(x1, width);
+  y1 = std::min(y1, height);
+  if (x0 >= x1 || y0 >= y1)
+    return;
+  for (int y = y0; y < y1; ++y) {
+    size_t row = static_cast<size_t>(y) * width;
+    std::fill(color + row + x0, color + row + x1, c);
+    size_t s0 = (row + x0) * samples, s1 = (row + x1) * samples;
+    std::fill(depth.begin() + s0, depth.begin() + s1, DEPTH_CLEAR);
+    if (samples > 1)
+      std::fill(sampleColor.begin() + s0, sampleColor.begin() + s1, c);
+  }
+  updateHiZ(x0, y0, x1 - 1, y1 - 1);
 }
 
+// Com MSAA o pixel inteiro (todas as amostras) recebe o mesmo valor
 void Framebuffer::putPixel(int x, int y, double z, const Vec3 &col) {
   if (x < 0 || x >= width || y < 0 || y >= height)
     return;
-  int idx = y * width + x;
-  if (z > depth[idx]) {
-    depth[idx] = z;
-    // Converte RGB [0,1] para ARGB uint32
-    uint8_t r = static_cast<uint8_t>(std::clamp(col.x, 0.0, 1.0) * 255.0);
-    uint8_t g = static_cast<uint8_t>(std::clamp(col.y, 0.0, 1.0) * 255.0);
-    uint8_t b = static_cast<uint8_t>(std::clamp(col.z, 0.0, 1.0) * 255.0);
-    color[idx] = 0xff000000 | (r << 16) | (g << 8) | b;
+  size_t idx = static_cast<size_t>(y) * width + x;
+  DepthValue d = static_cast<DepthValue>(z);
+  RENDER_STAT_ADD(pixelsCovered, 1);
+  bool passed = false;
+  for (int k = 0; k < samples; ++k) {
+    if (!(d > depth[idx * samples + k]))
+      continue;
+    depth[idx * samples + k] = d;
+    if (samples > 1)
+      sampleColor[idx * samples + k] = packColor(col);
+    passed = true;
   }
+  if (!passed)
+    RENDER_STAT_ADD(depthFails, 1);
+  else if (samples == 1)
+    color[idx] = packColor(col);
+  else
+    resolve(x, y, x + 1, y + 1);
 }
 
-// ============ ESTRUTURAS AUXILIARES ============
-
-struct Vertex {
-  Vec3 screen; // coordenadas de tela (x, y, z)
-  Vec3 world;  // posição em espaço mundo
-  Vec3 normal; // normal do vértice
-};
+void GBuffer::reset(const PixelRect &r) {
+  rect = r;
+  stride = r.x1 - r.x0;
+  size_t n = static_cast<size_t>(stride) * (r.y1 - r.y0);
+  for (auto *v : {&normalX, &normalY, &normalZ, &worldX, &worldY, &worldZ})
+    v->resize(n);
+  material.assign(n, -1);
+}
 
-struct Barycentric {
-  double u, v, w;
-  bool inside() const { return u >= 0 && v >= 0 && w >= 0; }
-};
+// ============ SETUP DO TRIÂNGULO ============
+
+// Coordenadas acima disso nao cabem no ponto fixo sem overflow em int64
+static constexpr double GUARD_BAND = double(1 << 20);
+
+// Divisoes por 256 com arredondamento para baixo/cima (valores negativos ok)
+static inline int64_t floorSub(int64_t v) { return v >> SUBPIXEL_BITS; }
+static inline int64_t ceilSub(int64_t v) { return -((-v) >> SUBPIXEL_BITS); }
+
+bool setupTriangle(RasterTriangle &tri, int fbWidth, int fbHeight,
+                   bool multisample) {
+  int64_t X[3], Y[3];
+  for (int i = 0; i < 3; ++i) {
+    double sx = tri.v[i].screen.x, sy = tri.v[i].screen.y;
+    // !(a <= b) tambem descarta NaN
+    if (!(std::abs(sx) <= GUARD_BAND) || !(std::abs(sy) <= GUARD_BAND))
+      return false;
+    X[i] = std::llround(sx * SUBPIXEL_ONE);
+    Y[i] = std::llround(sy * SUBPIXEL_ONE);
+  }
 
-// ============ FUNÇÕES AUXILIARES ============
+  // Aresta i liga os vertices (i+1) e (i+2), oposta ao vertice i
+  int64_t area = 0;
+  for (int i = 0; i < 3; ++i) {
+    int a = (i + 1) % 3, b = (i + 2) % 3;
+    EdgeEquation &e = tri.edge[i];
+    e.A = Y[a] - Y[b];
+    e.B = X[b] - X[a];
+    e.C = X[a] * Y[b] - Y[a] * X[b];
+    if (i == 0)
+      area = e.A * X[0] + e.B * Y[0] + e.C;
+  }
+  if (area == 0)
+    return false; // triângulo degenerado
+
+  // Orienta as arestas para o interior ficar positivo (aceita CW e CCW)
+  for (auto &e : tri.edge) {
+    if (area < 0) {
+      e.A = -e.A;
+      e.B = -e.B;
+      e.C = -e.C;
+    }
+    // Regra top-left (y para baixo): aresta "left" tem o interior a direita
+    // (A > 0); aresta "top" e horizontal com o interior abaixo (B > 0)
+    bool topLeft = e.A > 0 || (e.A == 0 && e.B > 0);
+    e.bias = topLeft ? 0 : -1;
+  }
+  tri.invArea = 1.0 / static_cast<double>(area < 0 ? -area : area);
+
+  // Bounding box em pixels: so entram pixels cujo centro cai no triangulo
+  int64_t minFX = std::min({X[0], X[1], X[2]});
+  int64_t maxFX = std::max({X[0], X[1], X[2]});
+  int64_t minFY = std::min({Y[0], Y[1], Y[2]});
+  int64_t maxFY = std::max({Y[0], Y[1], Y[2]});
+  const int64_t half = SUBPIXEL_ONE / 2;
+  if (multisample) {
+    // Qualquer pixel que o triangulo toque (amostras ficam dentro do pixel)
+    tri.minX = (int)std::max<int64_t>(0, floorSub(minFX));
+    tri.maxX = (int)std::min<int64_t>(fbWidth - 1, floorSub(maxFX));
+    tri.minY = (int)std::max<int64_t>(0, floorSub(minFY));
+    tri.maxY = (int)std::min<int64_t>(fbHeight - 1, floorSub(maxFY));
+  } else {
+    tri.minX = (int)std::max<int64_t>(0, ceilSub(minFX - half));
+    tri.maxX = (int)std::min<int64_t>(fbWidth - 1, floorSub(maxFX - half));
+    tri.minY = (int)std::max<int64_t>(0, ceilSub(minFY - half));
+    tri.maxY = (int)std::min<int64_t>(fbHeight - 1, floorSub(maxFY - half));
+  }
+  return tri.minX <= tri.maxX && tri.minY <= tri.maxY;
+}
 
-Barycentric barycentric(double px, double py, const Vertex &a, const Vertex &b,
-                        const Vertex &c) {
-  double x0 = a.screen.x, y0 = a.screen.y;
-  double x1 = b.screen.x, y1 = b.screen.y;
-  double x2 = c.screen.x, y2 = c.screen.y;
+// ============ MSAA ============
 
-  double denom = (y1 - y2) * (x0 - x2) + (x2 - x1) * (y0 - y2);
-  if (std::abs(denom) < 1e-10) {
-    return {-1, -1, -1}; // triângulo degenerado
-  }
+// Posicoes das amostras (padroes do D3D) em 1/16 de pixel a partir do
+// centro; `reach` e o maior deslocamento em x ou y
+struct SamplePattern {
+  int count;
+  int x[8], y[8];
+  int64_t reach;
+};
 
-  double u = ((y1 - y2) * (px - x2) + (x2 - x1) * (py - y2)) / denom;
-  double v = ((y2 - y0) * (px - x2) + (x0 - x2) * (py - y2)) / denom;
-  double w = 1.0 - u - v;
+static const SamplePattern &samplePattern(int samples) {
+  static const SamplePattern patterns[] = {
+      {1, {0}, {0}, 0},
+      {2, {4, -4}, {4, -4}, 4},
+      {4, {-2, 6, -6, 2}, {-6, -2, 2, 6}, 6},
+      {8, {1, -1, 5, -3, -5, -7, 3, 7}, {-3, 3, 1, -5, 5, -1, 7, -7}, 7}};
+  int k = samples == 8 ? 3 : samples == 4 ? 2 : samples == 2 ? 1 : 0;
+  return patterns[k];
+}
 
-  return {u, v, w};
+int msaaSampleCount(int requested) {
+  return requested >= 8 ? 8 : requested >= 4 ? 4 : requested >= 2 ? 2 : 1;
 }
 
 // ============ RASTERIZAÇÃO DE TRIÂNGULOS ============
 
-void rasterizeTriangle(Framebuffer &fb, const Vertex &v0, const Vertex &v1,
-                       const Vertex &v2, const Vec3 &faceNormal,
-                       const Material &mat, const std::vector<Light> &lights,
-                       const Vec3 &eyePos, bool usePhong) {
-  // Bounding box do triângulo
-  int minX = std::max(
-      0, (int)std::floor(std::min({v0.screen.x, v1.screen.x, v2.screen.x})));
-  int maxX = std::min(
-      fb.width - 1,
-      (int)std::ceil(std::max({v0.screen.x, v1.screen.x, v2.screen.x})));
-  int minY = std::max(
-      0, (int)std::floor(std::min({v0.screen.y, v1.screen.y, v2.screen.y})));
-  int maxY = std::min(
-      fb.height - 1,
-      (int)std::ceil(std::max({v0.screen.y, v1.screen.y, v2.screen.y})));
-
-  // Flat shading: calcula cor uma vez
-  Vec3 faceCenter = (v0.world + v1.world + v2.world) * (1.0 / 3.0);
-  Vec3 flatColor =
-      computeLighting(faceNormal, faceCenter, mat, lights, eyePos, false);
-
-  // Scanline: percorre pixels do bounding box
-  for (int y = minY; y <= maxY; ++y) {
-    for (int x = minX; x <= maxX; ++x) {
-      Barycentric bc = barycentric(x + 0.5, y + 0.5, v0, v1, v2);
-
-      if (!bc.inside())
-        continue;
+// Blocos de 8x8 pixels testados inteiros contra as arestas
+static constexpr int BLOCK_SIZE = 8;
 
-      // Interpolar profundidade
-      double z = bc.u * v0.screen.z + bc.v * v1.screen.z + bc.w * v2.screen.z;
-
-      Vec3 color;
-      if (usePhong) {
-        // Phong: interpola normal e posição
-        Vec3 normal = (v0.normal * bc.u + v1.normal * bc.v + v2.normal * bc.w)
-                          .normalized();
-        Vec3 pos = v0.world * bc.u + v1.world * bc.v + v2.world * bc.w;
-        color = computeLighting(normal, pos, mat, lights, eyePos, true);
-      } else {
-        // Flat: usa cor pré-calculada
-        color = flatColor;
-      }
+// Centro do pixel em ponto fixo
+static inline int64_t pixelCenter(int p) {
+  return (int64_t(p) << SUBPIXEL_BITS) + SUBPIXEL_ONE / 2;
+}
 
-      // Z-buffer test e write
-      fb.putPixel(x, y, z, color);
+// Kernel de um modo fixo: os testes de modo saem do laco por pixel.
+// MSAA: cobertura e z-test em cada amostra do pixel; o shading e feito uma
+// vez (no centro, ou na primeira amostra coberta se o centro esta fora) e
+// a cor vai para as amostras que passaram no z-test.
+template <RasterMode MODE, bool MSAA>
+static int rasterizeKernel(Framebuffer &fb, const RasterTriangle &tri,
+                           const PixelRect &rect, const ShadingContext &shading,
+                           GBuffer *gbuffer) {
+  constexpr bool usePhong =
+      MODE == RasterMode::Phong || MODE == RasterMode::Deferred;
+  static_assert(!MSAA || MODE == RasterMode::Flat || MODE == RasterMode::Phong,
+                "MSAA usa o caminho direto");
+  const Vertex &v0 = tri.v[0];
+  const Vertex &v1 = tri.v[1];
+  const Vertex &v2 = tri.v[2];
+  const EdgeEquation &e0 = tri.edge[0];
+  const EdgeEquation &e1 = tri.edge[1];
+  const EdgeEquation &e2 = tri.edge[2];
+
+  // Bounding box do triângulo recortado ao retangulo (tile)
+  int minX = std::max(tri.minX, rect.x0);
+  int maxX = std::min(tri.maxX, rect.x1 - 1);
+  int minY = std::max(tri.minY, rect.y0);
+  int maxY = std::min(tri.maxY, rect.y1 - 1);
+  if (minX > maxX || minY > maxY)
+    return 0;
+
+  // Passo das equacoes de aresta por pixel em x e y
+  const int64_t step0X = e0.A << SUBPIXEL_BITS, step0Y = e0.B << SUBPIXEL_BITS;
+  const int64_t step1X = e1.A << SUBPIXEL_BITS, step1Y = e1.B << SUBPIXEL_BITS;
+  const int64_t step2X = e2.A << SUBPIXEL_BITS, step2Y = e2.B << SUBPIXEL_BITS;
+
+  auto evalEdge = [](const EdgeEquation &e, int x, int y) {
+    return e.A * pixelCenter(x) + e.B * pixelCenter(y) + e.C + e.bias;
+  };
+  // Maior/menor valor da aresta num bloco [x0,x1]x[y0,y1] (funcao linear,
+  // entao o extremo esta num canto)
+  auto edgeMax = [&](const EdgeEquation &e, int x0, int y0, int x1, int y1) {
+    return evalEdge(e, e.A >= 0 ? x1 : x0, e.B >= 0 ? y1 : y0);
+  };
+  auto edgeMin = [&](const EdgeEquation &e, int x0, int y0, int x1, int y1) {
+    return evalEdge(e, e.A >= 0 ? x0 : x1, e.B >= 0 ? y0 : y1);
+  };
+
+  // MSAA: valor de cada aresta na amostra k = valor no centro + off*[k], e
+  // folga dos testes de bloco (maior variacao dentro do pixel)
+  const int S = MSAA ? fb.samples : 1;
+  int64_t off0[8] = {}, off1[8] = {}, off2[8] = {};
+  int64_t margin0 = 0, margin1 = 0, margin2 = 0;
+  if constexpr (MSAA) {
+    constexpr int64_t unit = SUBPIXEL_ONE / 16;
+    const SamplePattern &pattern = samplePattern(S);
+    for (int k = 0; k < S; ++k) {
+      off0[k] = (e0.A * pattern.x[k] + e0.B * pattern.y[k]) * unit;
+      off1[k] = (e1.A * pattern.x[k] + e1.B * pattern.y[k]) * unit;
+      off2[k] = (e2.A * pattern.x[k] + e2.B * pattern.y[k]) * unit;
     }
+    const int64_t reach = pattern.reach * unit;
+    margin0 = (std::abs(e0.A) + std::abs(e0.B)) * reach;
+    margin1 = (std::abs(e1.A) + std::abs(e1.B)) * reach;
+    margin2 = (std::abs(e2.A) + std::abs(e2.B)) * reach;
   }
-}
-
-// ============ DADOS DO CUBO ============
-
-// Faces do cubo (12 triângulos = 6 faces × 2 triângulos)
-static const std::array<std::array<int, 3>, 12> cubeFaces = {{
-    {4, 5, 6},
-    {4, 6, 7}, // Front (z = +0.5)
-    {1, 0, 3},
-    {1, 3, 2}, // Back (z = -0.5)
-    {5, 1, 2},
-    {5, 2, 6}, // Right (x = +0.5)
-    {0, 4, 7},
-    {0, 7, 3}, // Left (x = -0.5)
-    {7, 6, 2},
-    {7, 2, 3}, // Top (y = +0.5)
-    {0, 1, 5},
-    {0, 5, 4} // Bottom (y = -0.5)
-}};
-
-// Normais de cada face (sem transformação)
-static const std::array<Vec3, 6> faceNormals = {{
-    {0, 0, 1},  // front
-    {0, 0, -1}, // back
-    {1, 0, 0},  // right
-    {-1, 0, 0}, // left
-    {0, 1, 0},  // top
-    {0, -1, 0}  // bottom
-}};
-
-// ============ RENDERIZAÇÃO DO CUBO ============
-
-void renderCube(const Cube &cube, const Camera &camera,
-                const std::vector<Light> &lights, Framebuffer &fb,
-                bool usePhong) {
-  // 1. Vértices do cubo no SRU (object space)
-  Vec3 baseVerts[8];
-  Cube::baseVertices(baseVerts);
-
-  // 2. Matrizes de transformação
-  Mat4 model = cube.modelMatrix();
-  Mat4 view = camera.viewMatrix();
-  Mat4 proj = camera.projectionMatrix();
-
-  // 3. Transformar vértices para clip space e tela
-  Vertex verts[8];
-  for (int i = 0; i < 8; ++i) {
-    // Para mundo (ORDEM CORRETA: model * ponto)
-    Vec4 worldPos4 = model * toVec4(baseVerts[i]);
-    verts[i].world = Vec3{worldPos4.x, worldPos4.y, worldPos4.z};
-
-    // Para NDC
-    Vec3 ndc = transformToNDC(baseVerts[i], model, view, proj);
-
-    // NDC [-1,1] → tela [0, width/height]
-    verts[i].screen.x = (ndc.x + 1.0) * 0.5 * fb.width;
-    verts[i].screen.y = (1.0 - ndc.y) * 0.5 * fb.height; // Y invertido
-    verts[i].screen.z = ndc.z;                           // depth para z-buffer
+  const unsigned allSamples = (1u << S) - 1;
+
+  // Phong: fragmentos de uma linha do bloco vao para o kernel em pacote
+  PhongPacketSetup phong;
+  PhongPacketFn phongKernel = nullptr;
+  PhongShadeFn shadeKernel = nullptr;
+  if constexpr (usePhong) {
+    setupPhongPacket(phong, *tri.material, shading);
+    for (int i = 0; i < 3; ++i) {
+      phong.nx[i] = tri.v[i].normal.x;
+      phong.ny[i] = tri.v[i].normal.y;
+      phong.nz[i] = tri.v[i].normal.z;
+      phong.wx[i] = tri.v[i].world.x;
+      phong.wy[i] = tri.v[i].world.y;
+      phong.wz[i] = tri.v[i].world.z;
+    }
+    if constexpr (MODE == RasterMode::Phong)
+      phongKernel = phongPacketKernel(phong);
+  }
+  // Sombras (direto): visibilidade das luzes calculada antes de cada pacote.
+  // A amostragem precisa da normal e da posicao interpoladas; o pacote usa
+  // entao o kernel do resolve, que as recebe prontas, em vez de interpolar
+  // de novo
+  thread_local std::vector<double> shadowScratch;
+  const bool shadowed = MODE == RasterMode::Phong && shading.lightSoA.anyShadow;
+  if (shadowed) {
+    shadeKernel = phongShadeKernel(phong);
+    size_t needed = static_cast<size_t>(shading.lightSoA.count) *
+                    PHONG_PACKET_SIZE;
+    if (shadowScratch.size() < needed)
+      shadowScratch.resize(needed);
   }
+  const uint32_t flatColor =
+      MODE == RasterMode::Flat ? packColor(tri.flatColor) : 0;
+  int written = 0;
+
+  int packetCount = 0;
+  int packetIdx[PHONG_PACKET_SIZE];
+  unsigned packetMask[PHONG_PACKET_SIZE]; // MSAA: amostras a receber a cor
+  double packetU[PHONG_PACKET_SIZE], packetV[PHONG_PACKET_SIZE],
+      packetW[PHONG_PACKET_SIZE];
+  uint32_t packetOut[PHONG_PACKET_SIZE];
+
+  auto flushPacket = [&]() {
+    if (packetCount == 0)
+      return;
+    RENDER_STAT_TIMER(shadeStart);
+    if (shadowed) {
+      double n[3][PHONG_PACKET_SIZE], p[3][PHONG_PACKET_SIZE];
+      for (int i = 0; i < packetCount; ++i) {
+        double ni[3], pi[3];
+        phongInterpolate(phong, packetU[i], packetV[i], packetW[i], ni, pi);
+        for (int c = 0; c < 3; ++c) {
+          n[c][i] = ni[c];
+          p[c][i] = pi[c];
+        }
+      }
+      shadowVisibility(shading.lightSoA, n[0], n[1], n[2], p[0], p[1], p[2],
+                       packetCount, shadowScratch.data());
+      phong.shadow = shadowScratch.data();
+      shadeKernel(phong, n[0], n[1], n[2], p[0], p[1], p[2], packetCount,
+                  packetOut);
+    } else {
+      phongKernel(phong, packetU, packetV, packetW, packetCount, packetOut);
+    }
+    RENDER_STAT_ELAPSED(shadeSeconds, shadeStart);
+    RENDER_STAT_ADD(shadingPackets, 1);
+    if constexpr (MSAA) {
+      for (int i = 0; i < packetCount; ++i) {
+        uint32_t *out = &fb.sampleColor[static_cast<size_t>(packetIdx[i]) * S];
+        for (unsigned m = packetMask[i]; m; m &= m - 1)
+          out[__builtin_ctz(m)] = packetOut[i];
+      }
+    } else {
+      for (int i = 0; i < packetCount; ++i)
+        fb.color[packetIdx[i]] = packetOut[i];
+    }
+    packetCount = 0;
+  };
+
+  // Pixel com as amostras `mask` cobertas (MSAA); w0..w2 no centro
+  auto shadeSamples = [&](int x, int y, int64_t w0, int64_t w1, int64_t w2,
+                          unsigned mask) {
+    int idx = y * fb.width + x;
+    size_t base = static_cast<size_t>(idx) * S;
+    RENDER_STAT_ADD(pixelsCovered, 1);
+    unsigned passed = 0;
+    for (unsigned m = mask; m; m &= m - 1) {
+      int k = __builtin_ctz(m);
+      double u = static_cast<double>(w0 + off0[k] - e0.bias) * tri.invArea;
+      double v = static_cast<double>(w1 + off1[k] - e1.bias) * tri.invArea;
+      double w = static_cast<double>(w2 + off2[k] - e2.bias) * tri.invArea;
+      DepthValue z = static_cast<DepthValue>(u * v0.screen.z + v * v1.screen.z +
+                                             w * v2.screen.z);
+      if (z > fb.depth[base + k]) {
+        fb.depth[base + k] = z;
+        passed |= 1u << k;
+      }
+    }
+    if (!passed) {
+      RENDER_STAT_ADD(depthFails, 1);
+      return;
+    }
+    ++written;
+
+    if constexpr (MODE == RasterMode::Phong) {
+      // Centro fora do triangulo: atributos na primeira amostra coberta,
+      // sem extrapolar alem da borda
+      if ((w0 | w1 | w2) < 0) {
+        int k = __builtin_ctz(mask);
+        w0 += off0[k];
+        w1 += off1[k];
+        w2 += off2[k];
+      }
+      packetIdx[packetCount] = idx;
+      packetMask[packetCount] = passed;
+      packetU[packetCount] = static_cast<double>(w0 - e0.bias) * tri.invArea;
+      packetV[packetCount] = static_cast<double>(w1 - e1.bias) * tri.invArea;
+      packetW[packetCount] = static_cast<double>(w2 - e2.bias) * tri.invArea;
+      if (++packetCount == PHONG_PACKET_SIZE)
+        flushPacket();
+    } else {
+      for (unsigned m = passed; m; m &= m - 1)
+        fb.sampleColor[base + __builtin_ctz(m)] = flatColor;
+    }
+  };
+
+  // Fragmento coberto: baricentricas e z-test antes do shading
+  auto shadeFragment = [&](int x, int y, int64_t w0, int64_t w1, int64_t w2) {
+    // Remove o bias da regra top-left antes de interpolar
+    double u = static_cast<double>(w0 - e0.bias) * tri.invArea;
+    double v = static_cast<double>(w1 - e1.bias) * tri.invArea;
+    double w = static_cast<double>(w2 - e2.bias) * tri.invArea;
+
+    // Interpolar profundidade (na precisao do z-buffer)
+    DepthValue z = static_cast<DepthValue>(u * v0.screen.z + v * v1.screen.z +
+                                           w * v2.screen.z);
+
+    // Z-buffer: o teste vem antes do shading (mesmo resultado, menos custo)
+    int idx = y * fb.width + x;
+    RENDER_STAT_ADD(pixelsCovered, 1);
+    if (!(z > fb.depth[idx])) {
+      RENDER_STAT_ADD(depthFails, 1);
+      return;
+    }
+    fb.depth[idx] = z;
+    ++written;
+
+    if constexpr (MODE == RasterMode::Deferred) {
+      // Deferred: guarda os atributos ja interpolados para o resolve
+      double n[3], p[3];
+      phongInterpolate(phong, u, v, w, n, p);
+      size_t g = gbuffer->index(x, y);
+      gbuffer->normalX[g] = n[0];
+      gbuffer->normalY[g] = n[1];
+      gbuffer->normalZ[g] = n[2];
+      gbuffer->worldX[g] = p[0];
+      gbuffer->worldY[g] = p[1];
+      gbuffer->worldZ[g] = p[2];
+      gbuffer->material[g] = tri.instance;
+    } else if constexpr (MODE == RasterMode::Phong) {
+      // Phong: cor calculada quando o pacote for processado
+      packetIdx[packetCount] = idx;
+      packetU[packetCount] = u;
+      packetV[packetCount] = v;
+      packetW[packetCount] = w;
+      if (++packetCount == PHONG_PACKET_SIZE)
+        flushPacket();
+    } else if constexpr (MODE == RasterMode::Depth) {
+      // So profundidade: nada a sombrear
+    } else {
+      // Flat: usa cor pré-calculada
+      fb.color[idx] = flatColor;
+    }
+  };
+
+  // Percorre blocos alinhados em 8x8
+  int startBX = minX & ~(BLOCK_SIZE - 1);
+  int startBY = minY & ~(BLOCK_SIZE - 1);
+  for (int by = startBY; by <= maxY; by += BLOCK_SIZE) {
+    int y0 = std::max(by, minY);
+    int y1 = std::min(by + BLOCK_SIZE - 1, maxY);
+    for (int bx = startBX; bx <= maxX; bx += BLOCK_SIZE) {
+      int x0 = std::max(bx, minX);
+      int x1 = std::min(bx + BLOCK_SIZE - 1, maxX);
+
+      // Bloco inteiro fora de alguma aresta: rejeita sem visitar pixels
+      if (edgeMax(e0, x0, y0, x1, y1) + margin0 < 0 ||
+          edgeMax(e1, x0, y0, x1, y1) + margin1 < 0 ||
+          edgeMax(e2, x0, y0, x1, y1) + margin2 < 0)
+        continue;
 
-  // 4. Rasterizar cada face (12 triângulos)
-  for (size_t f = 0; f < 12; ++f) {
-    int i0 = cubeFaces[f][0];
-    int i1 = cubeFaces[f][1];
-    int i2 = cubeFaces[f][2];
-
-    // Normal da face transformada para world space (ORDEM CORRETA)
-    int faceIdx = f / 2; // cada face tem 2 triângulos
-    Vec3 normal = faceNormals[faceIdx];
-    Vec4 normalWorld4 = model * toVec4(normal, 0.0); // w=0 para vetores
-    Vec3 faceNormal =
-        Vec3{normalWorld4.x, normalWorld4.y, normalWorld4.z}.normalized();
-
-    // Back-face culling: se normal aponta para longe da câmera, pula
-    Vec3 viewDir = (camera.eye - verts[i0].world).normalized();
-    if (faceNormal.dot(viewDir) < 0)
-      continue;
+      // Bloco inteiro dentro: dispensa o teste por pixel
+      bool fullyCovered = edgeMin(e0, x0, y0, x1, y1) - margin0 >= 0 &&
+                          edgeMin(e1, x0, y0, x1, y1) - margin1 >= 0 &&
+                          edgeMin(e2, x0, y0, x1, y1) - margin2 >= 0;
+
+      RENDER_STAT_ADD(pixelsTested, (x1 - x0 + 1) * (y1 - y0 + 1));
+      int64_t row0 = evalEdge(e0, x0, y0);
+      int64_t row1 = evalEdge(e1, x0, y0);
+      int64_t row2 = evalEdge(e2, x0, y0);
+      for (int y = y0; y <= y1; ++y) {
+        int64_t w0 = row0, w1 = row1, w2 = row2;
+        for (int x = x0; x <= x1; ++x) {
+          if constexpr (MSAA) {
+            unsigned mask = fullyCovered ? allSamples : 0u;
+            for (int k = 0; k < S && !fullyCovered; ++k)
+              if (((w0 + off0[k]) | (w1 + off1[k]) | (w2 + off2[k])) >= 0)
+                mask |= 1u << k;
+            if (mask)
+              shadeSamples(x, y, w0, w1, w2, mask);
+          } else if (fullyCovered || (w0 | w1 | w2) >= 0) {
+            // Dentro se nenhuma aresta for negativa (bit de sinal)
+            shadeFragment(x, y, w0, w1, w2);
+          }
+          w0 += step0X;
+          w1 += step1X;
+          w2 += step2X;
+        }
+        row0 += step0Y;
+        row1 += step1Y;
+        row2 += step2Y;
+      }
+    }
+  }
+  if constexpr (MODE == RasterMode::Phong)
+    flushPacket();
+  return written;
+}
 
-    // Normais dos vértices (para Phong shading)
-    verts[i0].normal = faceNormal;
-    verts[i1].normal = faceNormal;
-    verts[i2].normal = faceNormal;
+RasterFn rasterKernel(bool usePhong, bool deferred, bool multisample,
+                      bool depthOnly) {
+  static constexpr RasterFn kernels[] = {
+      rasterizeKernel<RasterMode::Flat, false>,
+      rasterizeKernel<RasterMode::Phong, false>,
+      rasterizeKernel<RasterMode::Deferred, false>};
+  static constexpr RasterFn msaaKernels[] = {
+      rasterizeKernel<RasterMode::Flat, true>,
+      rasterizeKernel<RasterMode::Phong, true>};
+  if (depthOnly)
+    return rasterizeKernel<RasterMode::Depth, false>;
+  if (multisample)
+    return msaaKernels[usePhong ? 1 : 0];
+  return kernels[usePhong ? (deferred ? 2 : 1) : 0];
+}
 
-    // Rasterizar triângulo
-    rasterizeTriangle(fb, verts[i0], verts[i1], verts[i2], faceNormal,
-                      cube.material, lights, camera.eye, usePhong);
-  }
+int rasterizeTriangle(Framebuffer &fb, const RasterTriangle &tri,
+                      const PixelRect &rect, const ShadingContext &shading,
+                      bool usePhong, GBuffer *gbuffer) {
+  bool multisample = fb.samples > 1;
+  return rasterKernel(usePhong, gbuffer != nullptr && !multisample,
+                      multisample)(fb, tri, rect, shading,
+                                   multisample ? nullptr : gbuffer);
 }
 
 // ============ RENDERIZAÇÃO DA CENA ============
 
 void renderScene(const Scene &scene, Framebuffer &fb, bool usePhong) {
-  // Renderizar cada cubo da cena
-  for (const auto &cube : scene.cubes) {
-    renderCube(cube, scene.camera, scene.lights, fb, usePhong);
-  }
+  RenderOptions options;
+  options.usePhong = usePhong;
+  renderScene(scene, fb, options);
+}
+
+void renderScene(const Scene &scene, Framebuffer &fb,
+                 const RenderOptions &options) {
+  // Um Renderer por thread chamadora: reaproveita buffers entre frames e
+  // permite renders concorrentes de threads diferentes
+  thread_local Renderer renderer;
+  renderer.render(scene, fb, options);
 }
@@ -1,18 +1,219 @@
 #pragma once
 #include "../core/Scene.h"
+#include "ShadingKernels.h"
+#include <algorithm>
 #include <cstdint>
 #include <vector>
 
+// Tipo do z-buffer, escolhido para o pipeline inteiro na compilacao.
+// double por padrao; com RENDER_DEPTH_FLOAT (opcao CMake RENDER_FLOAT_DEPTH)
+// usa float e o z-buffer ocupa metade da memoria (4K: 33 MB em vez de 66 MB).
+// A profundidade gravada e "reversa" (ver depthFromClip em Transform.h).
+#ifdef RENDER_DEPTH_FLOAT
+using DepthValue = float;
+#else
+using DepthValue = double;
+#endif
+
+// Valor de limpeza do z-buffer (mais longe que qualquer geometria)
+constexpr DepthValue DEPTH_CLEAR = DepthValue(-1e9);
+
 // Framebuffer com z-buffer
+// `color` aponta para o buffer proprio ou, apos attachColor(), para memoria
+// do chamador: o render escreve direto na saida, sem copia final.
+//
+// MSAA: com `samples` > 1, `depth` e `sampleColor` tem uma entrada por
+// amostra (indice pixel*samples + amostra) e `color` so recebe a media das
+// amostras no resolve().
 struct Framebuffer {
   int width, height;
-  std::vector<uint32_t> color;
-  std::vector<double> depth;
+  uint32_t *color;
+  std::vector<DepthValue> depth;
+  int samples{1};
+  std::vector<uint32_t> sampleColor; // vazio sem MSAA
+
+  // Hi-Z: profundidade mais distante (menor valor) de cada bloco 8x8 do
+  // z-buffer, usada pelo occlusion culling. Pode ficar desatualizada para
+  // "mais longe" (conservador), nunca para "mais perto": o z-buffer so deve
+  // ser alterado por clear(), clearRect(), putPixel() ou pelo rasterizador.
+  static constexpr int HIZ_BLOCK = 8;
+  int hiZWidth, hiZHeight; // em blocos
+  std::vector<DepthValue> hiZ;
 
   Framebuffer(int w, int h);
+  Framebuffer(Framebuffer &&) = default;
+  Framebuffer &operator=(Framebuffer &&) = default;
+  Framebuffer(const Framebuffer &) = delete;
+  Framebuffer &operator=(const Framebuffer &) = delete;
+
+  // Muda o tamanho reaproveitando a memoria ja alocada
+  void resize(int w, int h);
+  // Passa a escrever em `pixels` (width*height ARGB); nullptr volta ao
+  // buffer proprio
+  void attachColor(uint32_t *pixels);
+
+  // Muda o numero de amostras por pixel (1, 2, 4 ou 8). As amostras novas
+  // repetem a cor e a profundidade atuais de cada pixel.
+  void setSamples(int count);
+  // Media das amostras dos pixels [x0,x1) x [y0,y1) em `color`
+  void resolve(int x0, int y0, int x1, int y1);
+
   void clear(uint32_t c);
+  // Limpa so os pixels [x0,x1) x [y0,y1) (cor, z-buffer e Hi-Z)
+  void clearRect(int x0, int y0, int x1, int y1, uint32_t c);
   void putPixel(int x, int y, double z, const Vec3 &col);
+
+  // Recalcula o Hi-Z dos blocos que tocam os pixels [x0,x1] x [y0,y1]
+  void updateHiZ(int x0, int y0, int x1, int y1);
+
+private:
+  void resetHiZ();
+
+  std::vector<uint32_t> ownedColor;
+};
+
+// Converte RGB [0,1] para ARGB uint32
+inline uint32_t packColor(const Vec3 &col) {
+  uint8_t r = static_cast<uint8_t>(std::clamp(col.x, 0.0, 1.0) * 255.0);
+  uint8_t g = static_cast<uint8_t>(std::clamp(col.y, 0.0, 1.0) * 255.0);
+  uint8_t b = static_cast<uint8_t>(std::clamp(col.z, 0.0, 1.0) * 255.0);
+  return 0xff000000 | (r << 16) | (g << 8) | b;
+}
+
+// ============ ESTRUTURAS DO PIPELINE ============
+
+// Vertice ja transformado para a tela
+struct Vertex {
+  Vec3 screen; // coordenadas de tela (x, y, z)
+  Vec3 world;  // posição em espaço mundo
+  Vec3 normal; // normal do vértice
+};
+
+// Bits de sub-pixel das coordenadas de tela em ponto fixo (1/256 pixel)
+constexpr int SUBPIXEL_BITS = 8;
+constexpr int64_t SUBPIXEL_ONE = int64_t(1) << SUBPIXEL_BITS;
+
+// Equacao de aresta E(p) = A*x + B*y + C em ponto fixo, orientada para ser
+// positiva no interior. `bias` (0 ou -1) aplica a regra top-left: pixels
+// exatamente sobre uma aresta que nao e top/left ficam de fora.
+struct EdgeEquation {
+  int64_t A, B, C;
+  int64_t bias;
+};
+
+// Triangulo pronto para rasterizar (saida do estagio de geometria)
+struct RasterTriangle {
+  Vertex v[3];
+  Vec3 faceNormal;
+  Vec3 flatColor; // cor do flat shading (calculada uma vez por triangulo)
+  const Material *material;
+  int instance;               // instancia (cubo) de origem no lote
+  int minX, minY, maxX, maxY; // bounding box ja recortado ao framebuffer
+  EdgeEquation edge[3];       // edge[i] e oposta ao vertice i
+  double invArea;             // 1 / (2 * area) em unidades de ponto fixo
+};
+
+// Retangulo de pixels [x0,x1) x [y0,y1) (um tile ou a tela inteira)
+struct PixelRect {
+  int x0, y0, x1, y1;
+};
+
+// G-buffer do modo deferred, do tamanho de um tile: atributos do fragmento
+// visivel em cada pixel (a profundidade fica no z-buffer do Framebuffer).
+// Material = instancia de origem no lote; -1 = pixel sem geometria.
+// Arrays SoA: uma linha de pixels vai direto para o kernel de shading.
+struct GBuffer {
+  PixelRect rect{0, 0, 0, 0};
+  int stride{0};
+  std::vector<double> normalX, normalY, normalZ; // normalizada
+  std::vector<double> worldX, worldY, worldZ;
+  std::vector<int32_t> material;
+
+  // Passa a cobrir `r`, com todos os pixels vazios
+  void reset(const PixelRect &r);
+
+  size_t index(int x, int y) const {
+    return static_cast<size_t>(y - rect.y0) * stride + (x - rect.x0);
+  }
+};
+
+// Setup do triangulo (feito uma vez, antes do binning): equacoes de aresta
+// e bounding box. Retorna false se o triangulo nao gera pixels (degenerado,
+// fora da tela ou fora da guard band de ponto fixo). Com `multisample` o
+// bounding box inclui os pixels que o triangulo toca fora do centro.
+bool setupTriangle(RasterTriangle &tri, int fbWidth, int fbHeight,
+                   bool multisample = false);
+
+// Amostras de MSAA suportadas mais proximas de `requested` (1, 2, 4 ou 8)
+int msaaSampleCount(int requested);
+
+// Rasteriza o triangulo apenas dentro de `rect`. No modo Phong os
+// fragmentos que passam no z-test sao sombreados em pacotes pelo kernel
+// vetorial da CPU (ShadingKernels.h); com `gbuffer` (deferred) eles so
+// gravam normal, posicao e material, e o shading fica para o resolve.
+// Retorna quantos fragmentos passaram no z-test.
+int rasterizeTriangle(Framebuffer &fb, const RasterTriangle &tri,
+                       const PixelRect &rect, const ShadingContext &shading,
+                       bool usePhong, GBuffer *gbuffer = nullptr);
+
+// Modos do rasterizador; cada um e um kernel separado (template), sem
+// testes de modo por pixel. Depth so grava o z-buffer (shadow maps).
+enum class RasterMode { Flat, Phong, Deferred, Depth };
+
+// Mesmo contrato de rasterizeTriangle, com o modo ja resolvido
+using RasterFn = int (*)(Framebuffer &fb, const RasterTriangle &tri,
+                         const PixelRect &rect, const ShadingContext &shading,
+                         GBuffer *gbuffer);
+
+// Kernel do modo (deferred so com Phong); escolher uma vez por tile/frame.
+// `multisample`: kernel MSAA (cobertura e profundidade por amostra, shading
+// uma vez por pixel e triangulo; sem deferred) para fb.samples > 1.
+// `depthOnly`: kernel Depth (sem MSAA; os outros argumentos sao ignorados).
+RasterFn rasterKernel(bool usePhong, bool deferred, bool multisample = false,
+                      bool depthOnly = false);
+
+// ============ OPCOES DE RENDERIZACAO ============
+
+struct RenderOptions {
+  bool usePhong{false};
+  // Back end em tiles: triangulos sao distribuidos em tiles de tela e cada
+  // tile e rasterizado por uma thread. Falso = caminho serial (tela inteira).
+  bool tiled{true};
+  int tileSize{64};
+  // Threads usadas pelos tiles (0 = todas do pool global)
+  int numThreads{0};
+  // Descarta cubos fora do frustum (BVH) antes da etapa de geometria
+  bool frustumCulling{true};
+  // Occlusion culling: cubos ordenados da frente para tras e testados contra
+  // o Hi-Z do tile antes de rasterizar. Cubos com a mesma profundidade podem
+  // trocar de ordem em relacao ao modo normal (empates no z-buffer).
+  bool occlusionCulling{false};
+  // Deferred (so Phong): cada tile rasteriza para um G-buffer e depois
+  // sombreia cada pixel visivel uma unica vez, independente do overdraw.
+  // Mesma imagem do modo direto.
+  bool deferred{false};
+  // Listas de luzes por tile (so afeta luzes com alcance, Light::range > 0)
+  bool lightCulling{true};
+  // MSAA com 2, 4 ou 8 amostras por pixel (1 = desligado): bordas
+  // suavizadas com um shading por pixel e triangulo. Com MSAA o modo
+  // deferred cai para o direto.
+  int msaaSamples{1};
+  // Sombras: cube shadow map por luz com Light::castShadows, em cache entre
+  // frames (ver Shadows.h). shadowMapSize texels por lado de cada face;
+  // shadowPcf e o raio do filtro (0 = borda dura, 1 = 3x3, 2 = 5x5).
+  bool shadows{false};
+  int shadowMapSize{512};
+  int shadowPcf{1};
+  // Cache temporal (ver TemporalCache.h): com a camera andando numa cena
+  // parada, o difuso (com a sombra) de cada pixel vem do frame anterior
+  // reprojetado e so o especular e refeito. So no deferred sem MSAA, ate 4
+  // luzes; aproxima o difuso pelo pixel vizinho do frame anterior.
+  bool temporal{false};
+  // Passada so de profundidade (faces dos shadow maps): sem cor nem luzes
+  bool depthOnly{false};
 };
 
-// Fun├º├Áes principais
+// Funções principais
 void renderScene(const Scene &scene, Framebuffer &fb, bool usePhong);
+void renderScene(const Scene &scene, Framebuffer &fb,
+                 const RenderOptions &options);
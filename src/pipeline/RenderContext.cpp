@@ -0,0 +1,201 @@
+#include "RenderContext.h"
+#include "../core/BVH.h"
+#include "Transform.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+RenderContext::RenderContext(ThreadPool &pool)
+    : renderer(pool), upscaler(pool), pool(pool) {}
+
+// ============ COMPARACAO COM O FRAME ANTERIOR ============
+
+static bool sameCamera(const Camera &a, const Camera &b) {
+  return sameVec3(a.eye, b.eye) && sameVec3(a.center, b.center) &&
+         sameVec3(a.up, b.up) && a.nearPlane == b.nearPlane &&
+         a.farPlane == b.farPlane && a.fovY == b.fovY && a.aspect == b.aspect;
+}
+
+static bool sameOptions(const RenderOptions &a, const RenderOptions &b) {
+  return a.usePhong == b.usePhong && a.tiled == b.tiled &&
+         a.tileSize == b.tileSize && a.frustumCulling == b.frustumCulling &&
+         a.occlusionCulling == b.occlusionCulling &&
+         a.deferred == b.deferred && a.lightCulling == b.lightCulling &&
+         a.msaaSamples == b.msaaSamples && a.shadows == b.shadows &&
+         a.shadowMapSize == b.shadowMapSize && a.shadowPcf == b.shadowPcf &&
+         a.temporal == b.temporal;
+}
+
+// Retangulo de tela (conservador) de uma caixa em mundo; a tela inteira
+// se a caixa cruza o plano near
+void RenderContext::addBoxRect(const AABB &box,
+                               std::vector<PixelRect> &rects) const {
+  if (box.min.x > box.max.x) // vazia (instancia sem malha)
+    return;
+  double minSX = 1e300, minSY = 1e300, maxSX = -1e300, maxSY = -1e300;
+  for (int c = 0; c < 8; ++c) {
+    Vec3 corner{c & 1 ? box.max.x : box.min.x, c & 2 ? box.max.y : box.min.y,
+                c & 4 ? box.max.z : box.min.z};
+    Vec4 clip = lastViewProj * toVec4(corner);
+    if (-clip.w < scene.camera.nearPlane) {
+      rects.push_back(PixelRect{0, 0, fb.width, fb.height});
+      return;
+    }
+    Vec3 ndc = fromVec4(clip);
+    double sx = (ndc.x + 1.0) * 0.5 * fb.width;
+    double sy = (1.0 - ndc.y) * 0.5 * fb.height;
+    minSX = std::min(minSX, sx);
+    maxSX = std::max(maxSX, sx);
+    minSY = std::min(minSY, sy);
+    maxSY = std::max(maxSY, sy);
+  }
+  // 1 pixel de folga para arredondamentos
+  PixelRect r{(int)std::max(std::floor(minSX) - 1, 0.0),
+              (int)std::max(std::floor(minSY) - 1, 0.0),
+              (int)std::min(std::floor(maxSX) + 2, (double)fb.width),
+              (int)std::min(std::floor(maxSY) + 2, (double)fb.height)};
+  if (r.x0 < r.x1 && r.y0 < r.y1)
+    rects.push_back(r);
+}
+
+bool RenderContext::diffCubes() {
+  changedCubes.clear();
+  const auto &cubes = scene.cubes, &old = lastScene.cubes;
+  if (cubes.size() != old.size())
+    return false;
+  for (size_t i = 0; i < cubes.size(); ++i)
+    if (!sameCube(cubes[i], old[i]))
+      changedCubes.push_back(static_cast<int>(i));
+  return true;
+}
+
+bool RenderContext::collectDirtyRects(const std::vector<int> *changed,
+                                      std::vector<PixelRect> &rects) const {
+  rects.clear();
+  if (!sameCamera(scene.camera, lastScene.camera) ||
+      !sameOptions(options, lastOptions) || clearColor != lastClearColor ||
+      scene.lights.size() != lastScene.lights.size())
+    return false;
+  for (size_t l = 0; l < scene.lights.size(); ++l)
+    if (!sameLight(scene.lights[l], lastScene.lights[l]))
+      return false;
+
+  // Cubo alterado: area antiga e nova. Cubos a mais ou a menos: so a sua.
+  const auto &cubes = scene.cubes, &old = lastScene.cubes;
+  size_t common = std::min(cubes.size(), old.size());
+  if (changed) {
+    for (int i : *changed) {
+      addBoxRect(CubeBVH::cubeBounds(old[i]), rects);
+      addBoxRect(CubeBVH::cubeBounds(cubes[i]), rects);
+    }
+  } else {
+    for (size_t i = 0; i < common; ++i)
+      if (!sameCube(cubes[i], old[i])) {
+        addBoxRect(CubeBVH::cubeBounds(old[i]), rects);
+        addBoxRect(CubeBVH::cubeBounds(cubes[i]), rects);
+      }
+  }
+  for (size_t i = common; i < old.size(); ++i)
+    addBoxRect(CubeBVH::cubeBounds(old[i]), rects);
+  for (size_t i = common; i < cubes.size(); ++i)
+    addBoxRect(CubeBVH::cubeBounds(cubes[i]), rects);
+
+  // Malhas: mesma regra, com a caixa em mundo da instancia
+  const auto &meshes = scene.meshes, &oldMeshes = lastScene.meshes;
+  common = std::min(meshes.size(), oldMeshes.size());
+  for (size_t i = 0; i < common; ++i)
+    if (!sameMesh(meshes[i], oldMeshes[i])) {
+      addBoxRect(oldMeshes[i].worldBounds(), rects);
+      addBoxRect(meshes[i].worldBounds(), rects);
+    }
+  for (size_t i = common; i < oldMeshes.size(); ++i)
+    addBoxRect(oldMeshes[i].worldBounds(), rects);
+  for (size_t i = common; i < meshes.size(); ++i)
+    addBoxRect(meshes[i].worldBounds(), rects);
+  // Com sombras um objeto que mudou pode mudar a sombra em qualquer lugar
+  if (options.shadows && !rects.empty())
+    return false;
+  return true;
+}
+
+void RenderContext::snapshot(uint32_t *out) {
+  haveFrame = true;
+  lastOut = out;
+  lastScene = scene;
+  lastOptions = options;
+  lastClearColor = clearColor;
+  lastViewProj = scene.camera.viewMatrix() * scene.camera.projectionMatrix();
+}
+
+// ============ RENDER ============
+
+void RenderContext::render(int width, int height, uint32_t *out) {
+  const auto start = std::chrono::steady_clock::now();
+  graph.update();
+  scene.camera.aspect = (double)width / height;
+
+  int w, h;
+  resolution.renderSize(width, height, w, h);
+  lastScale = w == width && h == height ? 1.0 : resolution.scale();
+  if (lastScale < 1.0) {
+    // Resolucao reduzida: frame completo no buffer proprio, ampliado na
+    // saida (o aspecto da camera continua o da saida)
+    fb.attachColor(nullptr);
+    fb.resize(w, h);
+    fb.clear(clearColor);
+    renderer.render(scene, fb, options);
+    upscaler.upscale(fb.color, w, h, out, width, height);
+    haveFrame = false;
+  } else {
+    // Cubos que mudaram desde o frame anterior: so eles sao reajustados
+    // na BVH do Renderer
+    const std::vector<int> *changed =
+        incremental && haveFrame && diffCubes() ? &changedCubes : nullptr;
+    // Incremental: mesmo buffer, mesmo tamanho e so cubos/malhas diferentes
+    bool partial = incremental && haveFrame && out == lastOut &&
+                   width == fb.width && height == fb.height &&
+                   collectDirtyRects(changed, region.rects);
+    if (partial) {
+      region.clearColor = clearColor;
+      renderer.render(scene, fb, options, &region, changed);
+    } else {
+      // z-buffer reaproveitado; a cor vai direto para a memoria do chamador
+      fb.attachColor(out);
+      fb.resize(width, height);
+      fb.clear(clearColor);
+      renderer.render(scene, fb, options, nullptr, changed);
+    }
+    if (incremental)
+      snapshot(out);
+    else
+      haveFrame = false;
+  }
+
+  if (resolution.enabled())
+    resolution.frameDone(std::chrono::duration<double, std::milli>(
+                             std::chrono::steady_clock::now() - start)
+                             .count());
+}
+
+void RenderContext::renderViews(const std::vector<Camera> &cameras, int width,
+                                int height, uint32_t *const *outs) {
+  graph.update();
+  if (!multiView)
+    multiView = std::make_unique<MultiViewRenderer>(pool);
+  const size_t views = cameras.size();
+  while (viewFbs.size() < views)
+    viewFbs.emplace_back(0, 0);
+
+  std::vector<Framebuffer *> targets(views);
+  viewCameras = cameras;
+  for (size_t v = 0; v < views; ++v) {
+    viewCameras[v].aspect = (double)width / height;
+    Framebuffer &target = viewFbs[v];
+    target.attachColor(outs[v]);
+    target.resize(width, height);
+    target.clear(clearColor);
+    targets[v] = &target;
+  }
+  multiView->render(scene, viewCameras, targets, options);
+  haveFrame = false;
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include "../core/SceneGraph.h"
+#include "DynamicResolution.h"
+#include "MultiViewRenderer.h"
+#include "Rasterizer.h"
+#include "Renderer.h"
+#include <cstdint>
+#include <memory>
+
+// Contexto de renderizacao retido (modo "retained").
+// Cena, z-buffer e buffers de trabalho do Renderer vivem entre frames: o
+// chamador atualiza so o que mudou (camera, um cubo, uma luz) e renderiza
+// direto no buffer de saida, sem reconstruir a cena nem copiar pixels.
+//
+// Modo incremental: o contexto compara a cena com a do frame anterior. Se
+// so cubos ou instancias de malha mudaram, redesenha apenas os tiles que a
+// posicao antiga ou nova deles cobre e reaproveita o resto de cor/profundidade (o buffer de
+// saida precisa ser o mesmo e nao pode ser alterado pelo chamador entre
+// frames). Camera, luzes, opcoes ou tamanho diferentes: render completo;
+// com sombras, tambem qualquer cubo ou malha alterado.
+//
+// Resolucao dinamica: com um orcamento em `resolution`, render() mede o
+// proprio custo e renderiza o frame seguinte numa resolucao interna menor
+// quando preciso, ampliada com filtro bilinear para o buffer de saida. Um
+// frame reduzido e sempre completo (nao participa do modo incremental).
+//
+// Grafo de cena: `graph` organiza cubos/malhas de `scene` em hierarquia;
+// render() e renderViews() chamam graph.update() antes de desenhar, entao o
+// modo incremental ve so os objetos que o grafo moveu.
+class RenderContext {
+public:
+  Scene scene;
+  SceneGraph graph{scene};
+  RenderOptions options;
+  uint32_t clearColor{0xff1a1a1a};
+  bool incremental{false};
+  DynamicResolution resolution;
+
+  explicit RenderContext(ThreadPool &pool = ThreadPool::global());
+
+  // Renderiza em `out` (width*height pixels ARGB do chamador). O aspecto da
+  // camera segue width/height.
+  void render(int width, int height, uint32_t *out);
+
+  // A mesma cena vista por varias cameras (ver MultiViewRenderer), cada uma
+  // em outs[i] (width*height pixels). O aspecto de cada camera segue
+  // width/height; scene.camera nao e usada. Nao participa do modo
+  // incremental (o proximo render() e completo).
+  void renderViews(const std::vector<Camera> &cameras, int width, int height,
+                   uint32_t *const *outs);
+
+  // Contadores do occlusion culling no ultimo render
+  const OcclusionStats &occlusionStats() const {
+    return renderer.occlusionStats();
+  }
+  // Estatisticas do ultimo render (detalhes so com RENDER_ENABLE_STATS)
+  const RenderStats &renderStats() const { return renderer.renderStats(); }
+
+  // Pixels redesenhados no ultimo render (todos num render completo)
+  long long lastRedrawnPixels() const { return renderer.redrawnPixels(); }
+  // Escala por eixo da resolucao interna do ultimo render (1 = cheia)
+  double lastRenderScale() const { return lastScale; }
+
+private:
+  // Cubos diferentes dos do ultimo frame em changedCubes; falso se o numero
+  // de cubos mudou
+  bool diffCubes();
+  // Retangulos de tela afetados pelas mudancas desde o ultimo frame; falso
+  // se o frame precisa ser refeito inteiro. `changed`: resultado de
+  // diffCubes (nullptr se o numero de cubos mudou).
+  bool collectDirtyRects(const std::vector<int> *changed,
+                         std::vector<PixelRect> &rects) const;
+  void addBoxRect(const AABB &box, std::vector<PixelRect> &rects) const;
+  void snapshot(uint32_t *out);
+
+  Renderer renderer;
+  // Cor no buffer do chamador; na resolucao reduzida, no buffer proprio
+  Framebuffer fb{0, 0};
+  BilinearUpscaler upscaler;
+  double lastScale{1.0};
+
+  // Multi-view: criado no primeiro renderViews
+  std::unique_ptr<MultiViewRenderer> multiView;
+  std::vector<Framebuffer> viewFbs;
+  std::vector<Camera> viewCameras;
+  ThreadPool &pool;
+
+  // Estado do frame que esta no buffer (modo incremental)
+  bool haveFrame{false};
+  uint32_t *lastOut{nullptr};
+  Scene lastScene;
+  RenderOptions lastOptions;
+  uint32_t lastClearColor{0};
+  Mat4 lastViewProj;
+  Renderer::DirtyRegion region;
+  std::vector<int> changedCubes; // tambem guiam o refit da BVH
+};
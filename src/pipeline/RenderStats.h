@@ -0,0 +1,103 @@
+#pragma once
+#include <chrono>
+
+// Estatisticas do pipeline por frame.
+// OcclusionStats e FrameCounters sao baratos e sempre coletados. Os
+// contadores por estagio (PipelineCounters) e os tempos so existem com
+// RENDER_ENABLE_STATS (opcao CMake RENDER_STATS): sem ela as macros
+// RENDER_STAT_* nao geram codigo e esses campos ficam zerados.
+
+#ifdef RENDER_ENABLE_STATS
+constexpr bool RENDER_STATS_ENABLED = true;
+#else
+constexpr bool RENDER_STATS_ENABLED = false;
+#endif
+
+// Contadores do occlusion culling no ultimo frame (um teste = um cubo
+// contra o Hi-Z de um tile que ele toca)
+struct OcclusionStats {
+  long long cubeTests{0};
+  long long cubesRejected{0};
+  long long trianglesSkipped{0}; // triangulos nao rasterizados
+};
+
+// Trabalho feito no ultimo frame. Contadores baratos (um incremento por
+// triangulo ou tile), sempre ligados; usados pelo render_bench.
+struct FrameCounters {
+  long long cubesSubmitted{0};      // cubos da cena
+  long long cubesDrawn{0};          // depois do frustum culling
+  long long trianglesRasterized{0}; // depois de back-face e setup
+  long long depthPasses{0};         // fragmentos que passaram no z-test
+  long long fragmentsShaded{0};     // fragmentos sombreados (Phong ou flat)
+  long long arenaBytes{0};          // usados da FrameArena do frame
+  long long arenaHeapAllocations{0}; // blocos que a arena pediu ao heap
+  long long shadowFacesRendered{0}; // faces de shadow map refeitas
+  long long temporalReused{0}; // pixels com o difuso do frame anterior
+};
+
+// Contadores detalhados de um pedaco de trabalho (bloco de instancias ou
+// tile), somados no fim do frame
+struct PipelineCounters {
+  long long trianglesBackfacing{0};  // descartados pelo back-face culling
+  long long trianglesNearClipped{0}; // recortados no plano near
+  long long trianglesRejected{0};    // degenerados/fora da tela no setup
+  long long pixelsTested{0};         // visitados pelo teste de aresta
+  long long pixelsCovered{0};        // dentro do triangulo
+  long long depthFails{0};           // cobertos que falharam no z-test
+  long long shadingPackets{0};       // chamadas dos kernels Phong
+  double shadeSeconds{0}; // tempo no shading (soma de todas as threads)
+
+  void add(const PipelineCounters &o) {
+    trianglesBackfacing += o.trianglesBackfacing;
+    trianglesNearClipped += o.trianglesNearClipped;
+    trianglesRejected += o.trianglesRejected;
+    pixelsTested += o.pixelsTested;
+    pixelsCovered += o.pixelsCovered;
+    depthFails += o.depthFails;
+    shadingPackets += o.shadingPackets;
+    shadeSeconds += o.shadeSeconds;
+  }
+};
+
+// Tudo o que o Renderer sabe sobre o ultimo frame
+struct RenderStats {
+  FrameCounters counters;
+  OcclusionStats occlusion;
+
+  // So com RENDER_ENABLE_STATS
+  PipelineCounters pipeline;
+  long long pixelsWithGeometry{0}; // pixels com z-buffer escrito
+  double overdraw{0};              // depthPasses / pixelsWithGeometry
+  // Tempos de parede (ms) de cada etapa; shadeMs e a soma entre threads
+  // do tempo gasto sombreando (parte de rasterMs, ou de transformMs no flat)
+  double cullMs{0}, transformMs{0}, binMs{0}, rasterMs{0}, shadeMs{0};
+  double shadowMs{0}; // atualizacao dos shadow maps (antes da geometria)
+  double totalMs{0};
+};
+
+// ============ COLETA ============
+// Cada thread aponta `statsSink` para os contadores do trabalho atual; o
+// codigo instrumentado soma neles sem saber de qual tile/bloco se trata.
+
+#ifdef RENDER_ENABLE_STATS
+inline thread_local PipelineCounters *statsSink = nullptr;
+
+using StatsClock = std::chrono::steady_clock;
+inline double statsSeconds(StatsClock::time_point start) {
+  return std::chrono::duration<double>(StatsClock::now() - start).count();
+}
+
+#define RENDER_STAT_SINK(counters) (statsSink = (counters))
+#define RENDER_STAT_ADD(field, n)                                              \
+  do {                                                                         \
+    if (statsSink)                                                             \
+      statsSink->field += (n);                                                 \
+  } while (0)
+#define RENDER_STAT_TIMER(name) const StatsClock::time_point name = StatsClock::now()
+#define RENDER_STAT_ELAPSED(field, start) RENDER_STAT_ADD(field, statsSeconds(start))
+#else
+#define RENDER_STAT_SINK(counters) ((void)0)
+#define RENDER_STAT_ADD(field, n) ((void)0)
+#define RENDER_STAT_TIMER(name) ((void)0)
+#define RENDER_STAT_ELAPSED(field, start) ((void)0)
+#endif
@@ -0,0 +1,1202 @@
+#include "Renderer.h"
+#include "Shading.h"
+#include "Shadows.h"
+#include "TemporalCache.h"
+#include "Transform.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+// ============ DADOS DO CUBO ============
+
+// Faces do cubo (12 triângulos = 6 faces × 2 triângulos)
+static const std::array<std::array<int, 3>, 12> cubeFaces = {{
+    {4, 5, 6},
+    {4, 6, 7}, // Front (z = +0.5)
+    {1, 0, 3},
+    {1, 3, 2}, // Back (z = -0.5)
+    {5, 1, 2},
+    {5, 2, 6}, // Right (x = +0.5)
+    {0, 4, 7},
+    {0, 7, 3}, // Left (x = -0.5)
+    {7, 6, 2},
+    {7, 2, 3}, // Top (y = +0.5)
+    {0, 1, 5},
+    {0, 5, 4} // Bottom (y = -0.5)
+}};
+
+// Normais de cada face (sem transformação)
+static const std::array<Vec3, 6> faceNormals = {{
+    {0, 0, 1},  // front
+    {0, 0, -1}, // back
+    {1, 0, 0},  // right
+    {-1, 0, 0}, // left
+    {0, 1, 0},  // top
+    {0, -1, 0}  // bottom
+}};
+
+Renderer::Renderer(ThreadPool &pool) : pool(pool) {}
+
+Renderer::~Renderer() = default;
+
+// ============ ESTAGIO DE GEOMETRIA ============
+
+// `cullRect` (re-render parcial): so entram cubos que podem tocar esses
+// pixels.
+void Renderer::buildTriangles(const Scene &scene, const Framebuffer &fb,
+                              const RenderOptions &options,
+                              const PixelRect *cullRect) {
+  const Camera &camera = *frameCamera;
+
+  // Matrizes da camera uma vez por frame (antes: por cubo)
+  Mat4 proj = camera.projectionMatrix();
+  viewProj = camera.viewMatrix() * proj;
+
+  // Culling hierarquico: so os cubos que tocam o frustum entram no lote
+  RENDER_STAT_TIMER(cullStart);
+  const std::vector<int> *order = nullptr;
+  Frustum frustum;
+  if (options.frustumCulling) {
+    frustum =
+        Frustum::fromViewProj(viewProj, camera.nearPlane, camera.farPlane);
+    if (cullRect) {
+      // Retangulo em NDC, com 1 pixel de folga (y da tela e invertido)
+      double sx = 2.0 / fb.width, sy = 2.0 / fb.height;
+      frustum = Frustum::fromViewProj(
+          viewProj, camera.nearPlane, camera.farPlane,
+          (cullRect->x0 - 1) * sx - 1.0, 1.0 - (cullRect->y1 + 1) * sy,
+          (cullRect->x1 + 1) * sx - 1.0, 1.0 - (cullRect->y0 - 1) * sy);
+    }
+    if (world) {
+      world->bvh.cull(frustum, visibleCubes, cullScratch);
+    } else {
+      // Reajusta a BVH do frame anterior (reconstroi se o numero de cubos
+      // mudou)
+      bvh.update(scene.cubes, cubeChanges);
+      bvhCurrent = true;
+      bvh.cull(frustum, visibleCubes);
+    }
+    order = &visibleCubes;
+  }
+  if (options.occlusionCulling) {
+    sortFrontToBack(scene, order);
+    order = &visibleCubes;
+  }
+  if (world)
+    instances.assignShared(world->cubes, order);
+  else
+    instances.assign(scene.cubes, order);
+  cullMeshes(scene, options.frustumCulling ? &frustum : nullptr, proj, fb);
+#ifdef RENDER_ENABLE_STATS
+  stats.cullMs = statsSeconds(cullStart) * 1000.0;
+#endif
+  RENDER_STAT_TIMER(transformStart);
+  instanceMaterials.reserve(scene.cubes.size() + scene.meshes.size());
+  instanceMaterials.resize(instances.count + visibleMeshes.size());
+  for (const VisibleMesh &vm : visibleMeshes)
+    instanceMaterials[vm.instance] = &scene.meshes[vm.mesh].material;
+
+  numCubeChunks = (instances.count + INSTANCE_CHUNK - 1) / INSTANCE_CHUNK;
+  numChunks = numCubeChunks + (int)meshChunks.size();
+  if ((int)chunkTriangles.size() < numChunks)
+    chunkTriangles.resize(numChunks);
+  if (RENDER_STATS_ENABLED)
+    chunkStats.assign(numChunks, PipelineCounters{});
+
+  // Vertices das malhas antes de qualquer triangulo que os use
+  pool.parallelFor((int)meshVertexJobs.size(), [&](int j) {
+    transformMesh(scene, meshVertexJobs[j], proj, fb);
+  });
+
+  // Cada bloco de cubos transforma suas instancias e monta seus
+  // triangulos; cada bloco de malha monta os seus a partir do cache.
+  // Cor flat por triangulo so no modo flat (nao nas passadas de
+  // profundidade)
+  const bool noFlatColor = options.usePhong || options.depthOnly;
+  pool.parallelFor(numChunks, [&](int c) {
+    RENDER_STAT_SINK(&chunkStats[c]);
+    auto &out = chunkTriangles[c];
+    out.clear();
+    if (c >= numCubeChunks) {
+      assembleMesh(scene, meshChunks[c - numCubeChunks], proj, fb,
+                   noFlatColor, out);
+      RENDER_STAT_SINK(nullptr);
+      return;
+    }
+    int begin = c * INSTANCE_CHUNK;
+    int end = std::min(instances.count, begin + INSTANCE_CHUNK);
+    instances.transform(viewProj, begin, end);
+
+    for (int i = begin; i < end; ++i)
+      instanceMaterials[i] = &scene.cubes[instances.cubeIndex[i]].material;
+    for (int i = begin; i < end; ++i)
+      assembleCube(scene, i, proj, fb, noFlatColor, out, instanceBounds[i]);
+    RENDER_STAT_SINK(nullptr);
+  });
+#ifdef RENDER_ENABLE_STATS
+  stats.transformMs = statsSeconds(transformStart) * 1000.0;
+#endif
+}
+
+// Ordem aproximada da frente para tras (profundidade do centro ao longo da
+// direcao de visao): os oclusores entram no Hi-Z antes do que escondem.
+// Desempate pelo indice deixa a ordem deterministica.
+void Renderer::sortFrontToBack(const Scene &scene,
+                               const std::vector<int> *indices) {
+  const Camera &camera = *frameCamera;
+  Vec3 forward = camera.center - camera.eye;
+  size_t n = indices ? indices->size() : scene.cubes.size();
+
+  depthOrder.resize(n);
+  for (size_t k = 0; k < n; ++k) {
+    int c = indices ? (*indices)[k] : static_cast<int>(k);
+    depthOrder[k] = {forward.dot(scene.cubes[c].position - camera.eye), c};
+  }
+  std::sort(depthOrder.begin(), depthOrder.end());
+
+  visibleCubes.resize(n);
+  for (size_t k = 0; k < n; ++k)
+    visibleCubes[k] = depthOrder[k].second;
+}
+
+// ============ RECORTE NO PLANO NEAR ============
+// Vertice em clip space durante o recorte (z de clip nao e usado: a
+// profundidade sai de w em depthFromClip)
+struct ClipVertex {
+  Vec4 clip;
+  Vec3 world;
+  Vec3 normal; // so usada pelas malhas (cubos usam a normal da face)
+};
+
+// Distancia assinada ao plano near: >= 0 na frente (w < 0 na frente da
+// camera, entao o plano e -w = near)
+static inline double nearDistance(const ClipVertex &v, double nearPlane) {
+  return -v.clip.w - nearPlane;
+}
+
+// Sutherland-Hodgman contra um unico plano, feito em coordenadas
+// homogeneas (antes da divisao por w, que explode perto de w = 0).
+// Um triangulo gera 0, 3 ou 4 vertices.
+static int clipNear(const ClipVertex in[3], double nearPlane,
+                    ClipVertex out[4]) {
+  int count = 0;
+  for (int k = 0; k < 3; ++k) {
+    const ClipVertex &a = in[k];
+    const ClipVertex &b = in[(k + 1) % 3];
+    double da = nearDistance(a, nearPlane);
+    double db = nearDistance(b, nearPlane);
+    if (da >= 0)
+      out[count++] = a;
+    if ((da >= 0) != (db >= 0)) {
+      double t = da / (da - db);
+      out[count].clip = Vec4{a.clip.x + (b.clip.x - a.clip.x) * t,
+                             a.clip.y + (b.clip.y - a.clip.y) * t, 0.0,
+                             a.clip.w + (b.clip.w - a.clip.w) * t};
+      out[count].world = a.world + (b.world - a.world) * t;
+      out[count].normal = a.normal + (b.normal - a.normal) * t;
+      ++count;
+    }
+  }
+  return count;
+}
+
+static Vertex projectVertex(const ClipVertex &v, const Mat4 &proj,
+                            const Framebuffer &fb) {
+  Vertex out;
+  Vec3 ndc = fromVec4(v.clip);
+  // NDC [-1,1] → tela [0, width/height]
+  out.screen.x = (ndc.x + 1.0) * 0.5 * fb.width;
+  out.screen.y = (1.0 - ndc.y) * 0.5 * fb.height; // Y invertido
+  out.screen.z = depthFromClip(v.clip, proj);     // depth para z-buffer
+  out.world = v.world;
+  out.normal = v.normal;
+  return out;
+}
+
+// Retangulo de tela conservador (todo pixel cujo centro cai nos vertices
+// esta nele) e z mais proximo de vertices ja projetados
+template <typename Bounds>
+static void screenBounds(const Vertex *verts, int count, const Framebuffer &fb,
+                         Bounds &bounds) {
+  double minSX = 1e300, minSY = 1e300, maxSX = -1e300, maxSY = -1e300;
+  bounds.nearest = -1e300;
+  for (int c = 0; c < count; ++c) {
+    minSX = std::min(minSX, verts[c].screen.x);
+    maxSX = std::max(maxSX, verts[c].screen.x);
+    minSY = std::min(minSY, verts[c].screen.y);
+    maxSY = std::max(maxSY, verts[c].screen.y);
+    bounds.nearest = std::max(bounds.nearest, verts[c].screen.z);
+  }
+  bounds.minX = (int)std::clamp(std::floor(minSX), -1.0, (double)fb.width);
+  bounds.maxX = (int)std::clamp(std::floor(maxSX), -1.0, (double)fb.width);
+  bounds.minY = (int)std::clamp(std::floor(minSY), -1.0, (double)fb.height);
+  bounds.maxY = (int)std::clamp(std::floor(maxSY), -1.0, (double)fb.height);
+}
+
+void Renderer::assembleCube(const Scene &scene, int i, const Mat4 &proj,
+                            const Framebuffer &fb, bool usePhong,
+                            std::vector<RasterTriangle> &out,
+                            InstanceBounds &bounds) const {
+  const Camera &camera = *frameCamera;
+  const Cube &cube = scene.cubes[instances.cubeIndex[i]];
+  const size_t n = static_cast<size_t>(instances.count);
+  // Mundo e normais podem vir do lote compartilhado (multi-view)
+  const CubeInstanceBatch &src = instances.worldSource();
+  const size_t wn = static_cast<size_t>(src.count);
+  const size_t wi = static_cast<size_t>(instances.worldSlot(i));
+
+  // Vértices já transformados pelo lote: mundo e clip space
+  ClipVertex corners[8];
+  bool allInFront = true;
+  for (int c = 0; c < 8; ++c) {
+    size_t k = c * n + i, kw = c * wn + wi;
+    corners[c].world = Vec3{src.worldX[kw], src.worldY[kw], src.worldZ[kw]};
+    corners[c].clip =
+        Vec4{instances.clipX[k], instances.clipY[k], 0.0, instances.clipW[k]};
+    if (nearDistance(corners[c], camera.nearPlane) < 0)
+      allInFront = false;
+  }
+
+  // Caso comum: cubo inteiro na frente do near, projeta os 8 cantos uma vez
+  // (e guarda o retangulo de tela e o z mais proximo para o Hi-Z)
+  Vertex verts[8];
+  bounds.testable = allInFront;
+  if (allInFront) {
+    for (int c = 0; c < 8; ++c)
+      verts[c] = projectVertex(corners[c], proj, fb);
+    screenBounds(verts, 8, fb, bounds);
+  }
+
+  // Montar cada face (12 triângulos)
+  for (size_t f = 0; f < 12; ++f) {
+    int i0 = cubeFaces[f][0];
+    int i1 = cubeFaces[f][1];
+    int i2 = cubeFaces[f][2];
+
+    // Normal da face em world space (calculada pelo lote)
+    size_t faceIdx = (f / 2) * wn + wi; // cada face tem 2 triângulos
+    Vec3 faceNormal{src.normalX[faceIdx], src.normalY[faceIdx],
+                    src.normalZ[faceIdx]};
+
+    // Back-face culling: se normal aponta para longe da câmera, pula
+    // (so o sinal importa, entao a direcao nao precisa ser normalizada)
+    Vec3 viewDir = camera.eye - corners[i0].world;
+    if (faceNormal.dot(viewDir) < 0) {
+      RENDER_STAT_ADD(trianglesBackfacing, 1);
+      continue;
+    }
+
+    RasterTriangle tri;
+    tri.faceNormal = faceNormal;
+    tri.material = &cube.material;
+    tri.instance = i;
+
+    if (allInFront) {
+      tri.v[0] = verts[i0];
+      tri.v[1] = verts[i1];
+      tri.v[2] = verts[i2];
+      for (auto &v : tri.v)
+        v.normal = faceNormal;
+      emitTriangle(tri, scene, cube.material, fb, usePhong, out);
+      continue;
+    }
+
+    // Cruza o plano near: recorta e triangula o poligono em leque
+    ClipVertex in[3] = {corners[i0], corners[i1], corners[i2]};
+    ClipVertex poly[4];
+    int count = clipNear(in, camera.nearPlane, poly);
+    RENDER_STAT_ADD(trianglesNearClipped, 1);
+    for (int k = 1; k + 1 < count; ++k) {
+      tri.v[0] = projectVertex(poly[0], proj, fb);
+      tri.v[1] = projectVertex(poly[k], proj, fb);
+      tri.v[2] = projectVertex(poly[k + 1], proj, fb);
+      for (auto &v : tri.v)
+        v.normal = faceNormal;
+      emitTriangle(tri, scene, cube.material, fb, usePhong, out);
+    }
+  }
+}
+
+// Normais dos vertices (Phong) ja preenchidas: a da face nos cubos, a
+// interpolada nas malhas
+void Renderer::emitTriangle(RasterTriangle &tri, const Scene &scene,
+                            const Material &material, const Framebuffer &fb,
+                            bool usePhong,
+                            std::vector<RasterTriangle> &out) const {
+  // Setup (arestas + bounding box) uma vez por triangulo
+  if (!setupTriangle(tri, fb.width, fb.height, fb.samples > 1)) {
+    RENDER_STAT_ADD(trianglesRejected, 1);
+    return;
+  }
+
+  // Flat shading: calcula cor uma vez
+  if (!usePhong) {
+    RENDER_STAT_TIMER(shadeStart);
+    Vec3 faceCenter =
+        (tri.v[0].world + tri.v[1].world + tri.v[2].world) * (1.0 / 3.0);
+    tri.flatColor = computeLighting(
+        tri.faceNormal, faceCenter, material, scene.lights, frameCamera->eye,
+        false,
+        shading.lightSoA.anyShadow ? shading.lightSoA.shadowMap.data()
+                                   : nullptr);
+    RENDER_STAT_ELAPSED(shadeSeconds, shadeStart);
+  }
+
+  out.push_back(tri);
+}
+
+// ============ MALHAS ============
+
+// Frustum culling por instancia de malha (caixa em mundo) e divisao do
+// trabalho das visiveis em tarefas de vertices e blocos de triangulos.
+// Tambem calcula o retangulo de tela das instancias para o Hi-Z.
+void Renderer::cullMeshes(const Scene &scene, const Frustum *frustum,
+                          const Mat4 &proj, const Framebuffer &fb) {
+  visibleMeshes.clear();
+  meshVertexJobs.clear();
+  meshChunks.clear();
+  size_t totalVertices = 0;
+
+  for (int m = 0; m < (int)scene.meshes.size(); ++m) {
+    const MeshInstance &inst = scene.meshes[m];
+    if (!inst.mesh || inst.mesh->triangleCount() == 0)
+      continue;
+    AABB box = inst.worldBounds();
+    unsigned mask = 0x3f;
+    if (frustum && !frustum->testAABB(box, mask))
+      continue;
+
+    int visible = (int)visibleMeshes.size();
+    visibleMeshes.push_back(VisibleMesh{
+        m, instances.count + visible, totalVertices, inst.modelMatrix()});
+    const Mesh &mesh = *inst.mesh;
+    for (int v = 0; v < mesh.vertexCount(); v += MESH_VERTEX_CHUNK)
+      meshVertexJobs.push_back(MeshRange{
+          visible, v, std::min(mesh.vertexCount(), v + MESH_VERTEX_CHUNK)});
+    for (int t = 0; t < mesh.triangleCount(); t += MESH_CHUNK)
+      meshChunks.push_back(MeshRange{
+          visible, t, std::min(mesh.triangleCount(), t + MESH_CHUNK)});
+    totalVertices += static_cast<size_t>(mesh.vertexCount());
+  }
+  meshVertices.resize(totalVertices);
+
+  // Retangulo e profundidade dos cantos da caixa (occlusion culling).
+  // Capacidade para todas as instancias da cena, como no lote
+  instanceBounds.reserve(scene.cubes.size() + scene.meshes.size());
+  instanceBounds.resize(instances.count + visibleMeshes.size());
+  for (const VisibleMesh &vm : visibleMeshes) {
+    AABB box = scene.meshes[vm.mesh].worldBounds();
+    InstanceBounds &bounds = instanceBounds[vm.instance];
+    Vertex verts[8];
+    bounds.testable = true;
+    for (int c = 0; c < 8 && bounds.testable; ++c) {
+      ClipVertex corner;
+      corner.world = Vec3{c & 1 ? box.max.x : box.min.x,
+                          c & 2 ? box.max.y : box.min.y,
+                          c & 4 ? box.max.z : box.min.z};
+      corner.clip = viewProj * toVec4(corner.world);
+      bounds.testable = nearDistance(corner, frameCamera->nearPlane) >= 0;
+      verts[c] = projectVertex(corner, proj, fb);
+    }
+    if (bounds.testable)
+      screenBounds(verts, 8, fb, bounds);
+  }
+}
+
+// Vertice de malha em mundo e sua normal (parte 3x3 da matriz modelo;
+// escala uniforme dispensa a inversa)
+static inline void meshWorldVertex(const Mat4 &m, const float *p,
+                                   const float *n, Vec3 &world, Vec3 &normal) {
+  Vec4 w = m * Vec4{p[0], p[1], p[2], 1.0};
+  world = Vec3{w.x, w.y, w.z};
+  normal = Vec3{n[0] * m.m[0][0] + n[1] * m.m[1][0] + n[2] * m.m[2][0],
+                n[0] * m.m[0][1] + n[1] * m.m[1][1] + n[2] * m.m[2][1],
+                n[0] * m.m[0][2] + n[1] * m.m[1][2] + n[2] * m.m[2][2]}
+               .normalized();
+}
+
+// Transforma os vertices [begin, end) de uma malha visivel: mundo, normal
+// (parte 3x3 da matriz modelo; escala uniforme dispensa a inversa), clip,
+// semi-espacos de que esta fora e, na frente do near, posicao de tela
+void Renderer::transformMesh(const Scene &scene, const MeshRange &range,
+                             const Mat4 &proj, const Framebuffer &fb) {
+  const VisibleMesh &vm = visibleMeshes[range.visible];
+  const Mesh &mesh = *scene.meshes[vm.mesh].mesh;
+  const Mat4 &m = vm.model;
+  const float *positions = mesh.positions();
+  const float *normals = mesh.normals();
+  const double nearPlane = frameCamera->nearPlane;
+  MeshVertex *out = &meshVertices[vm.firstVertex];
+
+  // Multi-view: mundo e normais ja calculados (WorldStage::build)
+  const Vec3 *sharedWorld = nullptr, *sharedNormals = nullptr;
+  if (world) {
+    size_t first = world->meshFirstVertex[vm.mesh];
+    sharedWorld = &world->meshWorld[first];
+    sharedNormals = &world->meshNormals[first];
+  }
+
+  for (int v = range.begin; v < range.end; ++v) {
+    ClipVertex cv;
+    if (sharedWorld) {
+      cv.world = sharedWorld[v];
+      cv.normal = sharedNormals[v];
+    } else {
+      meshWorldVertex(m, &positions[static_cast<size_t>(v) * 3],
+                      &normals[static_cast<size_t>(v) * 3], cv.world,
+                      cv.normal);
+    }
+    cv.clip = viewProj * toVec4(cv.world);
+
+    // NDC fora de [-1,1] em x/y (w < 0 na frente) ou atras do near. So
+    // planos que nao mudam a imagem: triangulos alem do far continuam
+    // sendo desenhados, como os dos cubos
+    const double x = cv.clip.x, y = cv.clip.y, w = cv.clip.w;
+    unsigned code = 0;
+    code |= (x < w) << 0;
+    code |= (x > -w) << 1;
+    code |= (y < w) << 2;
+    code |= (y > -w) << 3;
+    code |= nearDistance(cv, nearPlane) < 0 ? OUT_NEAR : 0u;
+
+    MeshVertex &mv = out[v];
+    mv.clipX = x;
+    mv.clipY = y;
+    mv.clipW = w;
+    mv.outcode = code;
+    if (code & OUT_NEAR) {
+      mv.vertex.world = cv.world;
+      mv.vertex.normal = cv.normal;
+    } else {
+      mv.vertex = projectVertex(cv, proj, fb);
+    }
+  }
+}
+
+// Monta os triangulos [begin, end) de uma malha visivel lendo os vertices
+// do cache. Mesmo caminho dos cubos: back-face, recorte no near e setup.
+void Renderer::assembleMesh(const Scene &scene, const MeshRange &range,
+                            const Mat4 &proj, const Framebuffer &fb,
+                            bool usePhong,
+                            std::vector<RasterTriangle> &out) const {
+  const VisibleMesh &vm = visibleMeshes[range.visible];
+  const MeshInstance &inst = scene.meshes[vm.mesh];
+  const Camera &camera = *frameCamera;
+  const uint32_t *indices = inst.mesh->indices();
+  const uint32_t vertexCount = static_cast<uint32_t>(inst.mesh->vertexCount());
+  const MeshVertex *cache = &meshVertices[vm.firstVertex];
+
+  for (int t = range.begin; t < range.end; ++t) {
+    const uint32_t *idx = &indices[static_cast<size_t>(t) * 3];
+    if (idx[0] >= vertexCount || idx[1] >= vertexCount ||
+        idx[2] >= vertexCount) {
+      RENDER_STAT_ADD(trianglesRejected, 1); // arquivo .rmesh corrompido
+      continue;
+    }
+    const MeshVertex *mv[3] = {&cache[idx[0]], &cache[idx[1]], &cache[idx[2]]};
+
+    // Os 3 vertices fora do mesmo semi-espaco: nenhum pixel
+    if (mv[0]->outcode & mv[1]->outcode & mv[2]->outcode) {
+      RENDER_STAT_ADD(trianglesRejected, 1);
+      continue;
+    }
+
+    const Vec3 &w0 = mv[0]->vertex.world;
+    Vec3 faceNormal =
+        (mv[1]->vertex.world - w0).cross(mv[2]->vertex.world - w0);
+    if (faceNormal.dot(camera.eye - w0) < 0) {
+      RENDER_STAT_ADD(trianglesBackfacing, 1);
+      continue;
+    }
+    double length = faceNormal.length();
+    if (!(length > 0)) {
+      RENDER_STAT_ADD(trianglesRejected, 1);
+      continue;
+    }
+
+    RasterTriangle tri;
+    tri.faceNormal = faceNormal * (1.0 / length);
+    tri.material = &inst.material;
+    tri.instance = vm.instance;
+
+    if (!((mv[0]->outcode | mv[1]->outcode | mv[2]->outcode) & OUT_NEAR)) {
+      for (int k = 0; k < 3; ++k)
+        tri.v[k] = mv[k]->vertex;
+      emitTriangle(tri, scene, inst.material, fb, usePhong, out);
+      continue;
+    }
+
+    ClipVertex in[3];
+    for (int k = 0; k < 3; ++k)
+      in[k] = ClipVertex{Vec4{mv[k]->clipX, mv[k]->clipY, 0.0, mv[k]->clipW},
+                         mv[k]->vertex.world, mv[k]->vertex.normal};
+    ClipVertex poly[4];
+    int count = clipNear(in, camera.nearPlane, poly);
+    RENDER_STAT_ADD(trianglesNearClipped, 1);
+    for (int k = 1; k + 1 < count; ++k) {
+      tri.v[0] = projectVertex(poly[0], proj, fb);
+      tri.v[1] = projectVertex(poly[k], proj, fb);
+      tri.v[2] = projectVertex(poly[k + 1], proj, fb);
+      emitTriangle(tri, scene, inst.material, fb, usePhong, out);
+    }
+  }
+}
+
+// ============ BINNING ============
+
+// Duas passadas: a primeira le a caixa de cada triangulo, guarda o
+// intervalo de tiles dele (compacto, na arena) e conta quantos caem em cada
+// tile; a segunda grava os ids nas listas contiguas (CSR) sem voltar aos
+// triangulos
+void Renderer::binTriangles(int tilesX, int tilesY, int tileSize) {
+  size_t numTiles = static_cast<size_t>(tilesX) * tilesY;
+  binOffset = arena.array<size_t>(numTiles + 1, 0).data;
+
+  struct TileSpan {
+    uint16_t tx0, ty0, tx1, ty1;
+  };
+  size_t numTriangles = 0;
+  for (int c = 0; c < numChunks; ++c)
+    numTriangles += chunkTriangles[c].size();
+  TileSpan *spans = arena.allocate<TileSpan>(numTriangles);
+
+  TileSpan *span = spans;
+  for (int c = 0; c < numChunks; ++c) {
+    for (const RasterTriangle &tri : chunkTriangles[c]) {
+      *span = TileSpan{
+          uint16_t(tri.minX / tileSize), uint16_t(tri.minY / tileSize),
+          uint16_t(tri.maxX / tileSize), uint16_t(tri.maxY / tileSize)};
+      for (int ty = span->ty0; ty <= span->ty1; ++ty)
+        for (int tx = span->tx0; tx <= span->tx1; ++tx)
+          ++binOffset[ty * tilesX + tx + 1];
+      ++span;
+    }
+  }
+  for (size_t t = 0; t < numTiles; ++t)
+    binOffset[t + 1] += binOffset[t];
+
+  // Ordem de submissao preservada dentro de cada tile
+  binIds = arena.allocate<uint32_t>(binOffset[numTiles]);
+  size_t *cursor = arena.allocate<size_t>(numTiles);
+  std::copy(binOffset, binOffset + numTiles, cursor);
+  span = spans;
+  for (int c = 0; c < numChunks; ++c) {
+    uint32_t count = static_cast<uint32_t>(chunkTriangles[c].size());
+    for (uint32_t i = 0; i < count; ++i, ++span) {
+      uint32_t id = (uint32_t(c) << TRIANGLE_ID_BITS) | i;
+      for (int ty = span->ty0; ty <= span->ty1; ++ty)
+        for (int tx = span->tx0; tx <= span->tx1; ++tx)
+          binIds[cursor[ty * tilesX + tx]++] = id;
+    }
+  }
+}
+
+// ============ OCCLUSION CULLING ============
+
+// Profundidade mais distante do retangulo (nivel grosso do Hi-Z)
+static DepthValue farthestInRect(const Framebuffer &fb, const PixelRect &r) {
+  const int B = Framebuffer::HIZ_BLOCK;
+  DepthValue farthest = -DEPTH_CLEAR;
+  for (int by = r.y0 / B; by <= (r.y1 - 1) / B; ++by)
+    for (int bx = r.x0 / B; bx <= (r.x1 - 1) / B; ++bx)
+      farthest = std::min(farthest, fb.hiZ[by * fb.hiZWidth + bx]);
+  return farthest;
+}
+
+// Oculto se o ponto mais proximo do cubo esta atras do ponto mais distante
+// ja gravado em todos os blocos 8x8 que ele cobre dentro do tile
+bool Renderer::occluded(const Framebuffer &fb, const InstanceBounds &bounds,
+                        const PixelRect &rect, DepthValue tileFarthest) const {
+  if (!bounds.testable)
+    return false;
+  if (bounds.nearest < tileFarthest)
+    return true;
+
+  const int B = Framebuffer::HIZ_BLOCK;
+  int x0 = std::max(bounds.minX, rect.x0), x1 = std::min(bounds.maxX, rect.x1 - 1);
+  int y0 = std::max(bounds.minY, rect.y0), y1 = std::min(bounds.maxY, rect.y1 - 1);
+  if (x0 > x1 || y0 > y1)
+    return false;
+  for (int by = y0 / B; by <= y1 / B; ++by)
+    for (int bx = x0 / B; bx <= x1 / B; ++bx)
+      if (!(bounds.nearest < fb.hiZ[by * fb.hiZWidth + bx]))
+        return false;
+  return true;
+}
+
+void Renderer::rasterizeTile(Framebuffer &fb, int tile, const PixelRect &rect,
+                             const RenderOptions &options,
+                             TileStats &tileStats) const {
+  const FrameSpan<const uint32_t> bin = this->bin(tile);
+
+  // Deferred: G-buffer do tamanho do tile, um por thread (fica no cache).
+  // As luzes so sao escolhidas no resolve, com a geometria visivel.
+  // Com MSAA o caminho e sempre o direto
+  const bool multisample = fb.samples > 1;
+  GBuffer *gbuffer = nullptr;
+  if (options.deferred && options.usePhong && !multisample) {
+    thread_local GBuffer tileGBuffer;
+    tileGBuffer.reset(rect);
+    gbuffer = &tileGBuffer;
+  }
+  // Direto com Phong e luzes com alcance: luzes escolhidas por triangulo
+  bool perTriangleLights = cullLights && options.usePhong && !gbuffer;
+  const RasterFn raster = rasterKernel(options.usePhong, gbuffer != nullptr,
+                                      multisample, options.depthOnly);
+  auto draw = [&](const RasterTriangle &tri) {
+    tileStats.depthPasses += raster(
+        fb, tri, rect, perTriangleLights ? triangleShading(tile, tri) : shading,
+        gbuffer);
+  };
+  // Direto: cada fragmento que passa no z-test e sombreado. MSAA: media
+  // das amostras do tile enquanto ainda estao no cache
+  auto finish = [&]() {
+    tileStats.fragmentsShaded +=
+        gbuffer ? resolveTile(fb, *gbuffer, tile, tileStats.temporalReused)
+                : tileStats.depthPasses;
+    if (multisample)
+      fb.resolve(rect.x0, rect.y0, rect.x1, rect.y1);
+  };
+
+  if (!options.occlusionCulling) {
+    for (uint32_t id : bin)
+      draw(triangle(id));
+    finish();
+    return;
+  }
+
+  // Os triangulos de um cubo sao consecutivos no bin: o cubo e testado uma
+  // vez e, depois de desenhado, o Hi-Z da area que ele tocou e atualizado
+  DepthValue tileFarthest = farthestInRect(fb, rect);
+  PixelRect dirty{rect.x1, rect.y1, rect.x0 - 1, rect.y0 - 1}; // inclusivo
+  auto refreshHiZ = [&]() {
+    if (dirty.x0 > dirty.x1)
+      return;
+    fb.updateHiZ(dirty.x0, dirty.y0, dirty.x1, dirty.y1);
+    tileFarthest = farthestInRect(fb, rect);
+    dirty = PixelRect{rect.x1, rect.y1, rect.x0 - 1, rect.y0 - 1};
+  };
+
+  int current = -1;
+  bool skip = false;
+  for (uint32_t id : bin) {
+    const RasterTriangle &tri = triangle(id);
+    if (tri.instance != current) {
+      refreshHiZ();
+      current = tri.instance;
+      skip = occluded(fb, instanceBounds[current], rect, tileFarthest);
+      ++tileStats.occlusion.cubeTests;
+      tileStats.occlusion.cubesRejected += skip;
+    }
+    if (skip) {
+      ++tileStats.occlusion.trianglesSkipped;
+      continue;
+    }
+    draw(tri);
+    dirty.x0 = std::max(rect.x0, std::min(dirty.x0, tri.minX));
+    dirty.y0 = std::max(rect.y0, std::min(dirty.y0, tri.minY));
+    dirty.x1 = std::min(rect.x1 - 1, std::max(dirty.x1, tri.maxX));
+    dirty.y1 = std::min(rect.y1 - 1, std::max(dirty.y1, tri.maxY));
+  }
+  refreshHiZ();
+  finish();
+}
+
+// ============ LUZES POR TILE ============
+
+// Distribui as luzes com alcance nos tiles que a esfera de alcance pode
+// tocar (retangulo de tela conservador dos 8 cantos da caixa da esfera).
+// Luzes sem alcance entram em todos os tiles. A lista de cada tile fica em
+// ordem crescente de indice: a soma das contribuicoes segue a mesma ordem
+// do caminho sem culling e as luzes descartadas contribuiriam com zero, entao
+// a imagem e identica.
+void Renderer::assignLightsToTiles(const Scene &scene, const Framebuffer &fb,
+                                   const RenderOptions &options, int tilesX,
+                                   int tilesY, int tileSize) {
+  cullLights = false;
+  if (options.lightCulling && !options.depthOnly)
+    for (const Light &light : scene.lights)
+      cullLights |= light.range > 0;
+  if (!cullLights)
+    return;
+
+  // Retangulo de tiles de cada luz; depois as listas em CSR, como os bins
+  size_t numTiles = static_cast<size_t>(tilesX) * tilesY;
+  int numLights = static_cast<int>(scene.lights.size());
+  struct TileRange {
+    int tx0, ty0, tx1, ty1; // inclusivo
+  };
+  TileRange *lightTiles = arena.allocate<TileRange>(numLights);
+
+  const Camera &camera = *frameCamera;
+  Frustum frustum =
+      Frustum::fromViewProj(viewProj, camera.nearPlane, camera.farPlane);
+
+  for (int l = 0; l < numLights; ++l) {
+    const Light &light = scene.lights[l];
+    int tx0 = 0, ty0 = 0, tx1 = tilesX - 1, ty1 = tilesY - 1;
+    lightTiles[l] = TileRange{0, 0, -1, -1}; // vazio
+
+    if (light.range > 0) {
+      double r = light.range;
+      AABB box;
+      box.min = light.position - Vec3{r, r, r};
+      box.max = light.position + Vec3{r, r, r};
+      unsigned mask = 0x3f;
+      if (!frustum.testAABB(box, mask))
+        continue; // esfera inteira fora do frustum
+
+      // Se algum canto fica atras do plano near a projecao nao e limitada:
+      // a luz fica em todos os tiles
+      double minSX = 1e300, minSY = 1e300, maxSX = -1e300, maxSY = -1e300;
+      bool unbounded = false;
+      for (int c = 0; c < 8 && !unbounded; ++c) {
+        Vec3 corner{c & 1 ? box.max.x : box.min.x,
+                    c & 2 ? box.max.y : box.min.y,
+                    c & 4 ? box.max.z : box.min.z};
+        Vec4 clip = viewProj * toVec4(corner);
+        if (-clip.w < camera.nearPlane) {
+          unbounded = true;
+          break;
+        }
+        Vec3 ndc = fromVec4(clip);
+        double sx = (ndc.x + 1.0) * 0.5 * fb.width;
+        double sy = (1.0 - ndc.y) * 0.5 * fb.height;
+        minSX = std::min(minSX, sx);
+        maxSX = std::max(maxSX, sx);
+        minSY = std::min(minSY, sy);
+        maxSY = std::max(maxSY, sy);
+      }
+      if (!unbounded) {
+        if (maxSX < 0 || maxSY < 0 || minSX >= fb.width || minSY >= fb.height)
+          continue;
+        tx0 = std::max(0, (int)std::floor(minSX) / tileSize);
+        ty0 = std::max(0, (int)std::floor(minSY) / tileSize);
+        tx1 = std::min(tilesX - 1, (int)std::floor(maxSX) / tileSize);
+        ty1 = std::min(tilesY - 1, (int)std::floor(maxSY) / tileSize);
+      }
+    }
+
+    lightTiles[l] = TileRange{tx0, ty0, tx1, ty1};
+  }
+
+  tileLightOffset = arena.array<size_t>(numTiles + 1, 0).data;
+  for (int l = 0; l < numLights; ++l) {
+    const TileRange &r = lightTiles[l];
+    for (int ty = r.ty0; ty <= r.ty1; ++ty)
+      for (int tx = r.tx0; tx <= r.tx1; ++tx)
+        ++tileLightOffset[ty * tilesX + tx + 1];
+  }
+  for (size_t t = 0; t < numTiles; ++t)
+    tileLightOffset[t + 1] += tileLightOffset[t];
+  tileLightIds = arena.allocate<int>(tileLightOffset[numTiles]);
+  size_t *cursor = arena.allocate<size_t>(numTiles);
+  std::copy(tileLightOffset, tileLightOffset + numTiles, cursor);
+  // Luzes em ordem crescente em cada tile
+  for (int l = 0; l < numLights; ++l) {
+    const TileRange &r = lightTiles[l];
+    for (int ty = r.ty0; ty <= r.ty1; ++ty)
+      for (int tx = r.tx0; tx <= r.tx1; ++tx)
+        tileLightIds[cursor[ty * tilesX + tx]++] = l;
+  }
+}
+
+// A esfera de alcance da luz toca a caixa? (luz sem alcance: sempre)
+static bool lightReaches(const Light &light, const AABB &box) {
+  if (light.range <= 0)
+    return true;
+  const Vec3 &p = light.position;
+  double dx = std::max({box.min.x - p.x, 0.0, p.x - box.max.x});
+  double dy = std::max({box.min.y - p.y, 0.0, p.y - box.max.y});
+  double dz = std::max({box.min.z - p.z, 0.0, p.z - box.max.z});
+  return dx * dx + dy * dy + dz * dz < light.range * light.range;
+}
+
+// Luzes de `from` que alcancam a caixa (mantem a ordem crescente)
+void Renderer::selectLights(FrameSpan<const int> from, const AABB &box,
+                            std::vector<int> &out) const {
+  out.clear();
+  for (int l : from)
+    if (lightReaches((*shading.lights)[l], box))
+      out.push_back(l);
+}
+
+// Modo direto (Phong): as luzes do tile que alcancam a caixa em mundo do
+// triangulo. Custa uma passada pela lista por triangulo, em vez de avaliar
+// luzes inalcancaveis em cada pixel.
+const ShadingContext &
+Renderer::triangleShading(int tile, const RasterTriangle &tri) const {
+  thread_local ShadingContext ctx;
+  thread_local std::vector<int> selected;
+  ctx.lights = shading.lights;
+  ctx.eyePos = shading.eyePos;
+
+  AABB box;
+  for (const Vertex &v : tri.v)
+    box.expand(v.world);
+  selectLights(lightsOfTile(tile), box, selected);
+  ctx.lightSoA.gather(shading.lightSoA, selected);
+  return ctx;
+}
+
+// ============ RESOLVE (DEFERRED) ============
+
+// Sombreia cada pixel do tile que tem geometria, uma vez, bloco 8x8 por
+// bloco. Pixels vizinhos da mesma linha com o mesmo material formam um
+// pacote, lido direto dos arrays SoA do G-buffer pelo kernel vetorial.
+// Com luzes por tile, cada bloco usa so as luzes que alcancam a caixa em
+// mundo dos seus pixels visiveis. Com o cache temporal o difuso vem do
+// frame anterior quando possivel (contado em `temporalReused`). Retorna
+// quantos pixels foram sombreados.
+int Renderer::resolveTile(Framebuffer &fb, const GBuffer &gbuffer, int tile,
+                          long long &temporalReused) const {
+  const PixelRect &rect = gbuffer.rect;
+  PhongShadeFn kernel = nullptr;
+
+  thread_local ShadingContext blockCtx;
+  thread_local std::vector<int> tileList, blockList, allLights;
+  // Visibilidade das luzes de cada pacote (sombras)
+  thread_local std::vector<double> shadowScratch;
+  if (shading.lightSoA.anyShadow &&
+      shadowScratch.size() <
+          static_cast<size_t>(shading.lightSoA.count) * PHONG_PACKET_SIZE)
+    shadowScratch.resize(static_cast<size_t>(shading.lightSoA.count) *
+                         PHONG_PACKET_SIZE);
+  // Indices em scene.lights das luzes de ctx->lightSoA (cache temporal)
+  const int *lightIds = nullptr;
+  if (frameTemporal && !cullLights) {
+    allLights.resize(static_cast<size_t>(shading.lightSoA.count));
+    for (int l = 0; l < shading.lightSoA.count; ++l)
+      allLights[l] = l;
+    lightIds = allLights.data();
+  }
+  const ShadingContext *ctx = &shading;
+  if (cullLights) {
+    blockCtx.lights = shading.lights;
+    blockCtx.eyePos = shading.eyePos;
+    ctx = &blockCtx;
+
+    // Primeiro filtro: caixa dos pixels visiveis do tile inteiro
+    AABB visible;
+    for (size_t k = 0; k < gbuffer.material.size(); ++k)
+      if (gbuffer.material[k] >= 0)
+        visible.expand(Vec3{gbuffer.worldX[k], gbuffer.worldY[k],
+                            gbuffer.worldZ[k]});
+    selectLights(lightsOfTile(tile), visible, tileList);
+  }
+
+  PhongPacketSetup setup;
+  int shaded = 0;
+  const int B = Framebuffer::HIZ_BLOCK;
+  for (int by = rect.y0; by < rect.y1; by += B) {
+    int y1 = std::min(rect.y1, by + B);
+    for (int bx = rect.x0; bx < rect.x1; bx += B) {
+      int x1 = std::min(rect.x1, bx + B);
+
+      if (cullLights) {
+        AABB visible;
+        for (int y = by; y < y1; ++y)
+          for (int x = bx; x < x1; ++x) {
+            size_t k = gbuffer.index(x, y);
+            if (gbuffer.material[k] >= 0)
+              visible.expand(Vec3{gbuffer.worldX[k], gbuffer.worldY[k],
+                                  gbuffer.worldZ[k]});
+          }
+        if (visible.min.x > visible.max.x)
+          continue; // bloco sem geometria
+        selectLights({tileList.data(), tileList.size()}, visible, blockList);
+        blockCtx.lightSoA.gather(shading.lightSoA, blockList);
+        lightIds = blockList.data();
+      }
+
+      int setupMaterial = -1;
+      for (int y = by; y < y1; ++y) {
+        size_t row = gbuffer.index(bx, y);
+        const int32_t *material = &gbuffer.material[row];
+        uint32_t *out = fb.color + static_cast<size_t>(y) * fb.width + bx;
+        int width = x1 - bx;
+        for (int x = 0; x < width;) {
+          int id = material[x];
+          if (id < 0) {
+            ++x;
+            continue;
+          }
+          int count = 1;
+          while (count < PHONG_PACKET_SIZE && x + count < width &&
+                 material[x + count] == id)
+            ++count;
+
+          if (id != setupMaterial) {
+            setupPhongPacket(setup, *instanceMaterials[id], *ctx);
+            kernel = phongShadeKernel(setup);
+            setupMaterial = id;
+          }
+          size_t k = row + x;
+          RENDER_STAT_TIMER(shadeStart);
+          if (frameTemporal) {
+            temporalReused += frameTemporal->shade(
+                setup, kernel, lightIds, bx + x, y, &gbuffer.normalX[k],
+                &gbuffer.normalY[k], &gbuffer.normalZ[k], &gbuffer.worldX[k],
+                &gbuffer.worldY[k], &gbuffer.worldZ[k], count,
+                shadowScratch.data(), out + x);
+            RENDER_STAT_ELAPSED(shadeSeconds, shadeStart);
+            RENDER_STAT_ADD(shadingPackets, 1);
+            x += count;
+            shaded += count;
+            continue;
+          }
+          if (ctx->lightSoA.anyShadow) {
+            shadowVisibility(ctx->lightSoA, &gbuffer.normalX[k],
+                             &gbuffer.normalY[k], &gbuffer.normalZ[k],
+                             &gbuffer.worldX[k], &gbuffer.worldY[k],
+                             &gbuffer.worldZ[k], count, shadowScratch.data());
+            setup.shadow = shadowScratch.data();
+          }
+          kernel(setup, &gbuffer.normalX[k], &gbuffer.normalY[k],
+                 &gbuffer.normalZ[k], &gbuffer.worldX[k], &gbuffer.worldY[k],
+                 &gbuffer.worldZ[k], count, out + x);
+          RENDER_STAT_ELAPSED(shadeSeconds, shadeStart);
+          RENDER_STAT_ADD(shadingPackets, 1);
+          x += count;
+          shaded += count;
+        }
+      }
+    }
+  }
+  return shaded;
+}
+
+// ============ ETAPA EM MUNDO (MULTI-VIEW) ============
+
+void WorldStage::build(const Scene &scene, ThreadPool &pool) {
+  // Blocos do mesmo tamanho dos do Renderer
+  constexpr int CUBE_CHUNK = 4096;
+  constexpr int VERTEX_CHUNK = 16384;
+
+  bvh.update(scene.cubes);
+  cubes.assign(scene.cubes);
+  int cubeChunks = (cubes.count + CUBE_CHUNK - 1) / CUBE_CHUNK;
+
+  // Malhas: vertices de todas em sequencia, tarefas de VERTEX_CHUNK
+  struct VertexJob {
+    int mesh, begin, end;
+  };
+  std::vector<VertexJob> jobs;
+  meshFirstVertex.assign(scene.meshes.size(), 0);
+  size_t total = 0;
+  for (int m = 0; m < (int)scene.meshes.size(); ++m) {
+    meshFirstVertex[m] = total;
+    const MeshInstance &inst = scene.meshes[m];
+    if (!inst.mesh)
+      continue;
+    int count = inst.mesh->vertexCount();
+    for (int v = 0; v < count; v += VERTEX_CHUNK)
+      jobs.push_back(VertexJob{m, v, std::min(count, v + VERTEX_CHUNK)});
+    total += static_cast<size_t>(count);
+  }
+  meshWorld.resize(total);
+  meshNormals.resize(total);
+
+  pool.parallelFor(cubeChunks + (int)jobs.size(), [&](int j) {
+    if (j < cubeChunks) {
+      int begin = j * CUBE_CHUNK;
+      cubes.transformWorld(begin, std::min(cubes.count, begin + CUBE_CHUNK));
+      return;
+    }
+    const VertexJob &job = jobs[j - cubeChunks];
+    const MeshInstance &inst = scene.meshes[job.mesh];
+    Mat4 m = inst.modelMatrix();
+    const float *positions = inst.mesh->positions();
+    const float *normals = inst.mesh->normals();
+    size_t first = meshFirstVertex[job.mesh];
+    for (int v = job.begin; v < job.end; ++v)
+      meshWorldVertex(m, &positions[static_cast<size_t>(v) * 3],
+                      &normals[static_cast<size_t>(v) * 3],
+                      meshWorld[first + v], meshNormals[first + v]);
+  });
+}
+
+// ============ FRAME ============
+
+void Renderer::render(const Scene &scene, Framebuffer &fb,
+                      const RenderOptions &options,
+                      const DirtyRegion *region,
+                      const std::vector<int> *changedCubes) {
+  frameCamera = &scene.camera;
+  world = nullptr;
+  // A lista de mudancas so vale se a BVH acompanhou o render anterior
+  cubeChanges = bvhCurrent ? changedCubes : nullptr;
+  bvhCurrent = false;
+  renderFrame(scene, fb, options, region);
+  cubeChanges = nullptr;
+}
+
+void Renderer::render(const Scene &scene, const Camera &camera,
+                      const WorldStage &world, Framebuffer &fb,
+                      const RenderOptions &options) {
+  frameCamera = &camera;
+  this->world = &world;
+  bvhCurrent = false;
+  renderFrame(scene, fb, options, nullptr);
+  this->world = nullptr;
+}
+
+void Renderer::renderFrame(const Scene &scene, Framebuffer &fb,
+                           const RenderOptions &options,
+                           const DirtyRegion *region) {
+  RENDER_STAT_TIMER(frameStart);
+  arena.reset();
+  fb.setSamples(options.msaaSamples);
+
+  // Tiles alinhados aos blocos do Hi-Z (cada bloco pertence a um so tile).
+  // Caminho serial: um unico "tile" cobrindo a tela inteira.
+  const int B = Framebuffer::HIZ_BLOCK;
+  int tileSize = options.tiled ? std::max(B, options.tileSize)
+                               : std::max({B, fb.width, fb.height});
+  tileSize = (tileSize + B - 1) / B * B;
+  int tilesX = (fb.width + tileSize - 1) / tileSize;
+  int tilesY = (fb.height + tileSize - 1) / tileSize;
+
+  // Re-render parcial: marca, limpa e delimita os tiles da regiao
+  PixelRect dirtyBounds{fb.width, fb.height, 0, 0};
+  redrawn = static_cast<long long>(fb.width) * fb.height;
+  if (region) {
+    redrawn = 0;
+    tileMask = arena.array<uint8_t>(static_cast<size_t>(tilesX) * tilesY, 0);
+    for (const PixelRect &r : region->rects) {
+      int tx0 = std::max(r.x0, 0) / tileSize;
+      int ty0 = std::max(r.y0, 0) / tileSize;
+      int tx1 = (std::min(r.x1, fb.width) - 1) / tileSize;
+      int ty1 = (std::min(r.y1, fb.height) - 1) / tileSize;
+      for (int ty = ty0; ty <= ty1; ++ty)
+        for (int tx = tx0; tx <= tx1; ++tx)
+          tileMask[ty * tilesX + tx] = 1;
+    }
+    for (int t = 0; t < tilesX * tilesY; ++t) {
+      if (!tileMask[t])
+        continue;
+      int tx = t % tilesX, ty = t / tilesX;
+      PixelRect rect{tx * tileSize, ty * tileSize,
+                     std::min(fb.width, (tx + 1) * tileSize),
+                     std::min(fb.height, (ty + 1) * tileSize)};
+      fb.clearRect(rect.x0, rect.y0, rect.x1, rect.y1, region->clearColor);
+      redrawn += static_cast<long long>(rect.x1 - rect.x0) * (rect.y1 - rect.y0);
+      dirtyBounds.x0 = std::min(dirtyBounds.x0, rect.x0);
+      dirtyBounds.y0 = std::min(dirtyBounds.y0, rect.y0);
+      dirtyBounds.x1 = std::max(dirtyBounds.x1, rect.x1);
+      dirtyBounds.y1 = std::max(dirtyBounds.y1, rect.y1);
+    }
+    if (dirtyBounds.x0 >= dirtyBounds.x1) {
+      stats = RenderStats{};
+      return; // nada a redesenhar
+    }
+  }
+
+  // Luzes do frame (o flat ja as usa na montagem dos triangulos) e
+  // shadow maps em dia antes da geometria
+  shading.lights = &scene.lights;
+  shading.eyePos = frameCamera->eye;
+  shading.lightSoA.assign(scene.lights);
+  long long shadowFaces = 0;
+  RENDER_STAT_TIMER(shadowStart);
+  if (options.shadows && !options.depthOnly) {
+    const ShadowMapCache *maps = world ? world->shadows : nullptr;
+    if (!world) {
+      if (!shadowCache)
+        shadowCache = std::make_unique<ShadowMapCache>(pool);
+      shadowFaces = shadowCache->update(scene, options);
+      maps = shadowCache.get();
+    }
+    if (maps)
+      maps->attach(shading.lightSoA);
+  }
+#ifdef RENDER_ENABLE_STATS
+  double shadowMs = statsSeconds(shadowStart) * 1000.0;
+#endif
+
+  buildTriangles(scene, fb, options, region ? &dirtyBounds : nullptr);
+
+  // Cache temporal: so no resolve do deferred, com a tela inteira e uma
+  // vista. Frames que nao o usam o invalidam
+  frameTemporal = nullptr;
+  if (options.temporal && options.deferred && options.usePhong &&
+      fb.samples == 1 && !options.depthOnly && !region && !world) {
+    if (!temporal)
+      temporal = std::make_unique<TemporalCache>();
+    if (temporal->begin(scene, options, fb.width, fb.height, viewProj))
+      frameTemporal = temporal.get();
+  } else if (temporal) {
+    temporal->invalidate();
+  }
+
+  RENDER_STAT_TIMER(binStart);
+  binTriangles(tilesX, tilesY, tileSize);
+  assignLightsToTiles(scene, fb, options, tilesX, tilesY, tileSize);
+#ifdef RENDER_ENABLE_STATS
+  stats.binMs = statsSeconds(binStart) * 1000.0;
+#endif
+  RENDER_STAT_TIMER(rasterStart);
+
+  tileStats = arena.array(static_cast<size_t>(tilesX) * tilesY, TileStats{});
+  pool.parallelFor(
+      tilesX * tilesY,
+      [&](int t) {
+        if (binOffset[t] == binOffset[t + 1] || (region && !tileMask[t]))
+          return;
+        int tx = t % tilesX, ty = t / tilesX;
+        PixelRect rect{tx * tileSize, ty * tileSize,
+                       std::min(fb.width, (tx + 1) * tileSize),
+                       std::min(fb.height, (ty + 1) * tileSize)};
+        RENDER_STAT_SINK(&tileStats[t].pipeline);
+        rasterizeTile(fb, t, rect, options, tileStats[t]);
+        RENDER_STAT_SINK(nullptr);
+      },
+      options.tiled ? options.numThreads : 1);
+#ifdef RENDER_ENABLE_STATS
+  double rasterMs = statsSeconds(rasterStart) * 1000.0;
+#endif
+
+  // Tempos medidos acima ficam; o resto e refeito a cada frame
+  RenderStats frame;
+  FrameCounters &counters = frame.counters;
+  counters.cubesSubmitted = static_cast<long long>(scene.cubes.size());
+  counters.cubesDrawn = instances.count;
+  for (int c = 0; c < numChunks; ++c)
+    counters.trianglesRasterized += chunkTriangles[c].size();
+  counters.arenaBytes = static_cast<long long>(arena.bytesUsed());
+  counters.arenaHeapAllocations = arena.heapAllocations();
+  counters.shadowFacesRendered = shadowFaces;
+  for (const auto &t : tileStats) {
+    frame.occlusion.cubeTests += t.occlusion.cubeTests;
+    frame.occlusion.cubesRejected += t.occlusion.cubesRejected;
+    frame.occlusion.trianglesSkipped += t.occlusion.trianglesSkipped;
+    counters.depthPasses += t.depthPasses;
+    counters.fragmentsShaded += t.fragmentsShaded;
+    counters.temporalReused += t.temporalReused;
+  }
+
+#ifdef RENDER_ENABLE_STATS
+  for (const auto &c : chunkStats)
+    frame.pipeline.add(c);
+  for (const auto &t : tileStats)
+    frame.pipeline.add(t.pipeline);
+  // Com MSAA: pixels com geometria em alguma amostra
+  for (size_t p = 0; p < fb.depth.size(); p += fb.samples) {
+    bool covered = false;
+    for (int k = 0; k < fb.samples; ++k)
+      covered |= fb.depth[p + k] > DEPTH_CLEAR;
+    frame.pixelsWithGeometry += covered;
+  }
+  if (frame.pixelsWithGeometry > 0)
+    frame.overdraw = static_cast<double>(counters.depthPasses) /
+                     frame.pixelsWithGeometry;
+  frame.cullMs = stats.cullMs;
+  frame.transformMs = stats.transformMs;
+  frame.binMs = stats.binMs;
+  frame.shadowMs = shadowMs;
+  frame.rasterMs = rasterMs;
+  frame.shadeMs = frame.pipeline.shadeSeconds * 1000.0;
+  frame.totalMs = statsSeconds(frameStart) * 1000.0;
+#endif
+  stats = frame;
+}
@@ -0,0 +1,243 @@
+#pragma once
+#include "../core/BVH.h"
+#include "FrameArena.h"
+#include "InstanceBatch.h"
+#include "Rasterizer.h"
+#include "RenderStats.h"
+#include "ThreadPool.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class ShadowMapCache;
+class TemporalCache;
+
+// Etapa em espaco mundo de uma cena, independente da camera: BVH dos
+// cubos, lote com cantos e normais de todos os cubos (instancia = indice do
+// cubo) e vertices/normais das malhas em mundo. Calculada uma vez e so lida
+// pelos Renderers de varias vistas ao mesmo tempo (MultiViewRenderer).
+// Guarda ponteiros para as malhas: vale enquanto a cena nao mudar. Entre
+// chamadas de build a BVH so e reajustada (reconstruida quando o numero de
+// cubos muda).
+struct WorldStage {
+  CubeBVH bvh;
+  CubeInstanceBatch cubes;
+  std::vector<size_t> meshFirstVertex; // por malha da cena
+  std::vector<Vec3> meshWorld, meshNormals;
+  // Shadow maps da cena (RenderOptions::shadows), atualizados por quem
+  // monta a etapa; nullptr sem sombras
+  const ShadowMapCache *shadows{nullptr};
+
+  void build(const Scene &scene, ThreadPool &pool = ThreadPool::global());
+};
+
+// Renderizador em tiles.
+// 0. Culling: BVH sobre os cubos descarta os que estao fora do frustum
+// 1. Geometria: lote SoA de instancias (view-projection uma vez por frame)
+//    -> triangulos em tela, em blocos de instancias processados em paralelo
+//    (ordem de submissao preservada); triangulos que cruzam o plano near
+//    sao recortados em clip space. Com occlusion culling os cubos entram
+//    da frente para tras. Malhas (depois dos cubos) passam pelo frustum
+//    inteiras; os vertices das visiveis sao transformados uma vez por frame
+//    (cache pos-transformacao) e os triangulos, montados por indice em
+//    blocos paralelos
+// 2. Binning: cada triangulo entra na lista dos tiles que seu bbox toca
+// 3. Raster: threads do pool processam tiles inteiros; cada tile e dono da
+//    sua fatia de color/depth, entao nao ha escrita concorrente no mesmo pixel
+//    Com occlusion culling, antes dos triangulos de cada cubo o tile compara
+//    a profundidade mais proxima do cubo com o Hi-Z (8x8 e do tile inteiro)
+//    Luzes com alcance sao distribuidas nos tiles que sua esfera pode tocar;
+//    cada tile sombreia so com a sua lista, filtrada tambem em mundo pela
+//    caixa de cada triangulo (direto) ou dos pixels visiveis de cada bloco
+//    8x8 (deferred)
+//    No modo deferred o tile rasteriza para um G-buffer proprio da thread e
+//    em seguida sombreia cada pixel visivel uma vez (resolve)
+// Como cada tile percorre seus triangulos na ordem de submissao, o resultado
+// e identico pixel a pixel ao caminho serial.
+//
+// Com sombras (RenderOptions::shadows) os shadow maps das luzes ficam num
+// ShadowMapCache do Renderer (ou da WorldStage, no multi-view), atualizado
+// antes da geometria; o shading consulta o mapa de cada luz por fragmento
+// (por face no flat). Com RenderOptions::temporal o resolve do deferred
+// reaproveita o difuso do frame anterior (TemporalCache).
+//
+// O Renderer guarda os buffers de trabalho entre frames (evita realocacao).
+// O que muda de forma a cada frame (listas por tile de triangulos e luzes,
+// mascara de tiles, contadores por tile) sai de uma FrameArena zerada no
+// inicio do frame; depois do aquecimento um frame nao aloca no heap.
+// Uma instancia nao deve ser usada por duas threads ao mesmo tempo.
+class Renderer {
+public:
+  // Re-render parcial: so os tiles que tocam algum retangulo sao limpos com
+  // `clearColor` e redesenhados; o resto do framebuffer fica como esta.
+  // Como cada tile e independente, esses tiles ficam identicos aos de um
+  // render completo da mesma cena.
+  struct DirtyRegion {
+    std::vector<PixelRect> rects;
+    uint32_t clearColor;
+  };
+
+  explicit Renderer(ThreadPool &pool = ThreadPool::global());
+  ~Renderer();
+
+  // Com `region`, redesenha so a regiao (ver DirtyRegion).
+  // A BVH dos cubos fica entre frames: com o mesmo numero de cubos so as
+  // caixas sao reajustadas. `changedCubes` (opcional): indices dos unicos
+  // cubos que mudaram desde o render anterior deste Renderer, na mesma
+  // cena; so as caixas deles sao refeitas.
+  void render(const Scene &scene, Framebuffer &fb,
+              const RenderOptions &options,
+              const DirtyRegion *region = nullptr,
+              const std::vector<int> *changedCubes = nullptr);
+  // Uma vista: `camera` no lugar de scene.camera e a parte em mundo lida
+  // de `world` (ja construido para esta cena). Mesma imagem de render()
+  // com essa camera. Varios Renderers podem usar o mesmo `world` em
+  // paralelo.
+  void render(const Scene &scene, const Camera &camera,
+              const WorldStage &world, Framebuffer &fb,
+              const RenderOptions &options);
+
+  const OcclusionStats &occlusionStats() const { return stats.occlusion; }
+  const FrameCounters &frameCounters() const { return stats.counters; }
+  // Contadores e tempos detalhados so com RENDER_ENABLE_STATS
+  const RenderStats &renderStats() const { return stats; }
+  // Pixels limpos e redesenhados no ultimo render
+  long long redrawnPixels() const { return redrawn; }
+
+private:
+  // Retangulo de tela e profundidade mais proxima de uma instancia, para o
+  // teste de oclusao. testable = falso se o cubo cruza o plano near.
+  struct InstanceBounds {
+    int minX, minY, maxX, maxY;
+    double nearest;
+    bool testable;
+  };
+
+  // Contadores de um tile, somados no fim do frame
+  struct TileStats {
+    OcclusionStats occlusion;
+    long long depthPasses{0};
+    long long fragmentsShaded{0};
+    long long temporalReused{0};
+    PipelineCounters pipeline; // so com RENDER_ENABLE_STATS
+  };
+
+  // Instancias por bloco da etapa de geometria; 4096 cubos geram no maximo
+  // 49152 triangulos, que cabem nos 16 bits baixos do id do triangulo
+  static constexpr int INSTANCE_CHUNK = 4096;
+  static constexpr int TRIANGLE_ID_BITS = 16;
+  // Triangulos de malha por bloco: o recorte no near gera ate 2 de cada,
+  // entao 32768 tambem cabem nos 16 bits
+  static constexpr int MESH_CHUNK = 32768;
+  // Vertices de malha por tarefa da transformacao
+  static constexpr int MESH_VERTEX_CHUNK = 16384;
+
+  // Vertice de malha ja transformado (cache pos-transformacao): todos os
+  // triangulos que o compartilham leem daqui
+  struct MeshVertex {
+    Vertex vertex; // screen so vale na frente do near (sem OUT_NEAR)
+    double clipX, clipY, clipW;
+    unsigned outcode; // semi-espacos do frustum de que o vertice esta fora
+  };
+  static constexpr unsigned OUT_NEAR = 1u << 4;
+
+  // Malha que passou no frustum culling
+  struct VisibleMesh {
+    int mesh;           // indice em scene.meshes
+    int instance;       // id de instancia (depois dos cubos do lote)
+    size_t firstVertex; // inicio em meshVertices
+    Mat4 model;
+  };
+  // Intervalo [begin, end) de vertices ou triangulos de uma malha visivel
+  struct MeshRange {
+    int visible;
+    int begin, end;
+  };
+
+  void renderFrame(const Scene &scene, Framebuffer &fb,
+                   const RenderOptions &options, const DirtyRegion *region);
+  void buildTriangles(const Scene &scene, const Framebuffer &fb,
+                      const RenderOptions &options, const PixelRect *cullRect);
+  void sortFrontToBack(const Scene &scene, const std::vector<int> *indices);
+  void assembleCube(const Scene &scene, int i, const Mat4 &proj,
+                    const Framebuffer &fb, bool usePhong,
+                    std::vector<RasterTriangle> &out,
+                    InstanceBounds &bounds) const;
+  void cullMeshes(const Scene &scene, const Frustum *frustum,
+                  const Mat4 &proj, const Framebuffer &fb);
+  void transformMesh(const Scene &scene, const MeshRange &range,
+                     const Mat4 &proj, const Framebuffer &fb);
+  void assembleMesh(const Scene &scene, const MeshRange &range,
+                    const Mat4 &proj, const Framebuffer &fb, bool usePhong,
+                    std::vector<RasterTriangle> &out) const;
+  void emitTriangle(RasterTriangle &tri, const Scene &scene,
+                    const Material &material, const Framebuffer &fb,
+                    bool usePhong, std::vector<RasterTriangle> &out) const;
+  void binTriangles(int tilesX, int tilesY, int tileSize);
+  void assignLightsToTiles(const Scene &scene, const Framebuffer &fb,
+                           const RenderOptions &options, int tilesX,
+                           int tilesY, int tileSize);
+  void selectLights(FrameSpan<const int> from, const AABB &box,
+                    std::vector<int> &out) const;
+  const ShadingContext &triangleShading(int tile,
+                                        const RasterTriangle &tri) const;
+  void rasterizeTile(Framebuffer &fb, int tile, const PixelRect &rect,
+                     const RenderOptions &options, TileStats &tileStats) const;
+  bool occluded(const Framebuffer &fb, const InstanceBounds &bounds,
+                const PixelRect &rect, DepthValue tileFarthest) const;
+  int resolveTile(Framebuffer &fb, const GBuffer &gbuffer, int tile,
+                  long long &temporalReused) const;
+
+  // id = (bloco << TRIANGLE_ID_BITS) | indice dentro do bloco
+  const RasterTriangle &triangle(uint32_t id) const {
+    return chunkTriangles[id >> TRIANGLE_ID_BITS]
+                         [id & ((1u << TRIANGLE_ID_BITS) - 1)];
+  }
+  // Ids de triangulos e indices de luzes de um tile
+  FrameSpan<const uint32_t> bin(int tile) const {
+    return {binIds + binOffset[tile], binOffset[tile + 1] - binOffset[tile]};
+  }
+  FrameSpan<const int> lightsOfTile(int tile) const {
+    return {tileLightIds + tileLightOffset[tile],
+            tileLightOffset[tile + 1] - tileLightOffset[tile]};
+  }
+
+  ThreadPool &pool;
+  const Camera *frameCamera{nullptr}; // camera do frame atual
+  const WorldStage *world{nullptr};  // etapa em mundo compartilhada
+  CubeBVH bvh;
+  bool bvhCurrent{false}; // bvh acompanhou a cena no render anterior
+  const std::vector<int> *cubeChanges{nullptr}; // do render atual
+  CubeBVH::CullScratch cullScratch;
+  std::vector<int> visibleCubes; // cubos que passaram no frustum culling
+  std::vector<std::pair<double, int>> depthOrder; // (profundidade, cubo)
+  CubeInstanceBatch instances;
+  std::vector<VisibleMesh> visibleMeshes;
+  std::vector<MeshVertex> meshVertices; // das malhas visiveis, em sequencia
+  std::vector<MeshRange> meshVertexJobs, meshChunks;
+  // Por instancia: cubos do lote e depois malhas visiveis
+  std::vector<InstanceBounds> instanceBounds;
+  std::vector<const Material *> instanceMaterials; // ids do G-buffer
+  int numCubeChunks{0};
+  int numChunks{0}; // blocos de cubos e depois blocos de malhas
+  std::vector<std::vector<RasterTriangle>> chunkTriangles; // por bloco
+  Mat4 viewProj;                            // view * projection do frame
+  ShadingContext shading;                   // luzes/olho do frame atual
+  std::unique_ptr<ShadowMapCache> shadowCache; // criado com a 1a sombra
+  std::unique_ptr<TemporalCache> temporal;     // criado no 1o frame temporal
+  TemporalCache *frameTemporal{nullptr}; // usado neste frame (ou nullptr)
+  bool cullLights{false}; // alguma luz tem alcance: listas por tile
+  std::vector<PipelineCounters> chunkStats; // por bloco (RENDER_ENABLE_STATS)
+
+  // Na arena (validos ate o proximo frame). Listas por tile em CSR: as do
+  // tile t ficam em [start[t], start[t + 1])
+  FrameArena arena;
+  size_t *binOffset{nullptr};  // numTiles + 1
+  uint32_t *binIds{nullptr};  // ids de triangulos, tile a tile
+  size_t *tileLightOffset{nullptr};
+  int *tileLightIds{nullptr}; // indices de luzes, tile a tile
+  FrameSpan<uint8_t> tileMask;     // tiles redesenhados (parcial)
+  FrameSpan<TileStats> tileStats;  // somados em `stats`
+  RenderStats stats;
+  long long redrawn{0};
+};
@@ -1,10 +1,11 @@
 #include "Shading.h"
+#include "Shadows.h"
 #include <algorithm>
 #include <cmath>
 
 // Flat shading: usa normal da face, calcula iluminação uma vez
 Vec3 flatShading(const Vec3 &normal, const Vec3 &position, const Material &mat,
-                 const Light &light, const Vec3 &eyePos) {
+                 const Light &light, const Vec3 &eyePos, double visibility) {
   Vec3 N = normal.normalized();
   Vec3 L = (light.position - position).normalized();
   Vec3 V = (eyePos - position).normalized();
@@ -15,11 +16,11 @@ Vec3 flatShading(const Vec3 &normal, const Vec3 &position, const Material &mat,
 
   // Componente difusa (Lambert)
   double diff = std::max(0.0, N.dot(L));
-  Vec3 diffuse = mat.color * (mat.kd * diff);
+  Vec3 diffuse = mat.color * (mat.kd * diff * visibility);
 
   // Componente especular (Blinn-Phong)
   double spec = std::pow(std::max(0.0, R.dot(V)), mat.shininess);
-  Vec3 specular = light.color * (mat.ks * spec);
+  Vec3 specular = light.color * (mat.ks * spec * visibility);
 
   // Soma das contribuições (multiplicar por intensidade da luz)
   Vec3 result = ambient + diffuse + specular;
@@ -34,24 +35,35 @@ Vec3 flatShading(const Vec3 &normal, const Vec3 &position, const Material &mat,
 
 // Phong shading: interpola normais e calcula iluminação por pixel
 Vec3 phongShading(const Vec3 &normal, const Vec3 &position, const Material &mat,
-                  const Light &light, const Vec3 &eyePos) {
+                  const Light &light, const Vec3 &eyePos, double visibility) {
   // Mesma lógica do flat, mas será chamado por pixel
   // com normais interpoladas baricêntricamente
-  return flatShading(normal, position, mat, light, eyePos);
+  return flatShading(normal, position, mat, light, eyePos, visibility);
 }
 
 // Versão com múltiplas luzes
 Vec3 computeLighting(const Vec3 &normal, const Vec3 &position,
                      const Material &mat, const std::vector<Light> &lights,
-                     const Vec3 &eyePos, bool usePhong) {
+                     const Vec3 &eyePos, bool usePhong,
+                     const CubeShadowMap *const *shadows) {
   Vec3 color{0, 0, 0};
 
-  // Acumular contribuição de cada luz
-  for (const auto &light : lights) {
+  // Acumular contribuição de cada luz (atenuada pelo alcance)
+  for (size_t l = 0; l < lights.size(); ++l) {
+    const Light &light = lights[l];
+    double att = light.attenuation(position);
+    if (att == 0.0)
+      continue; // fora do alcance
+    // Sombra: uma consulta ao shadow map por chamada (no flat, por face)
+    double visibility = 1.0;
+    if (shadows && shadows[l])
+      visibility = shadows[l]->visibility(position, normal.normalized());
     if (usePhong) {
-      color += phongShading(normal, position, mat, light, eyePos);
+      color +=
+          phongShading(normal, position, mat, light, eyePos, visibility) * att;
     } else {
-      color += flatShading(normal, position, mat, light, eyePos);
+      color +=
+          flatShading(normal, position, mat, light, eyePos, visibility) * att;
     }
   }
 
@@ -4,15 +4,22 @@
 #include "../math/Vector.h"
 #include <vector>
 
-// Flat shading: usa normal da face
+struct CubeShadowMap;
+
+// Flat shading: usa normal da face. `visibility` (shadow map) escala os
+// termos difuso e especular.
 Vec3 flatShading(const Vec3 &normal, const Vec3 &position, const Material &mat,
-                 const Light &light, const Vec3 &eyePos);
+                 const Light &light, const Vec3 &eyePos,
+                 double visibility = 1.0);
 
 // Phong shading: interpola normais por pixel
 Vec3 phongShading(const Vec3 &normal, const Vec3 &position, const Material &mat,
-                  const Light &light, const Vec3 &eyePos);
+                  const Light &light, const Vec3 &eyePos,
+                  double visibility = 1.0);
 
-// Versão com múltiplas luzes
+// Versão com múltiplas luzes. `shadows`: shadow map de cada luz (entradas
+// nullptr = sem sombra) ou nullptr
 Vec3 computeLighting(const Vec3 &normal, const Vec3 &position,
                      const Material &mat, const std::vector<Light> &lights,
-                     const Vec3 &eyePos, bool usePhong = false);
+                     const Vec3 &eyePos, bool usePhong = false,
+                     const CubeShadowMap *const *shadows = nullptr);
@@ -0,0 +1,762 @@
+#include "ShadingKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define RENDER_X86_SIMD 1
+#include <immintrin.h>
+// Funcoes AVX2 sao compiladas so para esse alvo; o resto do binario continua
+// rodando em qualquer x86-64
+#define AVX2_FN static inline __attribute__((target("avx2")))
+#else
+#define RENDER_X86_SIMD 0
+#endif
+
+// Corpo de cada variante (cor de um fragmento ou de um vetor deles): sempre
+// inline. Com varias variantes o GCC deixaria algumas fora de linha, e ai
+// os argumentos vetoriais passam pela pilha a cada chamada.
+#ifdef __GNUC__
+#define SHADE_FN static inline __attribute__((always_inline))
+#else
+#define SHADE_FN static inline
+#endif
+
+// ============ PREPARACAO ============
+
+void LightSoA::assign(const std::vector<Light> &lights) {
+  count = static_cast<int>(lights.size());
+  for (auto *v : {&px, &py, &pz, &r, &g, &b, &invRange2})
+    v->resize(count);
+  for (int i = 0; i < count; ++i) {
+    px[i] = lights[i].position.x;
+    py[i] = lights[i].position.y;
+    pz[i] = lights[i].position.z;
+    r[i] = lights[i].color.x;
+    g[i] = lights[i].color.y;
+    b[i] = lights[i].color.z;
+    invRange2[i] = lights[i].invRange2();
+  }
+  shadowMap.assign(count, nullptr);
+  anyShadow = false;
+}
+
+void LightSoA::gather(const LightSoA &from, const std::vector<int> &indices) {
+  count = static_cast<int>(indices.size());
+  for (auto *v : {&px, &py, &pz, &r, &g, &b, &invRange2})
+    v->resize(count);
+  for (int i = 0; i < count; ++i) {
+    int l = indices[i];
+    px[i] = from.px[l];
+    py[i] = from.py[l];
+    pz[i] = from.pz[l];
+    r[i] = from.r[l];
+    g[i] = from.g[l];
+    b[i] = from.b[l];
+    invRange2[i] = from.invRange2[l];
+  }
+  shadowMap.resize(count);
+  anyShadow = false;
+  if (from.anyShadow)
+    for (int i = 0; i < count; ++i) {
+      shadowMap[i] = from.shadowMap[indices[i]];
+      anyShadow |= shadowMap[i] != nullptr;
+    }
+  else
+    std::fill(shadowMap.begin(), shadowMap.end(), nullptr);
+}
+
+void setupPhongPacket(PhongPacketSetup &setup, const Material &mat,
+                      const ShadingContext &ctx) {
+  setup.color[0] = mat.color.x;
+  setup.color[1] = mat.color.y;
+  setup.color[2] = mat.color.z;
+  setup.ka = mat.ka;
+  setup.kd = mat.kd;
+  setup.ks = mat.ks;
+  setup.shininess = mat.shininess;
+  // Expoente inteiro pequeno: potencia por multiplicacoes (vetorizavel)
+  setup.intShininess = -1;
+  if (mat.shininess >= 0.0 && mat.shininess <= 256.0 &&
+      mat.shininess == std::floor(mat.shininess))
+    setup.intShininess = static_cast<int>(mat.shininess);
+  setup.eye[0] = ctx.eyePos.x;
+  setup.eye[1] = ctx.eyePos.y;
+  setup.eye[2] = ctx.eyePos.z;
+  setup.lights = &ctx.lightSoA;
+  setup.shadow = nullptr;
+  setup.diffuse = nullptr;
+  setup.diffuseOut = nullptr;
+}
+
+// ============ VARIANTES ============
+// Cada kernel e instanciado para NL luzes fixas (1..MAX_FIXED_LIGHTS; 0 =
+// quantidade qualquer) e para o expoente: SHINY >= 0 e o proprio expoente
+// inteiro, fixo na compilacao; SHINY_INT e um inteiro qualquer (ainda por
+// multiplicacoes) e SHINY_REAL usa std::pow. As operacoes e a ordem sao as
+// mesmas em todas as variantes, entao a cor nao muda.
+
+constexpr int MAX_FIXED_LIGHTS = 4;
+constexpr int SHINY_INT = -1;
+constexpr int SHINY_REAL = -2;
+// Expoente especializado: o padrao do Material e da API C
+constexpr int FIXED_SHININESS = 32;
+
+// x^n por quadrados sucessivos (mesma sequencia em todos os kernels)
+static inline double powInt(double x, int n) {
+  double r = 1.0;
+  while (n) {
+    if (n & 1)
+      r *= x;
+    x *= x;
+    n >>= 1;
+  }
+  return r;
+}
+
+// x^N com N conhecido na compilacao: a mesma sequencia de powInt,
+// desenrolada em multiplicacoes
+template <int N> static inline double powFixed(double r, double x) {
+  if constexpr (N == 0) {
+    return r;
+  } else {
+    if constexpr ((N & 1) != 0)
+      r *= x;
+    return powFixed<(N >> 1)>(r, x * x);
+  }
+}
+
+// Termo especular rv^shininess da variante SHINY
+template <int SHINY>
+static inline double specularPow(const PhongPacketSetup &s, double rv) {
+  if constexpr (SHINY >= 0)
+    return powFixed<SHINY>(1.0, rv);
+  else if constexpr (SHINY == SHINY_INT)
+    return powInt(rv, s.intShininess);
+  else
+    return std::pow(rv, s.shininess);
+}
+
+static inline uint32_t packChannels(double r, double g, double b) {
+  return 0xff000000 | (static_cast<uint32_t>(r * 255.0) << 16) |
+         (static_cast<uint32_t>(g * 255.0) << 8) |
+         static_cast<uint32_t>(b * 255.0);
+}
+
+// ============ KERNEL ESCALAR ============
+// Referencia: mesma sequencia de operacoes de computeLighting/phongShading
+
+// Cor de um fragmento ja interpolado (normal normalizada, posicao no mundo).
+// vis: visibilidade das luzes no fragmento (vis[l * PHONG_PACKET_SIZE]) ou
+// nullptr; multiplicar por 1 nao muda o resultado. dIn/dOut: termos
+// ambiente + difuso do fragmento (PhongPacketSetup::diffuse/diffuseOut) ou
+// nullptr.
+template <int NL, int SHINY>
+SHADE_FN uint32_t shadeScalar(const PhongPacketSetup &s, double nx,
+                                   double ny, double nz, double px, double py,
+                                   double pz, const double *vis,
+                                   const double *dIn, double *dOut) {
+  const LightSoA &L = *s.lights;
+  const int lightCount = NL > 0 ? NL : L.count;
+  double vx = s.eye[0] - px, vy = s.eye[1] - py, vz = s.eye[2] - pz;
+  normalizeFragment(vx, vy, vz);
+
+  double cr = 0, cg = 0, cb = 0;
+  for (int l = 0; l < lightCount; ++l) {
+    double lx = L.px[l] - px, ly = L.py[l] - py, lz = L.pz[l] - pz;
+    double att = rangeAttenuation(lx * lx + ly * ly + lz * lz, L.invRange2[l]);
+    normalizeFragment(lx, ly, lz);
+    double ndl = nx * lx + ny * ly + nz * lz;
+    double t = 2.0 * ndl;
+    double rx = nx * t - lx, ry = ny * t - ly, rz = nz * t - lz;
+
+    double diff = std::max(0.0, ndl);
+    double rv = std::max(0.0, rx * vx + ry * vy + rz * vz);
+    double spec = specularPow<SHINY>(s, rv);
+    double kdDiff = s.kd * diff, ksSpec = s.ks * spec;
+    if (vis) {
+      kdDiff *= vis[l * PHONG_PACKET_SIZE];
+      ksSpec *= vis[l * PHONG_PACKET_SIZE];
+    }
+
+    double dr = s.color[0] * s.ka + s.color[0] * kdDiff;
+    double dg = s.color[1] * s.ka + s.color[1] * kdDiff;
+    double db = s.color[2] * s.ka + s.color[2] * kdDiff;
+    if (dIn) {
+      dr = dIn[(l * 3 + 0) * PHONG_PACKET_SIZE];
+      dg = dIn[(l * 3 + 1) * PHONG_PACKET_SIZE];
+      db = dIn[(l * 3 + 2) * PHONG_PACKET_SIZE];
+    }
+    if (dOut) {
+      dOut[(l * 3 + 0) * PHONG_PACKET_SIZE] = dr;
+      dOut[(l * 3 + 1) * PHONG_PACKET_SIZE] = dg;
+      dOut[(l * 3 + 2) * PHONG_PACKET_SIZE] = db;
+    }
+
+    cr += std::clamp(dr + L.r[l] * ksSpec, 0.0, 1.0) * att;
+    cg += std::clamp(dg + L.g[l] * ksSpec, 0.0, 1.0) * att;
+    cb += std::clamp(db + L.b[l] * ksSpec, 0.0, 1.0) * att;
+  }
+  return packChannels(std::clamp(cr, 0.0, 1.0), std::clamp(cg, 0.0, 1.0),
+                      std::clamp(cb, 0.0, 1.0));
+}
+
+template <int NL, int SHINY>
+static void phongPacketScalar(const PhongPacketSetup &s, const double *u,
+                              const double *v, const double *w, int count,
+                              uint32_t *out) {
+  for (int i = 0; i < count; ++i) {
+    double n[3], p[3];
+    phongInterpolate(s, u[i], v[i], w[i], n, p);
+    out[i] = shadeScalar<NL, SHINY>(s, n[0], n[1], n[2], p[0], p[1], p[2],
+                                    s.shadow ? s.shadow + i : nullptr,
+                                    nullptr, nullptr);
+  }
+}
+
+template <int NL, int SHINY>
+static void phongShadeScalar(const PhongPacketSetup &s, const double *nx,
+                             const double *ny, const double *nz,
+                             const double *px, const double *py,
+                             const double *pz, int count, uint32_t *out) {
+  for (int i = 0; i < count; ++i)
+    out[i] = shadeScalar<NL, SHINY>(
+        s, nx[i], ny[i], nz[i], px[i], py[i], pz[i],
+        s.shadow ? s.shadow + i : nullptr, s.diffuse ? s.diffuse + i : nullptr,
+        s.diffuseOut ? s.diffuseOut + i : nullptr);
+}
+
+struct ScalarKernels {
+  static constexpr const char *name = "scalar";
+  template <int NL, int SHINY>
+  static constexpr PhongPacketFn packet = phongPacketScalar<NL, SHINY>;
+  template <int NL, int SHINY>
+  static constexpr PhongShadeFn shade = phongShadeScalar<NL, SHINY>;
+};
+
+#if RENDER_X86_SIMD
+
+// ============ KERNEL SSE2 (2 doubles) ============
+
+static inline __m128d sseNormalizeLen(__m128d x, __m128d y, __m128d z) {
+  return _mm_sqrt_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(x, x), _mm_mul_pd(y, y)),
+                                _mm_mul_pd(z, z)));
+}
+
+static inline void sseNormalize(__m128d &x, __m128d &y, __m128d &z) {
+  __m128d len = sseNormalizeLen(x, y, z);
+  __m128d isZero = _mm_cmpeq_pd(len, _mm_setzero_pd());
+  x = _mm_or_pd(_mm_and_pd(isZero, x), _mm_andnot_pd(isZero, _mm_div_pd(x, len)));
+  y = _mm_or_pd(_mm_and_pd(isZero, y), _mm_andnot_pd(isZero, _mm_div_pd(y, len)));
+  z = _mm_or_pd(_mm_and_pd(isZero, z), _mm_andnot_pd(isZero, _mm_div_pd(z, len)));
+}
+
+static inline __m128d sseLerp3(const double *a, __m128d u, __m128d v,
+                               __m128d w) {
+  return _mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_set1_pd(a[0]), u),
+                               _mm_mul_pd(_mm_set1_pd(a[1]), v)),
+                    _mm_mul_pd(_mm_set1_pd(a[2]), w));
+}
+
+static inline __m128d sseClamp01(__m128d x) {
+  return _mm_min_pd(_mm_max_pd(x, _mm_setzero_pd()), _mm_set1_pd(1.0));
+}
+
+template <int N> static inline __m128d ssePowFixed(__m128d r, __m128d x) {
+  if constexpr (N == 0) {
+    return r;
+  } else {
+    if constexpr ((N & 1) != 0)
+      r = _mm_mul_pd(r, x);
+    return ssePowFixed<(N >> 1)>(r, _mm_mul_pd(x, x));
+  }
+}
+
+template <int SHINY>
+static inline __m128d sseSpecularPow(const PhongPacketSetup &s, __m128d rv) {
+  if constexpr (SHINY >= 0) {
+    return ssePowFixed<SHINY>(_mm_set1_pd(1.0), rv);
+  } else if constexpr (SHINY == SHINY_INT) {
+    __m128d spec = _mm_set1_pd(1.0);
+    __m128d base = rv;
+    for (int n = s.intShininess; n; n >>= 1) {
+      if (n & 1)
+        spec = _mm_mul_pd(spec, base);
+      base = _mm_mul_pd(base, base);
+    }
+    return spec;
+  } else {
+    alignas(16) double tmp[2];
+    _mm_store_pd(tmp, rv);
+    return _mm_set_pd(std::pow(tmp[1], s.shininess),
+                      std::pow(tmp[0], s.shininess));
+  }
+}
+
+// Cor de 2 fragmentos ja interpolados, em ARGB nas 2 lanes baixas. vis,
+// dIn e dOut dos 2 fragmentos ou nullptr (como no escalar)
+template <int NL, int SHINY>
+SHADE_FN __m128i sseShade(const PhongPacketSetup &s, __m128d nx,
+                               __m128d ny, __m128d nz, __m128d px,
+                               __m128d py, __m128d pz, const double *vis,
+                               const double *dIn, double *dOut) {
+  const LightSoA &L = *s.lights;
+  const int lightCount = NL > 0 ? NL : L.count;
+  const __m128d zero = _mm_setzero_pd();
+  const __m128d one = _mm_set1_pd(1.0), two = _mm_set1_pd(2.0);
+  const __m128d ka = _mm_set1_pd(s.ka), kd = _mm_set1_pd(s.kd),
+                ks = _mm_set1_pd(s.ks);
+  const __m128d matR = _mm_set1_pd(s.color[0]), matG = _mm_set1_pd(s.color[1]),
+                matB = _mm_set1_pd(s.color[2]);
+
+  __m128d vx = _mm_sub_pd(_mm_set1_pd(s.eye[0]), px);
+  __m128d vy = _mm_sub_pd(_mm_set1_pd(s.eye[1]), py);
+  __m128d vz = _mm_sub_pd(_mm_set1_pd(s.eye[2]), pz);
+  sseNormalize(vx, vy, vz);
+
+  __m128d cr = zero, cg = zero, cb = zero;
+  for (int l = 0; l < lightCount; ++l) {
+    __m128d lx = _mm_sub_pd(_mm_set1_pd(L.px[l]), px);
+    __m128d ly = _mm_sub_pd(_mm_set1_pd(L.py[l]), py);
+    __m128d lz = _mm_sub_pd(_mm_set1_pd(L.pz[l]), pz);
+    __m128d d2 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(lx, lx), _mm_mul_pd(ly, ly)),
+                            _mm_mul_pd(lz, lz));
+    __m128d f = _mm_max_pd(
+        _mm_sub_pd(one, _mm_mul_pd(d2, _mm_set1_pd(L.invRange2[l]))), zero);
+    __m128d att = _mm_mul_pd(f, f);
+    sseNormalize(lx, ly, lz);
+    __m128d ndl = _mm_add_pd(
+        _mm_add_pd(_mm_mul_pd(nx, lx), _mm_mul_pd(ny, ly)), _mm_mul_pd(nz, lz));
+    __m128d t = _mm_mul_pd(two, ndl);
+    __m128d rx = _mm_sub_pd(_mm_mul_pd(nx, t), lx);
+    __m128d ry = _mm_sub_pd(_mm_mul_pd(ny, t), ly);
+    __m128d rz = _mm_sub_pd(_mm_mul_pd(nz, t), lz);
+
+    __m128d diff = _mm_max_pd(ndl, zero);
+    __m128d rv = _mm_max_pd(
+        _mm_add_pd(_mm_add_pd(_mm_mul_pd(rx, vx), _mm_mul_pd(ry, vy)),
+                   _mm_mul_pd(rz, vz)),
+        zero);
+    __m128d spec = sseSpecularPow<SHINY>(s, rv);
+    __m128d kdDiff = _mm_mul_pd(kd, diff), ksSpec = _mm_mul_pd(ks, spec);
+    if (vis) {
+      __m128d visible = _mm_loadu_pd(vis + l * PHONG_PACKET_SIZE);
+      kdDiff = _mm_mul_pd(kdDiff, visible);
+      ksSpec = _mm_mul_pd(ksSpec, visible);
+    }
+
+    __m128d dr =
+        _mm_add_pd(_mm_mul_pd(matR, ka), _mm_mul_pd(matR, kdDiff));
+    __m128d dg =
+        _mm_add_pd(_mm_mul_pd(matG, ka), _mm_mul_pd(matG, kdDiff));
+    __m128d db =
+        _mm_add_pd(_mm_mul_pd(matB, ka), _mm_mul_pd(matB, kdDiff));
+    if (dIn) {
+      dr = _mm_loadu_pd(dIn + (l * 3 + 0) * PHONG_PACKET_SIZE);
+      dg = _mm_loadu_pd(dIn + (l * 3 + 1) * PHONG_PACKET_SIZE);
+      db = _mm_loadu_pd(dIn + (l * 3 + 2) * PHONG_PACKET_SIZE);
+    }
+    if (dOut) {
+      _mm_storeu_pd(dOut + (l * 3 + 0) * PHONG_PACKET_SIZE, dr);
+      _mm_storeu_pd(dOut + (l * 3 + 1) * PHONG_PACKET_SIZE, dg);
+      _mm_storeu_pd(dOut + (l * 3 + 2) * PHONG_PACKET_SIZE, db);
+    }
+
+    cr = _mm_add_pd(cr, _mm_mul_pd(sseClamp01(_mm_add_pd(
+                                dr, _mm_mul_pd(_mm_set1_pd(L.r[l]), ksSpec))),
+                            att));
+    cg = _mm_add_pd(cg, _mm_mul_pd(sseClamp01(_mm_add_pd(
+                                dg, _mm_mul_pd(_mm_set1_pd(L.g[l]), ksSpec))),
+                            att));
+    cb = _mm_add_pd(cb, _mm_mul_pd(sseClamp01(_mm_add_pd(
+                                db, _mm_mul_pd(_mm_set1_pd(L.b[l]), ksSpec))),
+                            att));
+  }
+
+  // Clamp final, *255 com truncamento e empacotamento ARGB
+  const __m128d k255 = _mm_set1_pd(255.0);
+  __m128i r8 = _mm_cvttpd_epi32(_mm_mul_pd(sseClamp01(cr), k255));
+  __m128i g8 = _mm_cvttpd_epi32(_mm_mul_pd(sseClamp01(cg), k255));
+  __m128i b8 = _mm_cvttpd_epi32(_mm_mul_pd(sseClamp01(cb), k255));
+  __m128i argb = _mm_or_si128(
+      _mm_or_si128(_mm_set1_epi32(static_cast<int>(0xff000000)),
+                   _mm_slli_epi32(r8, 16)),
+      _mm_or_si128(_mm_slli_epi32(g8, 8), b8));
+  return argb;
+}
+
+static inline void sseStore(__m128i argb, uint32_t *out, int i, int count) {
+  alignas(16) uint32_t packed[4];
+  _mm_store_si128(reinterpret_cast<__m128i *>(packed), argb);
+  out[i] = packed[0];
+  if (i + 1 < count)
+    out[i + 1] = packed[1];
+}
+
+// Lane extra repete o ultimo fragmento valido
+static inline __m128d sseLoad(const double *p, int i, int count) {
+  return _mm_set_pd(p[std::min(i + 1, count - 1)], p[i]);
+}
+
+template <int NL, int SHINY>
+static void phongPacketSse2(const PhongPacketSetup &s, const double *u,
+                            const double *v, const double *w, int count,
+                            uint32_t *out) {
+  for (int i = 0; i < count; i += 2) {
+    __m128d U = sseLoad(u, i, count);
+    __m128d V = sseLoad(v, i, count);
+    __m128d W = sseLoad(w, i, count);
+
+    __m128d nx = sseLerp3(s.nx, U, V, W);
+    __m128d ny = sseLerp3(s.ny, U, V, W);
+    __m128d nz = sseLerp3(s.nz, U, V, W);
+    sseNormalize(nx, ny, nz);
+    sseNormalize(nx, ny, nz);
+
+    __m128d px = sseLerp3(s.wx, U, V, W);
+    __m128d py = sseLerp3(s.wy, U, V, W);
+    __m128d pz = sseLerp3(s.wz, U, V, W);
+
+    sseStore(sseShade<NL, SHINY>(s, nx, ny, nz, px, py, pz,
+                                 s.shadow ? s.shadow + i : nullptr, nullptr,
+                                 nullptr),
+             out, i, count);
+  }
+}
+
+template <int NL, int SHINY>
+static void phongShadeSse2(const PhongPacketSetup &s, const double *nx,
+                           const double *ny, const double *nz,
+                           const double *px, const double *py,
+                           const double *pz, int count, uint32_t *out) {
+  for (int i = 0; i < count; i += 2)
+    sseStore(sseShade<NL, SHINY>(s, sseLoad(nx, i, count),
+                                 sseLoad(ny, i, count), sseLoad(nz, i, count),
+                                 sseLoad(px, i, count), sseLoad(py, i, count),
+                                 sseLoad(pz, i, count),
+                                 s.shadow ? s.shadow + i : nullptr,
+                                 s.diffuse ? s.diffuse + i : nullptr,
+                                 s.diffuseOut ? s.diffuseOut + i : nullptr),
+             out, i, count);
+}
+
+struct Sse2Kernels {
+  static constexpr const char *name = "sse2";
+  template <int NL, int SHINY>
+  static constexpr PhongPacketFn packet = phongPacketSse2<NL, SHINY>;
+  template <int NL, int SHINY>
+  static constexpr PhongShadeFn shade = phongShadeSse2<NL, SHINY>;
+};
+
+// ============ KERNEL AVX2 (4 doubles) ============
+
+AVX2_FN void avxNormalize(__m256d &x, __m256d &y, __m256d &z) {
+  __m256d len = _mm256_sqrt_pd(_mm256_add_pd(
+      _mm256_add_pd(_mm256_mul_pd(x, x), _mm256_mul_pd(y, y)),
+      _mm256_mul_pd(z, z)));
+  __m256d isZero = _mm256_cmp_pd(len, _mm256_setzero_pd(), _CMP_EQ_OQ);
+  x = _mm256_blendv_pd(_mm256_div_pd(x, len), x, isZero);
+  y = _mm256_blendv_pd(_mm256_div_pd(y, len), y, isZero);
+  z = _mm256_blendv_pd(_mm256_div_pd(z, len), z, isZero);
+}
+
+AVX2_FN __m256d avxLerp3(const double *a, __m256d u, __m256d v, __m256d w) {
+  return _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(a[0]), u),
+                                     _mm256_mul_pd(_mm256_set1_pd(a[1]), v)),
+                       _mm256_mul_pd(_mm256_set1_pd(a[2]), w));
+}
+
+AVX2_FN __m256d avxClamp01(__m256d x) {
+  return _mm256_min_pd(_mm256_max_pd(x, _mm256_setzero_pd()),
+                       _mm256_set1_pd(1.0));
+}
+
+AVX2_FN __m256d avxLoad(const double *p, int i, int count) {
+  // Lanes alem de count repetem o ultimo fragmento valido
+  if (i + 4 <= count)
+    return _mm256_loadu_pd(p + i);
+  alignas(32) double tmp[4];
+  for (int k = 0; k < 4; ++k)
+    tmp[k] = p[std::min(i + k, count - 1)];
+  return _mm256_load_pd(tmp);
+}
+
+template <int N> AVX2_FN __m256d avxPowFixed(__m256d r, __m256d x) {
+  if constexpr (N == 0) {
+    return r;
+  } else {
+    if constexpr ((N & 1) != 0)
+      r = _mm256_mul_pd(r, x);
+    return avxPowFixed<(N >> 1)>(r, _mm256_mul_pd(x, x));
+  }
+}
+
+template <int SHINY>
+AVX2_FN __m256d avxSpecularPow(const PhongPacketSetup &s, __m256d rv) {
+  if constexpr (SHINY >= 0) {
+    return avxPowFixed<SHINY>(_mm256_set1_pd(1.0), rv);
+  } else if constexpr (SHINY == SHINY_INT) {
+    __m256d spec = _mm256_set1_pd(1.0);
+    __m256d base = rv;
+    for (int n = s.intShininess; n; n >>= 1) {
+      if (n & 1)
+        spec = _mm256_mul_pd(spec, base);
+      base = _mm256_mul_pd(base, base);
+    }
+    return spec;
+  } else {
+    alignas(32) double tmp[4];
+    _mm256_store_pd(tmp, rv);
+    for (double &x : tmp)
+      x = std::pow(x, s.shininess);
+    return _mm256_load_pd(tmp);
+  }
+}
+
+// Cor de 4 fragmentos ja interpolados, em ARGB (vis, dIn e dOut como no
+// SSE2)
+template <int NL, int SHINY>
+SHADE_FN __attribute__((target("avx2"))) __m128i
+avxShade(const PhongPacketSetup &s, __m256d nx, __m256d ny, __m256d nz,
+         __m256d px, __m256d py, __m256d pz, const double *vis,
+         const double *dIn, double *dOut) {
+  const LightSoA &L = *s.lights;
+  const int lightCount = NL > 0 ? NL : L.count;
+  const __m256d zero = _mm256_setzero_pd();
+  const __m256d one = _mm256_set1_pd(1.0), two = _mm256_set1_pd(2.0);
+  const __m256d ka = _mm256_set1_pd(s.ka), kd = _mm256_set1_pd(s.kd),
+                ks = _mm256_set1_pd(s.ks);
+  const __m256d matR = _mm256_set1_pd(s.color[0]),
+                matG = _mm256_set1_pd(s.color[1]),
+                matB = _mm256_set1_pd(s.color[2]);
+
+  __m256d vx = _mm256_sub_pd(_mm256_set1_pd(s.eye[0]), px);
+  __m256d vy = _mm256_sub_pd(_mm256_set1_pd(s.eye[1]), py);
+  __m256d vz = _mm256_sub_pd(_mm256_set1_pd(s.eye[2]), pz);
+  avxNormalize(vx, vy, vz);
+
+  __m256d cr = zero, cg = zero, cb = zero;
+  for (int l = 0; l < lightCount; ++l) {
+    __m256d lx = _mm256_sub_pd(_mm256_set1_pd(L.px[l]), px);
+    __m256d ly = _mm256_sub_pd(_mm256_set1_pd(L.py[l]), py);
+    __m256d lz = _mm256_sub_pd(_mm256_set1_pd(L.pz[l]), pz);
+    __m256d d2 = _mm256_add_pd(
+        _mm256_add_pd(_mm256_mul_pd(lx, lx), _mm256_mul_pd(ly, ly)),
+        _mm256_mul_pd(lz, lz));
+    __m256d f = _mm256_max_pd(
+        _mm256_sub_pd(one,
+                      _mm256_mul_pd(d2, _mm256_set1_pd(L.invRange2[l]))),
+        zero);
+    __m256d att = _mm256_mul_pd(f, f);
+    avxNormalize(lx, ly, lz);
+    __m256d ndl = _mm256_add_pd(
+        _mm256_add_pd(_mm256_mul_pd(nx, lx), _mm256_mul_pd(ny, ly)),
+        _mm256_mul_pd(nz, lz));
+    __m256d t = _mm256_mul_pd(two, ndl);
+    __m256d rx = _mm256_sub_pd(_mm256_mul_pd(nx, t), lx);
+    __m256d ry = _mm256_sub_pd(_mm256_mul_pd(ny, t), ly);
+    __m256d rz = _mm256_sub_pd(_mm256_mul_pd(nz, t), lz);
+
+    __m256d diff = _mm256_max_pd(ndl, zero);
+    __m256d rv = _mm256_max_pd(
+        _mm256_add_pd(
+            _mm256_add_pd(_mm256_mul_pd(rx, vx), _mm256_mul_pd(ry, vy)),
+            _mm256_mul_pd(rz, vz)),
+        zero);
+    __m256d spec = avxSpecularPow<SHINY>(s, rv);
+    __m256d kdDiff = _mm256_mul_pd(kd, diff);
+    __m256d ksSpec = _mm256_mul_pd(ks, spec);
+    if (vis) {
+      __m256d visible = _mm256_loadu_pd(vis + l * PHONG_PACKET_SIZE);
+      kdDiff = _mm256_mul_pd(kdDiff, visible);
+      ksSpec = _mm256_mul_pd(ksSpec, visible);
+    }
+
+    __m256d dr =
+        _mm256_add_pd(_mm256_mul_pd(matR, ka), _mm256_mul_pd(matR, kdDiff));
+    __m256d dg =
+        _mm256_add_pd(_mm256_mul_pd(matG, ka), _mm256_mul_pd(matG, kdDiff));
+    __m256d db =
+        _mm256_add_pd(_mm256_mul_pd(matB, ka), _mm256_mul_pd(matB, kdDiff));
+    if (dIn) {
+      dr = _mm256_loadu_pd(dIn + (l * 3 + 0) * PHONG_PACKET_SIZE);
+      dg = _mm256_loadu_pd(dIn + (l * 3 + 1) * PHONG_PACKET_SIZE);
+      db = _mm256_loadu_pd(dIn + (l * 3 + 2) * PHONG_PACKET_SIZE);
+    }
+    if (dOut) {
+      _mm256_storeu_pd(dOut + (l * 3 + 0) * PHONG_PACKET_SIZE, dr);
+      _mm256_storeu_pd(dOut + (l * 3 + 1) * PHONG_PACKET_SIZE, dg);
+      _mm256_storeu_pd(dOut + (l * 3 + 2) * PHONG_PACKET_SIZE, db);
+    }
+
+    cr = _mm256_add_pd(
+        cr, _mm256_mul_pd(avxClamp01(_mm256_add_pd(
+                              dr, _mm256_mul_pd(_mm256_set1_pd(L.r[l]),
+                                                ksSpec))),
+                          att));
+    cg = _mm256_add_pd(
+        cg, _mm256_mul_pd(avxClamp01(_mm256_add_pd(
+                              dg, _mm256_mul_pd(_mm256_set1_pd(L.g[l]),
+                                                ksSpec))),
+                          att));
+    cb = _mm256_add_pd(
+        cb, _mm256_mul_pd(avxClamp01(_mm256_add_pd(
+                              db, _mm256_mul_pd(_mm256_set1_pd(L.b[l]),
+                                                ksSpec))),
+                          att));
+  }
+
+  // Clamp final, *255 com truncamento e empacotamento ARGB
+  const __m256d k255 = _mm256_set1_pd(255.0);
+  __m128i r8 = _mm256_cvttpd_epi32(_mm256_mul_pd(avxClamp01(cr), k255));
+  __m128i g8 = _mm256_cvttpd_epi32(_mm256_mul_pd(avxClamp01(cg), k255));
+  __m128i b8 = _mm256_cvttpd_epi32(_mm256_mul_pd(avxClamp01(cb), k255));
+  __m128i argb = _mm_or_si128(
+      _mm_or_si128(_mm_set1_epi32(static_cast<int>(0xff000000)),
+                   _mm_slli_epi32(r8, 16)),
+      _mm_or_si128(_mm_slli_epi32(g8, 8), b8));
+  return argb;
+}
+
+AVX2_FN void avxStore(__m128i argb, uint32_t *out, int i, int count) {
+  if (i + 4 <= count) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), argb);
+  } else {
+    alignas(16) uint32_t packed[4];
+    _mm_store_si128(reinterpret_cast<__m128i *>(packed), argb);
+    for (int k = 0; i + k < count; ++k)
+      out[i + k] = packed[k];
+  }
+}
+
+template <int NL, int SHINY>
+__attribute__((target("avx2"))) static void
+phongPacketAvx2(const PhongPacketSetup &s, const double *u, const double *v,
+                const double *w, int count, uint32_t *out) {
+  for (int i = 0; i < count; i += 4) {
+    __m256d U = avxLoad(u, i, count);
+    __m256d V = avxLoad(v, i, count);
+    __m256d W = avxLoad(w, i, count);
+
+    __m256d nx = avxLerp3(s.nx, U, V, W);
+    __m256d ny = avxLerp3(s.ny, U, V, W);
+    __m256d nz = avxLerp3(s.nz, U, V, W);
+    avxNormalize(nx, ny, nz);
+    avxNormalize(nx, ny, nz);
+
+    __m256d px = avxLerp3(s.wx, U, V, W);
+    __m256d py = avxLerp3(s.wy, U, V, W);
+    __m256d pz = avxLerp3(s.wz, U, V, W);
+
+    avxStore(avxShade<NL, SHINY>(s, nx, ny, nz, px, py, pz,
+                                 s.shadow ? s.shadow + i : nullptr, nullptr,
+                                 nullptr),
+             out, i, count);
+  }
+}
+
+template <int NL, int SHINY>
+__attribute__((target("avx2"))) static void
+phongShadeAvx2(const PhongPacketSetup &s, const double *nx, const double *ny,
+               const double *nz, const double *px, const double *py,
+               const double *pz, int count, uint32_t *out) {
+  for (int i = 0; i < count; i += 4)
+    avxStore(avxShade<NL, SHINY>(s, avxLoad(nx, i, count),
+                                 avxLoad(ny, i, count), avxLoad(nz, i, count),
+                                 avxLoad(px, i, count), avxLoad(py, i, count),
+                                 avxLoad(pz, i, count),
+                                 s.shadow ? s.shadow + i : nullptr,
+                                 s.diffuse ? s.diffuse + i : nullptr,
+                                 s.diffuseOut ? s.diffuseOut + i : nullptr),
+             out, i, count);
+}
+
+struct Avx2Kernels {
+  static constexpr const char *name = "avx2";
+  template <int NL, int SHINY>
+  static constexpr PhongPacketFn packet = phongPacketAvx2<NL, SHINY>;
+  template <int NL, int SHINY>
+  static constexpr PhongShadeFn shade = phongShadeAvx2<NL, SHINY>;
+};
+
+#endif // RENDER_X86_SIMD
+
+// ============ DESPACHO ============
+
+namespace {
+// Expoentes especializados, na ordem das colunas da tabela
+constexpr int SHINY_VARIANTS[] = {FIXED_SHININESS, SHINY_INT, SHINY_REAL};
+constexpr int NUM_SHINY_VARIANTS = 3;
+
+// Todas as variantes de um conjunto de instrucoes, indexadas por
+// [luzes fixas ou 0][variante do expoente]
+struct KernelTable {
+  PhongPacketFn packet[MAX_FIXED_LIGHTS + 1][NUM_SHINY_VARIANTS];
+  PhongShadeFn shade[MAX_FIXED_LIGHTS + 1][NUM_SHINY_VARIANTS];
+  const char *name;
+};
+
+template <class K, int NL, int... S>
+void fillRow(KernelTable &table, std::integer_sequence<int, S...>) {
+  ((table.packet[NL][S] = K::template packet<NL, SHINY_VARIANTS[S]>), ...);
+  ((table.shade[NL][S] = K::template shade<NL, SHINY_VARIANTS[S]>), ...);
+}
+
+template <class K, int... NL>
+KernelTable makeTable(std::integer_sequence<int, NL...>) {
+  KernelTable table;
+  (fillRow<K, NL>(table, std::make_integer_sequence<int, NUM_SHINY_VARIANTS>()),
+   ...);
+  table.name = K::name;
+  return table;
+}
+
+template <class K> KernelTable makeTable() {
+  return makeTable<K>(std::make_integer_sequence<int, MAX_FIXED_LIGHTS + 1>());
+}
+
+KernelTable resolveKernels() {
+  const char *env = std::getenv("RENDER_SIMD");
+  auto allowed = [&](const char *name) {
+    return env == nullptr || std::strcmp(env, name) == 0;
+  };
+#if RENDER_X86_SIMD
+  __builtin_cpu_init();
+  if (allowed("avx2") && __builtin_cpu_supports("avx2"))
+    return makeTable<Avx2Kernels>();
+  // SSE2 faz parte do x86-64 base
+  if (allowed("sse2"))
+    return makeTable<Sse2Kernels>();
+#endif
+  (void)allowed;
+  return makeTable<ScalarKernels>();
+}
+
+const KernelTable &kernelTable() {
+  static const KernelTable table = resolveKernels();
+  return table;
+}
+
+int lightVariant(const PhongPacketSetup &setup) {
+  int count = setup.lights->count;
+  return count >= 1 && count <= MAX_FIXED_LIGHTS ? count : 0;
+}
+
+int shininessVariant(const PhongPacketSetup &setup) {
+  if (setup.intShininess == FIXED_SHININESS)
+    return 0;
+  return setup.intShininess >= 0 ? 1 : 2;
+}
+} // namespace
+
+PhongPacketFn phongPacketKernel(const PhongPacketSetup &setup) {
+  return kernelTable().packet[lightVariant(setup)][shininessVariant(setup)];
+}
+
+PhongShadeFn phongShadeKernel(const PhongPacketSetup &setup) {
+  return kernelTable().shade[lightVariant(setup)][shininessVariant(setup)];
+}
+
+const char *phongPacketKernelName() { return kernelTable().name; }
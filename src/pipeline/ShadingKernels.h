@@ -0,0 +1,116 @@
+#pragma once
+#include "../core/Cube.h"
+#include "../core/Light.h"
+#include "../math/Vector.h"
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Kernels de shading Phong por pacotes de pixels.
+// Um pacote sao ate PHONG_PACKET_SIZE fragmentos do mesmo triangulo (uma
+// linha de um bloco 8x8). Os kernels vetoriais (AVX2: 4 doubles, SSE2: 2
+// doubles) fazem as mesmas operacoes, na mesma ordem, que o kernel escalar,
+// entao os tres produzem exatamente a mesma cor. A implementacao e escolhida
+// em tempo de execucao conforme a CPU (RENDER_SIMD=scalar|sse2|avx2 força),
+// e cada uma tem variantes por numero de luzes e expoente especular.
+
+constexpr int PHONG_PACKET_SIZE = 8;
+
+struct CubeShadowMap;
+
+// Luzes em SoA (estrutura de arrays) para carregar direto em registradores
+struct LightSoA {
+  std::vector<double> px, py, pz; // posicao
+  std::vector<double> r, g, b;    // cor
+  std::vector<double> invRange2;  // 1/alcance² (0 = infinito)
+  // Shadow map de cada luz (nullptr = sem sombra); ver Shadows.h
+  std::vector<const CubeShadowMap *> shadowMap;
+  bool anyShadow{false}; // alguma luz tem shadow map
+  int count{0};
+
+  // Sem shadow maps (ShadowMapCache::attach os preenche)
+  void assign(const std::vector<Light> &lights);
+  // Copia so as luzes `indices` de `from` (lista de luzes de um tile)
+  void gather(const LightSoA &from, const std::vector<int> &indices);
+};
+
+// Dados por frame usados pelo shading
+struct ShadingContext {
+  const std::vector<Light> *lights{nullptr};
+  Vec3 eyePos;
+  LightSoA lightSoA;
+};
+
+// Dados de um triangulo para o kernel
+struct PhongPacketSetup {
+  double nx[3], ny[3], nz[3]; // normais dos vertices
+  double wx[3], wy[3], wz[3]; // posicoes no mundo
+  double color[3];            // cor do material
+  double ka, kd, ks, shininess;
+  int intShininess; // expoente inteiro (multiplicacoes) ou -1 (std::pow)
+  double eye[3];
+  const LightSoA *lights;
+  // Visibilidade de cada luz nos fragmentos do pacote, em
+  // shadow[l * PHONG_PACKET_SIZE + i] (ver shadowVisibility), ou nullptr
+  // sem sombras. Multiplica os termos difuso e especular da luz.
+  const double *shadow;
+  // Cache temporal (TemporalCache.h), so nos kernels de shading do
+  // resolve; nullptr fora dele. Termo ambiente + difuso de cada luz (ja com
+  // a visibilidade, antes do clamp) em
+  // [(l * 3 + canal) * PHONG_PACKET_SIZE + i]: `diffuse` entra no lugar do
+  // calculado (so o especular e refeito) e `diffuseOut` recebe o calculado.
+  const double *diffuse;
+  double *diffuseOut;
+};
+
+// Preenche material, olho e luzes (normais e posicoes vem do triangulo);
+// shadow, diffuse e diffuseOut ficam nullptr
+void setupPhongPacket(PhongPacketSetup &setup, const Material &mat,
+                      const ShadingContext &ctx);
+
+// Normalizacao usada pelos kernels (vetor nulo fica como esta)
+inline void normalizeFragment(double &x, double &y, double &z) {
+  double len = std::sqrt(x * x + y * y + z * z);
+  if (len == 0.0) // Evita divisao por 0
+    return;
+  x = x / len;
+  y = y / len;
+  z = z / len;
+}
+
+// Normal (normalizada no rasterizador e de novo no shading) e posicao do
+// fragmento nas baricentricas u, v, w: mesmas operacoes de todos os kernels
+inline void phongInterpolate(const PhongPacketSetup &s, double u, double v,
+                             double w, double n[3], double p[3]) {
+  n[0] = s.nx[0] * u + s.nx[1] * v + s.nx[2] * w;
+  n[1] = s.ny[0] * u + s.ny[1] * v + s.ny[2] * w;
+  n[2] = s.nz[0] * u + s.nz[1] * v + s.nz[2] * w;
+  normalizeFragment(n[0], n[1], n[2]);
+  normalizeFragment(n[0], n[1], n[2]);
+  p[0] = s.wx[0] * u + s.wx[1] * v + s.wx[2] * w;
+  p[1] = s.wy[0] * u + s.wy[1] * v + s.wy[2] * w;
+  p[2] = s.wz[0] * u + s.wz[1] * v + s.wz[2] * w;
+}
+
+// u, v, w: baricentricas de `count` fragmentos; out: cores ARGB
+using PhongPacketFn = void (*)(const PhongPacketSetup &setup, const double *u,
+                               const double *v, const double *w, int count,
+                               uint32_t *out);
+
+// Variante para fragmentos ja interpolados (resolve do modo deferred):
+// normais normalizadas e posicoes vem em arrays SoA (ex.: do G-buffer).
+// So material, olho e luzes do setup sao usados.
+using PhongShadeFn = void (*)(const PhongPacketSetup &setup, const double *nx,
+                              const double *ny, const double *nz,
+                              const double *px, const double *py,
+                              const double *pz, int count, uint32_t *out);
+
+// Kernels para esta CPU especializados para o setup (apos
+// setupPhongPacket): 1 a 4 luzes e o expoente 32 viram constantes de
+// compilacao (laco de luzes desenrolado, potencia em multiplicacoes fixas).
+// Uma consulta de tabela: chamar uma vez por triangulo/material, nao por
+// pacote.
+PhongPacketFn phongPacketKernel(const PhongPacketSetup &setup);
+PhongShadeFn phongShadeKernel(const PhongPacketSetup &setup);
+const char *phongPacketKernelName();
+
@@ -0,0 +1,335 @@
+#include "Shadows.h"
+#include "../core/BVH.h"
+#include "MultiViewRenderer.h"
+#include <algorithm>
+#include <cmath>
+
+// Vies contra "shadow acne" (a superficie sombreando a si mesma pela
+// discretizacao do mapa), em tamanhos de texel na distancia do ponto: o
+// ponto anda ao longo da normal e a comparacao e feita um pouco mais perto
+// da luz
+static constexpr double NORMAL_OFFSET = 1.5;
+static constexpr double DEPTH_BIAS = 1.0;
+
+// ============ AMOSTRAGEM ============
+
+double CubeShadowMap::visibility(const Vec3 &p, const Vec3 &n) const {
+  Vec3 d = p - position;
+  // Superficie de costas para a luz: na propria sombra, sem consultar o mapa
+  // (metade das consultas num cubo; tira tambem o especular dessas faces)
+  if (n.dot(d) >= 0.0)
+    return 0.0;
+  double dist = std::max({std::abs(d.x), std::abs(d.y), std::abs(d.z)});
+  if (dist <= nearPlane || dist >= farPlane)
+    return 1.0;
+  // Lado de um texel no mundo a essa distancia (face de 90 graus)
+  const double texel = 2.0 * dist / size;
+  const Vec3 q = p + n * (NORMAL_OFFSET * texel);
+  d = q - position;
+
+  // Face pelo eixo dominante: +X, -X, +Y, -Y, +Z, -Z
+  double ax = std::abs(d.x), ay = std::abs(d.y), az = std::abs(d.z);
+  int face;
+  if (ax >= ay && ax >= az)
+    face = d.x > 0 ? 0 : 1;
+  else if (ay >= az)
+    face = d.y > 0 ? 2 : 3;
+  else
+    face = d.z > 0 ? 4 : 5;
+
+  // Mesma projecao e mapeamento para a tela do rasterizador
+  const Mat4 &m = viewProj[face];
+  double cx = q.x * m.m[0][0] + q.y * m.m[1][0] + q.z * m.m[2][0] + m.m[3][0];
+  double cy = q.x * m.m[0][1] + q.y * m.m[1][1] + q.z * m.m[2][1] + m.m[3][1];
+  double cw = q.x * m.m[0][3] + q.y * m.m[1][3] + q.z * m.m[2][3] + m.m[3][3];
+  // w e negativo na frente da luz; somar o vies aproxima o ponto dela
+  double biasedW = cw + DEPTH_BIAS * texel;
+  if (!(biasedW < 0.0))
+    return 1.0;
+  const float threshold = static_cast<float>(depthScale / biasedW);
+  const double invW = 1.0 / cw;
+  double sx = (cx * invW + 1.0) * 0.5 * size;
+  double sy = (1.0 - cy * invW) * 0.5 * size;
+  int ix = std::clamp(static_cast<int>(sx), 0, size - 1);
+  int iy = std::clamp(static_cast<int>(sy), 0, size - 1);
+
+  // PCF: fracao das comparacoes em que nada esta mais perto da luz
+  const float *texels = depth[face].data();
+  const int r = pcfRadius;
+  int lit = 0;
+  if (ix >= r && iy >= r && ix < size - r && iy < size - r) {
+    const float *row = texels + static_cast<size_t>(iy - r) * size + ix;
+    for (int y = -r; y <= r; ++y, row += size)
+      for (int x = -r; x <= r; ++x)
+        lit += !(row[x] > threshold);
+  } else {
+    // Perto da borda: vizinhos presos a face
+    for (int y = iy - r; y <= iy + r; ++y) {
+      const float *row = texels +
+                         static_cast<size_t>(std::clamp(y, 0, size - 1)) *
+                             size;
+      for (int x = ix - r; x <= ix + r; ++x)
+        lit += !(row[std::clamp(x, 0, size - 1)] > threshold);
+    }
+  }
+  const int side = 2 * pcfRadius + 1;
+  return static_cast<double>(lit) / (side * side);
+}
+
+void shadowVisibility(const LightSoA &lights, const double *nx,
+                      const double *ny, const double *nz, const double *px,
+                      const double *py, const double *pz, int count,
+                      double *out) {
+  for (int l = 0; l < lights.count; ++l) {
+    double *vis = out + static_cast<size_t>(l) * PHONG_PACKET_SIZE;
+    const CubeShadowMap *map = lights.shadowMap[l];
+    for (int i = 0; i < count; ++i) {
+      vis[i] = 1.0;
+      if (!map)
+        continue;
+      // Fora do alcance a luz nao contribui: nao consulta o mapa
+      double lx = lights.px[l] - px[i], ly = lights.py[l] - py[i],
+             lz = lights.pz[l] - pz[i];
+      if (rangeAttenuation(lx * lx + ly * ly + lz * lz,
+                           lights.invRange2[l]) == 0.0)
+        continue;
+      vis[i] = map->visibility(Vec3{px[i], py[i], pz[i]},
+                               Vec3{nx[i], ny[i], nz[i]});
+    }
+    for (int i = count; i < PHONG_PACKET_SIZE; ++i)
+      vis[i] = vis[count - 1];
+  }
+}
+
+// ============ CACHE ============
+
+ShadowMapCache::ShadowMapCache(ThreadPool &pool) : pool(pool) {}
+
+ShadowMapCache::~ShadowMapCache() = default;
+
+const CubeShadowMap *ShadowMapCache::map(int light) const {
+  if (light < 0 || light >= (int)lights.size() || !lights[light].enabled)
+    return nullptr;
+  return &lights[light].map;
+}
+
+void ShadowMapCache::attach(LightSoA &soa) const {
+  soa.anyShadow = false;
+  for (int l = 0; l < soa.count; ++l) {
+    soa.shadowMap[l] = map(l);
+    soa.anyShadow |= soa.shadowMap[l] != nullptr;
+  }
+}
+
+static bool sameVec(const Vec3 &a, const Vec3 &b) {
+  return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+// Profundidade que o mapa precisa cobrir: o alcance da luz, ou (alcance
+// infinito) o canto mais distante da cena
+double ShadowMapCache::requiredFar(const Light &light) const {
+  if (light.range > 0)
+    return light.range;
+  if (sceneBounds.min.x > sceneBounds.max.x)
+    return 1.0; // cena vazia
+  double far2 = 0;
+  for (int c = 0; c < 8; ++c) {
+    Vec3 corner{c & 1 ? sceneBounds.max.x : sceneBounds.min.x,
+                c & 2 ? sceneBounds.max.y : sceneBounds.min.y,
+                c & 4 ? sceneBounds.max.z : sceneBounds.min.z};
+    Vec3 d = corner - light.position;
+    far2 = std::max(far2, d.dot(d));
+  }
+  return std::max(std::sqrt(far2), 1.0);
+}
+
+// Marca as faces cujo frustum (piramide de 90 graus ate o far) pode conter
+// a caixa, usando a esfera que a envolve
+void ShadowMapCache::markChanged(const AABB &box) {
+  if (box.min.x > box.max.x)
+    return;
+  const Vec3 center = box.center();
+  const Vec3 half = box.extent();
+  const double radius = std::sqrt(half.dot(half));
+  const double slack = radius * std::sqrt(2.0);
+  for (LightState &light : lights) {
+    if (!light.enabled)
+      continue;
+    Vec3 d = center - light.position;
+    if (std::sqrt(d.dot(d)) - radius > light.map.farPlane)
+      continue;
+    const double axis[3] = {d.x, d.y, d.z};
+    for (int f = 0; f < 6; ++f) {
+      if (light.dirty[f])
+        continue;
+      // Face f olha para sinal * eixo a; a esfera toca a piramide se esta
+      // do lado de dentro dos 4 planos laterais (|b| <= a, |c| <= a)
+      const int a = f / 2;
+      const double along = f % 2 == 0 ? axis[a] : -axis[a];
+      const double b = axis[(a + 1) % 3], c = axis[(a + 2) % 3];
+      if (along - std::abs(b) >= -slack && along - std::abs(c) >= -slack)
+        light.dirty[f] = true;
+    }
+  }
+}
+
+// Compara os objetos com o ultimo update e guarda em `changed` a caixa
+// antiga e a nova de cada um que mudou (inclusive os que entraram ou sairam)
+template <typename StateFn, typename BoundsFn>
+static void diffObjects(std::vector<ShadowObjectState> &states, size_t count,
+                        StateFn &&stateOf, BoundsFn &&boundsOf,
+                        std::vector<AABB> &changed) {
+  for (size_t i = 0; i < count; ++i) {
+    ShadowObjectState now = stateOf(i);
+    if (i < states.size()) {
+      const ShadowObjectState &old = states[i];
+      if (sameVec(old.position, now.position) &&
+          sameVec(old.rotation, now.rotation) && old.scale == now.scale &&
+          old.mesh == now.mesh)
+        continue;
+      changed.push_back(old.bounds);
+      states[i] = now;
+    } else {
+      states.push_back(now);
+    }
+    states[i].bounds = boundsOf(i);
+    changed.push_back(states[i].bounds);
+  }
+  for (size_t i = count; i < states.size(); ++i)
+    changed.push_back(states[i].bounds);
+  states.resize(count);
+}
+
+int ShadowMapCache::update(const Scene &scene, const RenderOptions &options) {
+  changed.clear();
+  diffObjects(
+      cubes, scene.cubes.size(),
+      [&](size_t i) {
+        const Cube &c = scene.cubes[i];
+        return ShadowObjectState{c.position, c.rotation, c.scale, nullptr,
+                                 AABB{}};
+      },
+      [&](size_t i) { return CubeBVH::cubeBounds(scene.cubes[i]); }, changed);
+  diffObjects(
+      meshes, scene.meshes.size(),
+      [&](size_t i) {
+        const MeshInstance &m = scene.meshes[i];
+        return ShadowObjectState{m.position, m.rotation, m.scale,
+                                 m.mesh.get(), AABB{}};
+      },
+      [&](size_t i) {
+        // Instancia sem malha: caixa vazia
+        return scene.meshes[i].mesh ? scene.meshes[i].worldBounds() : AABB{};
+      },
+      changed);
+  sceneBounds = AABB{};
+  for (const auto *states : {&cubes, &meshes})
+    for (const ShadowObjectState &s : *states)
+      if (s.bounds.min.x <= s.bounds.max.x)
+        sceneBounds.expand(s.bounds);
+
+  // Luzes: mapa inteiro refeito quando a luz ou a configuracao mudam
+  const int size = std::max(8, options.shadowMapSize);
+  const int pcf = std::clamp(options.shadowPcf, 0, 8);
+  lights.resize(scene.lights.size());
+  for (size_t l = 0; l < scene.lights.size(); ++l) {
+    const Light &light = scene.lights[l];
+    LightState &state = lights[l];
+    if (!light.castShadows) {
+      state.enabled = false;
+      state.map = CubeShadowMap{}; // libera a memoria
+      continue;
+    }
+    // Alcance infinito: far com folga, refeito so se a cena sair dele ou
+    // encolher muito
+    double far = requiredFar(light);
+    bool farOk = light.range > 0 ? state.map.farPlane == far
+                                 : far <= state.map.farPlane &&
+                                       far * 2.0 > state.map.farPlane;
+    state.map.pcfRadius = pcf;
+    if (state.enabled && sameVec(state.position, light.position) &&
+        state.range == light.range && state.map.size == size && farOk)
+      continue;
+    state.enabled = true;
+    state.position = light.position;
+    state.range = light.range;
+    CubeShadowMap &map = state.map;
+    map.position = light.position;
+    map.size = size;
+    map.farPlane = light.range > 0 ? far : far * 1.25;
+    map.nearPlane = std::max(1e-3, map.farPlane * 1e-4);
+    auto cameras = MultiViewRenderer::cubeMapCameras(
+        light.position, map.nearPlane, map.farPlane);
+    for (int f = 0; f < 6; ++f) {
+      Mat4 proj = cameras[f].projectionMatrix();
+      map.viewProj[f] = cameras[f].viewMatrix() * proj;
+      map.depthScale = proj.m[3][2];
+      state.dirty[f] = true;
+    }
+  }
+  for (const AABB &box : changed)
+    markChanged(box);
+
+  renderFaces(scene, options);
+  return lastFaces;
+}
+
+// Faces marcadas, ate 6 por chamada do MultiViewRenderer (vistas em
+// paralelo). O z-buffer de cada alvo e copiado (em float) para a face.
+void ShadowMapCache::renderFaces(const Scene &scene,
+                                 const RenderOptions &options) {
+  lastFaces = 0;
+  RenderOptions depthOptions = options;
+  depthOptions.usePhong = false;
+  depthOptions.deferred = false;
+  depthOptions.msaaSamples = 1;
+  depthOptions.shadows = false;
+  depthOptions.depthOnly = true;
+
+  auto flush = [&]() {
+    if (cameras.empty())
+      return;
+    if (!faceRenderer)
+      faceRenderer = std::make_unique<MultiViewRenderer>(pool);
+    faceRenderer->render(scene, cameras, targets, depthOptions);
+    for (size_t v = 0; v < faces.size(); ++v)
+      faces[v]->assign(targets[v]->depth.begin(), targets[v]->depth.end());
+    lastFaces += static_cast<int>(cameras.size());
+    cameras.clear();
+    targets.clear();
+    faces.clear();
+  };
+
+  // Alvos criados juntos: `targets` aponta para dentro do vetor
+  while (faceTargets.size() < 6)
+    faceTargets.emplace_back(0, 0);
+  cameras.clear();
+  targets.clear();
+  faces.clear();
+  for (LightState &light : lights) {
+    if (!light.enabled)
+      continue;
+    CubeShadowMap &map = light.map;
+    std::array<Camera, 6> faceCameras;
+    bool haveCameras = false;
+    for (int f = 0; f < 6; ++f) {
+      if (!light.dirty[f])
+        continue;
+      light.dirty[f] = false;
+      if (!haveCameras) {
+        faceCameras = MultiViewRenderer::cubeMapCameras(
+            map.position, map.nearPlane, map.farPlane);
+        haveCameras = true;
+      }
+      Framebuffer &target = faceTargets[cameras.size()];
+      target.resize(map.size, map.size);
+      target.clear(0);
+      cameras.push_back(faceCameras[f]);
+      targets.push_back(&target);
+      faces.push_back(&map.depth[f]);
+      if (cameras.size() == 6)
+        flush();
+    }
+  }
+  flush();
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include "../core/Scene.h"
+#include "Rasterizer.h"
+#include "ThreadPool.h"
+#include <array>
+#include <memory>
+#include <vector>
+
+class MultiViewRenderer;
+
+// ============ SHADOW MAPS ============
+// Cada luz pontual com Light::castShadows tem um cube shadow map: 6 faces
+// de 90 graus (as cameras de MultiViewRenderer::cubeMapCameras) com so a
+// profundidade da cena vista da luz, renderizadas pelo proprio rasterizador
+// no modo RasterMode::Depth. No shading cada fragmento compara a sua
+// distancia a luz com a do mapa, com PCF (media de (2r+1)² comparacoes) para
+// suavizar a borda da sombra.
+
+// Mapa de uma luz. Profundidade do z-buffer (reversa: maior = mais perto da
+// luz, DEPTH_CLEAR onde nao ha geometria) guardada em float: metade da
+// memoria percorrida pela amostragem, que e o custo das sombras por frame.
+struct CubeShadowMap {
+  Vec3 position;
+  double nearPlane{0}, farPlane{0};
+  int size{0};      // texels por lado de cada face
+  int pcfRadius{1}; // 0 = uma comparacao, 1 = 3x3, 2 = 5x5
+  double depthScale{0}; // proj.m[3][2]: profundidade = depthScale / clip.w
+  Mat4 viewProj[6];
+  std::vector<float> depth[6]; // size*size por face
+
+  // Fracao de luz que chega ao ponto `p` (normal `n`, normalizada): 1 =
+  // iluminado, 0 = na sombra
+  double visibility(const Vec3 &p, const Vec3 &n) const;
+};
+
+// Visibilidade das luzes de `lights` para `count` fragmentos (normais
+// normalizadas e posicoes em SoA). out[l * PHONG_PACKET_SIZE + i]; as
+// posicoes alem de count repetem o ultimo fragmento (lanes extras dos
+// kernels vetoriais). Luzes sem mapa ficam com 1.
+void shadowVisibility(const LightSoA &lights, const double *nx,
+                      const double *ny, const double *nz, const double *px,
+                      const double *py, const double *pz, int count,
+                      double *out);
+
+// Transformacao e caixa de um cubo ou instancia de malha no ultimo update
+// do cache (caixa vazia = instancia sem malha)
+struct ShadowObjectState {
+  Vec3 position, rotation;
+  double scale;
+  const Mesh *mesh; // nullptr nos cubos
+  AABB bounds;
+};
+
+// Cache dos shadow maps de uma cena entre frames. Uma face so e
+// re-renderizada quando a luz muda (posicao, alcance, configuracao do mapa)
+// ou quando um cubo/instancia de malha que mudou (posicao antiga ou nova)
+// cai dentro do seu frustum; numa cena parada nenhuma face e refeita e o
+// custo das sombras e so a amostragem no shading.
+class ShadowMapCache {
+public:
+  explicit ShadowMapCache(ThreadPool &pool = ThreadPool::global());
+  ~ShadowMapCache();
+  ShadowMapCache(const ShadowMapCache &) = delete;
+  ShadowMapCache &operator=(const ShadowMapCache &) = delete;
+
+  // Deixa os mapas de scene.lights em dia (tamanho e PCF de `options`).
+  // Retorna quantas faces foram renderizadas.
+  int update(const Scene &scene, const RenderOptions &options);
+
+  // Mapa da luz `light` (indice em scene.lights) ou nullptr
+  const CubeShadowMap *map(int light) const;
+  // Aponta cada luz de `soa` (montado de scene.lights) para o seu mapa
+  void attach(LightSoA &soa) const;
+
+  // Faces renderizadas no ultimo update()
+  int facesRendered() const { return lastFaces; }
+
+private:
+  struct LightState {
+    bool enabled{false};
+    Vec3 position;
+    double range{0};
+    bool dirty[6]{};
+    CubeShadowMap map;
+  };
+
+  double requiredFar(const Light &light) const;
+  void markChanged(const AABB &box);
+  void renderFaces(const Scene &scene, const RenderOptions &options);
+
+  ThreadPool &pool;
+  std::vector<LightState> lights;
+  std::vector<ShadowObjectState> cubes, meshes;
+  std::vector<AABB> changed; // caixas alteradas no update atual
+  AABB sceneBounds;
+  int lastFaces{0};
+
+  // Passadas de profundidade: ate 6 faces por chamada
+  std::unique_ptr<MultiViewRenderer> faceRenderer;
+  std::vector<Framebuffer> faceTargets;
+  std::vector<Camera> cameras;
+  std::vector<Framebuffer *> targets;
+  std::vector<std::vector<float> *> faces; // destino de cada alvo
+};
@@ -0,0 +1,246 @@
+#include "TemporalCache.h"
+#include "Shadows.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+// Mesma superficie: profundidade relativa e cosseno entre as normais
+static const double DEPTH_TOLERANCE = 0.01;
+static const double NORMAL_MIN_DOT = 0.95;
+
+static uint32_t packNormal(double x, double y, double z) {
+  auto q = [](double v) {
+    return static_cast<uint32_t>(
+        static_cast<int>(v * 127.0 + (v < 0.0 ? -0.5 : 0.5)) & 0xff);
+  };
+  return q(x) | q(y) << 8 | q(z) << 16;
+}
+
+static double normalComponent(uint32_t packed, int c) {
+  return static_cast<int8_t>((packed >> (8 * c)) & 0xff) / 127.0;
+}
+
+// ============ FRAMES ============
+
+bool TemporalCache::sameScene(const Scene &scene,
+                              const RenderOptions &options) const {
+  if (options.shadows != shadows || options.shadowMapSize != shadowMapSize ||
+      options.shadowPcf != shadowPcf || scene.lights.size() != lights.size() ||
+      scene.cubes.size() != cubes.size() ||
+      scene.meshes.size() != meshes.size())
+    return false;
+  for (size_t i = 0; i < lights.size(); ++i)
+    if (!sameLight(scene.lights[i], lights[i]))
+      return false;
+  for (size_t i = 0; i < cubes.size(); ++i)
+    if (!sameCube(scene.cubes[i], cubes[i]))
+      return false;
+  for (size_t i = 0; i < meshes.size(); ++i)
+    if (!sameMesh(scene.meshes[i], meshes[i]))
+      return false;
+  return true;
+}
+
+bool TemporalCache::begin(const Scene &scene, const RenderOptions &options,
+                          int width, int height, const Mat4 &viewProj) {
+  bool same = current.valid && sameScene(scene, options);
+  std::swap(previous, current);
+  previous.valid =
+      same && previous.width == width && previous.height == height;
+  if (!same) {
+    lights = scene.lights;
+    cubes = scene.cubes;
+    meshes = scene.meshes;
+    shadows = options.shadows;
+    shadowMapSize = options.shadowMapSize;
+    shadowPcf = options.shadowPcf;
+  }
+  ++frameIndex;
+
+  const int lightCount = static_cast<int>(scene.lights.size());
+  if (lightCount > TEMPORAL_MAX_LIGHTS) {
+    invalidate();
+    return false;
+  }
+  current.width = width;
+  current.height = height;
+  current.lights = lightCount;
+  current.viewProj = viewProj;
+  current.valid = true;
+  // So a profundidade precisa ser limpa: o resto so e lido onde ha
+  // geometria, e todo pixel com geometria e sombreado no frame
+  const size_t pixels = static_cast<size_t>(width) * height;
+  current.depth.assign(pixels, 0.0f);
+  current.normal.resize(pixels);
+  current.age.resize(pixels);
+  current.terms.resize(pixels * lightCount * 4);
+  return true;
+}
+
+void TemporalCache::invalidate() {
+  previous.valid = false;
+  current.valid = false;
+}
+
+// ============ REPROJECAO ============
+
+long long TemporalCache::reproject(const LightSoA &soa, const int *lightIds,
+                                   int x, int y, double nx, double ny,
+                                   double nz, double px, double py,
+                                   double pz) const {
+  // Renovacao em blocos inteiros: pacotes sem mistura de pixels novos e
+  // reaproveitados e acesso coerente aos shadow maps
+  const int B = Framebuffer::HIZ_BLOCK;
+  if (!previous.valid || (x / B + y / B + frameIndex) % TEMPORAL_REFRESH == 0)
+    return -1;
+  const auto &m = previous.viewProj.m;
+  double cx = px * m[0][0] + py * m[1][0] + pz * m[2][0] + m[3][0];
+  double cy = px * m[0][1] + py * m[1][1] + pz * m[2][1] + m[3][1];
+  double cw = px * m[0][3] + py * m[1][3] + pz * m[2][3] + m[3][3];
+  if (!(cw < 0.0)) // atras da camera antiga
+    return -1;
+  double sx = (cx / cw + 1.0) * 0.5 * previous.width;
+  double sy = (1.0 - cy / cw) * 0.5 * previous.height;
+  if (!(sx >= 0.0 && sx < previous.width && sy >= 0.0 &&
+        sy < previous.height))
+    return -1;
+  const size_t k = static_cast<size_t>(sy) * previous.width +
+                   static_cast<size_t>(sx);
+
+  // Mesma superficie: profundidade e normal proximas
+  double depth = previous.depth[k];
+  if (depth <= 0.0 || std::abs(depth + cw) > DEPTH_TOLERANCE * -cw ||
+      previous.age[k] + 1 >= TEMPORAL_REFRESH)
+    return -1;
+  uint32_t n = previous.normal[k];
+  if (nx * normalComponent(n, 0) + ny * normalComponent(n, 1) +
+          nz * normalComponent(n, 2) <
+      NORMAL_MIN_DOT)
+    return -1;
+  // Todas as luzes do pacote avaliadas no pixel antigo e fora da
+  // penumbra: na borda da sombra o pixel vizinho reprojetado nao vale
+  const float *terms = &previous.terms[k * previous.lights * 4];
+  for (int l = 0; l < soa.count; ++l) {
+    float vis = terms[lightIds[l] * 4 + 3];
+    if (vis != 0.0f && vis != 1.0f)
+      return -1;
+  }
+  return static_cast<long long>(k);
+}
+
+// ============ SHADING ============
+
+int TemporalCache::shade(PhongPacketSetup &setup, PhongShadeFn kernel,
+                         const int *lightIds, int x, int y, const double *nx,
+                         const double *ny, const double *nz, const double *px,
+                         const double *py, const double *pz, int count,
+                         double *shadow, uint32_t *out) {
+  constexpr int P = PHONG_PACKET_SIZE;
+  const LightSoA &soa = *setup.lights;
+  const int L = current.lights;
+  const size_t row = static_cast<size_t>(y) * current.width + x;
+  const auto &m = current.viewProj.m;
+
+  // Separa os pixels novos dos reaproveitados
+  int fresh[P], reused[P];
+  long long from[P];
+  int numFresh = 0, numReused = 0;
+  for (int i = 0; i < count; ++i) {
+    double w = px[i] * m[0][3] + py[i] * m[1][3] + pz[i] * m[2][3] + m[3][3];
+    current.depth[row + i] = static_cast<float>(-w);
+    current.normal[row + i] = packNormal(nx[i], ny[i], nz[i]);
+    long long k =
+        reproject(soa, lightIds, x + i, y, nx[i], ny[i], nz[i], px[i], py[i],
+                  pz[i]);
+    if (k >= 0) {
+      from[numReused] = k;
+      reused[numReused++] = i;
+    } else {
+      fresh[numFresh++] = i;
+    }
+  }
+
+  // Arrays SoA compactos de um subconjunto do pacote
+  double gx[P], gy[P], gz[P], gpx[P], gpy[P], gpz[P];
+  uint32_t gout[P];
+  auto gather = [&](const int *pick, int n) {
+    for (int j = 0; j < n; ++j) {
+      int i = pick[j];
+      gx[j] = nx[i];
+      gy[j] = ny[i];
+      gz[j] = nz[i];
+      gpx[j] = px[i];
+      gpy[j] = py[i];
+      gpz[j] = pz[i];
+    }
+  };
+  // Termos ambiente + difuso no layout de PhongPacketSetup::diffuse
+  double diffuse[TEMPORAL_MAX_LIGHTS * 3 * P];
+  double vis[TEMPORAL_MAX_LIGHTS * P];
+
+  // Novos: shading completo, como no resolve; o kernel devolve os termos
+  // para o proximo frame
+  if (numFresh > 0) {
+    const bool all = numFresh == count;
+    if (!all)
+      gather(fresh, numFresh);
+    const double *fx = all ? nx : gx, *fy = all ? ny : gy,
+                 *fz = all ? nz : gz, *fpx = all ? px : gpx,
+                 *fpy = all ? py : gpy, *fpz = all ? pz : gpz;
+    setup.shadow = nullptr;
+    if (soa.anyShadow) {
+      shadowVisibility(soa, fx, fy, fz, fpx, fpy, fpz, numFresh, shadow);
+      setup.shadow = shadow;
+    }
+    setup.diffuseOut = diffuse;
+    kernel(setup, fx, fy, fz, fpx, fpy, fpz, numFresh, all ? out : gout);
+    setup.diffuseOut = nullptr;
+
+    for (int j = 0; j < numFresh; ++j) {
+      int i = fresh[j];
+      if (!all)
+        out[i] = gout[j];
+      float *terms = &current.terms[(row + i) * L * 4];
+      for (int s = 0; s < L; ++s)
+        terms[s * 4 + 3] = -1.0f;
+      for (int l = 0; l < soa.count; ++l) {
+        float *t = &terms[lightIds[l] * 4];
+        t[0] = static_cast<float>(diffuse[(l * 3 + 0) * P + j]);
+        t[1] = static_cast<float>(diffuse[(l * 3 + 1) * P + j]);
+        t[2] = static_cast<float>(diffuse[(l * 3 + 2) * P + j]);
+        t[3] = setup.shadow ? static_cast<float>(setup.shadow[l * P + j])
+                            : 1.0f;
+      }
+      current.age[row + i] = 0;
+    }
+  }
+
+  // Reaproveitados: difuso e visibilidade do frame anterior, so o
+  // especular e refeito
+  if (numReused > 0) {
+    gather(reused, numReused);
+    for (int j = 0; j < numReused; ++j) {
+      const float *terms = &previous.terms[from[j] * L * 4];
+      for (int l = 0; l < soa.count; ++l) {
+        const float *t = &terms[lightIds[l] * 4];
+        diffuse[(l * 3 + 0) * P + j] = t[0];
+        diffuse[(l * 3 + 1) * P + j] = t[1];
+        diffuse[(l * 3 + 2) * P + j] = t[2];
+        vis[l * P + j] = t[3];
+      }
+    }
+    setup.shadow = soa.anyShadow ? vis : nullptr;
+    setup.diffuse = diffuse;
+    kernel(setup, gx, gy, gz, gpx, gpy, gpz, numReused, gout);
+    setup.diffuse = nullptr;
+    for (int j = 0; j < numReused; ++j) {
+      int i = reused[j];
+      out[i] = gout[j];
+      std::copy_n(&previous.terms[from[j] * L * 4], L * 4,
+                  &current.terms[(row + i) * L * 4]);
+      current.age[row + i] =
+          static_cast<uint8_t>(previous.age[from[j]] + 1);
+    }
+  }
+  return numReused;
+}
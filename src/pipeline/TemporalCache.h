@@ -0,0 +1,91 @@
+#pragma once
+#include "../core/Scene.h"
+#include "../math/Matrix.h"
+#include "Rasterizer.h"
+#include "ShadingKernels.h"
+#include <cstdint>
+#include <vector>
+
+// ============ CACHE TEMPORAL ============
+// Com a camera andando numa cena parada, a luz difusa que chega a cada
+// ponto das superficies nao muda: so o especular depende do olho. O cache
+// guarda, por pixel do frame anterior, a profundidade, a normal e, por luz,
+// o termo ambiente + difuso (ja com a sombra) e a visibilidade da luz.
+//
+// No resolve do deferred cada pixel e reprojetado com a view-projection do
+// frame anterior. Se cai num pixel que tinha a mesma superficie
+// (profundidade e normal proximas), o difuso e a visibilidade vem de la e
+// so o especular e refeito (PhongPacketSetup::diffuse); o shadow map nao e
+// consultado. Pixels descobertos, fora da tela antiga, na penumbra de uma
+// luz, com uma luz que o pixel antigo nao avaliou ou da vez de renovar sao
+// sombreados por inteiro.
+//
+// Renovacao: 1 em TEMPORAL_REFRESH blocos 8x8 por frame (em diagonal), e
+// nenhum valor passa de TEMPORAL_REFRESH frames de idade, para a
+// reamostragem (pixel mais proximo) nao acumular deriva.
+//
+// O frame anterior e descartado quando luzes, cubos, malhas, opcoes de
+// sombra ou o tamanho da tela mudam, e pelos renders que nao usam o cache
+// (parciais, outros modos).
+//
+// O que se economiza e a visibilidade dos shadow maps. O kernel vetorizado
+// faz o difuso quase de graca e a reprojecao custa tanto quanto ele, entao
+// sem sombras o modo perde e com sombras empata (numeros no README).
+
+// Luzes guardadas por pixel; cenas com mais luzes nao usam o cache
+constexpr int TEMPORAL_MAX_LIGHTS = 4;
+// Cada pixel e sombreado por inteiro pelo menos a cada TEMPORAL_REFRESH
+// frames
+constexpr int TEMPORAL_REFRESH = 8;
+
+class TemporalCache {
+public:
+  // Inicio do frame: o frame atual vira o anterior e o novo comeca vazio.
+  // O anterior so vale se cena (fora a camera), opcoes de sombra e tamanho
+  // forem os mesmos. Retorna false (frame sem cache) com mais de
+  // TEMPORAL_MAX_LIGHTS luzes.
+  bool begin(const Scene &scene, const RenderOptions &options, int width,
+             int height, const Mat4 &viewProj);
+  // Descarta o frame anterior e o atual
+  void invalidate();
+
+  // Sombreia o pacote de `count` pixels que comeca em (x, y), como o
+  // resolve (shadowVisibility + kernel), mas os pixels que reprojetam na
+  // mesma superficie do frame anterior usam o difuso e a visibilidade de
+  // la. lightIds[l]: indice em scene.lights da luz l de setup.lights;
+  // `shadow`: rascunho de PHONG_PACKET_SIZE por luz. Guarda o resultado no
+  // frame atual: cada pixel deve ser sombreado por uma so thread. Retorna
+  // quantos pixels reaproveitaram o frame anterior.
+  int shade(PhongPacketSetup &setup, PhongShadeFn kernel, const int *lightIds,
+            int x, int y, const double *nx, const double *ny,
+            const double *nz, const double *px, const double *py,
+            const double *pz, int count, double *shadow, uint32_t *out);
+
+private:
+  struct Frame {
+    int width{0}, height{0}, lights{0};
+    Mat4 viewProj;
+    bool valid{false};
+    std::vector<float> depth;     // -w de clip; 0 = sem geometria
+    std::vector<uint32_t> normal; // 3 componentes de 8 bits com sinal
+    std::vector<uint8_t> age;     // frames desde o shading completo
+    // Por pixel e luz, em terms[(pixel * lights + l) * 4]: ambiente +
+    // difuso (r, g, b) e a visibilidade (< 0 = luz nao avaliada no pixel)
+    std::vector<float> terms;
+  };
+
+  // Pixel do frame anterior com a mesma superficie ou -1
+  long long reproject(const LightSoA &soa, const int *lightIds, int x, int y,
+                      double nx, double ny, double nz, double px, double py,
+                      double pz) const;
+  bool sameScene(const Scene &scene, const RenderOptions &options) const;
+
+  Frame previous, current;
+  // Cena e opcoes de sombra do frame atual
+  std::vector<Light> lights;
+  std::vector<Cube> cubes;
+  std::vector<MeshInstance> meshes;
+  bool shadows{false};
+  int shadowMapSize{0}, shadowPcf{0};
+  int frameIndex{0};
+};
@@ -0,0 +1,116 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cstdlib>
+
+ThreadPool::ThreadPool(int numThreads) {
+  if (numThreads <= 0)
+    numThreads = static_cast<int>(std::thread::hardware_concurrency());
+  numThreads = std::max(1, numThreads);
+  queue.reserve(64);
+  // A thread chamadora tambem trabalha, entao cria n-1 workers
+  for (int i = 1; i < numThreads; ++i)
+    workers.emplace_back([this] { workerLoop(); });
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    stopping = true;
+  }
+  queueCv.notify_all();
+  for (auto &t : workers)
+    t.join();
+}
+
+ThreadPool &ThreadPool::global() {
+  // RENDER_THREADS permite fixar o numero de threads (ex.: nos compartilhados)
+  static ThreadPool pool([] {
+    const char *env = std::getenv("RENDER_THREADS");
+    return env ? std::atoi(env) : 0;
+  }());
+  return pool;
+}
+
+void ThreadPool::runJob(Job &job) {
+  for (;;) {
+    int i = job.next.fetch_add(1);
+    if (i >= job.count)
+      break;
+    job.call(job.fn, i);
+    if (job.done.fetch_add(1) + 1 == job.count) {
+      std::lock_guard<std::mutex> lock(job.doneMutex);
+      job.doneCv.notify_all();
+    }
+  }
+}
+
+void ThreadPool::workerLoop() {
+  for (;;) {
+    Job *job = nullptr;
+    {
+      std::unique_lock<std::mutex> lock(queueMutex);
+      queueCv.wait(lock, [&] {
+        if (stopping)
+          return true;
+        // Procura um job com indices restantes que aceite ajuda
+        for (Job *j : queue) {
+          if (j->next.load() < j->count &&
+              j->helpers.load() < j->maxHelpers) {
+            job = j;
+            return true;
+          }
+        }
+        return false;
+      });
+      if (stopping)
+        return;
+      // Com queueMutex: o chamador so le `helpers` depois de tirar o job
+      // da fila, entao ve todos os workers que entraram
+      job->helpers.fetch_add(1);
+    }
+    runJob(*job);
+    // Ultimo acesso ao job: depois disso o chamador pode retornar
+    std::lock_guard<std::mutex> lock(job->doneMutex);
+    ++job->helpersDone;
+    job->doneCv.notify_all();
+  }
+}
+
+void ThreadPool::run(int count, void *fn, JobFn call, int maxThreads) {
+  if (count <= 0)
+    return;
+
+  int threads = maxThreads > 0 ? std::min(maxThreads, size()) : size();
+  threads = std::min(threads, count);
+  if (threads <= 1) {
+    for (int i = 0; i < count; ++i)
+      call(fn, i);
+    return;
+  }
+
+  // O job vive na pilha: so retorna depois que todo worker que entrou saiu
+  Job job;
+  job.call = call;
+  job.fn = fn;
+  job.count = count;
+  job.maxHelpers = threads - 1;
+  {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    queue.push_back(&job);
+  }
+  queueCv.notify_all();
+
+  // Chamador participa do trabalho
+  runJob(job);
+
+  int helpers;
+  {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    queue.erase(std::find(queue.begin(), queue.end(), &job));
+    helpers = job.helpers.load();
+  }
+  std::unique_lock<std::mutex> lock(job.doneMutex);
+  job.doneCv.wait(lock, [&] {
+    return job.done.load() == job.count && job.helpersDone == helpers;
+  });
+}
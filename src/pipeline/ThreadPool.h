@@ -0,0 +1,64 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Pool de threads persistente usado pelo pipeline (tiles, instancias, views).
+// A thread que chama parallelFor tambem executa trabalho, entao chamadas
+// aninhadas ou concorrentes (varios renders ao mesmo tempo) nao travam.
+// parallelFor nao aloca: o job fica na pilha do chamador e a funcao e
+// passada por referencia (sem std::function).
+class ThreadPool {
+public:
+  // numThreads = 0 usa std::thread::hardware_concurrency()
+  explicit ThreadPool(int numThreads = 0);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // Numero de threads que podem trabalhar (workers + chamador)
+  int size() const { return static_cast<int>(workers.size()) + 1; }
+
+  // Executa fn(i) para i em [0, count) e bloqueia ate todos terminarem.
+  // maxThreads limita quantas threads participam (0 = todas).
+  template <typename Fn>
+  void parallelFor(int count, Fn &&fn, int maxThreads = 0) {
+    using F = std::remove_reference_t<Fn>;
+    run(count, const_cast<void *>(static_cast<const void *>(&fn)),
+        [](void *f, int i) { (*static_cast<F *>(f))(i); }, maxThreads);
+  }
+
+  // Pool compartilhado pelo processo inteiro (RENDER_THREADS sobrescreve o
+  // numero de threads)
+  static ThreadPool &global();
+
+private:
+  using JobFn = void (*)(void *fn, int i);
+
+  struct Job {
+    JobFn call;
+    void *fn;
+    int count;
+    int maxHelpers;               // workers extras permitidos
+    std::atomic<int> next{0};     // proximo indice a executar
+    std::atomic<int> done{0};     // indices concluidos
+    std::atomic<int> helpers{0};  // workers que entraram no job
+    int helpersDone{0};           // workers que sairam (com doneMutex)
+    std::mutex doneMutex;
+    std::condition_variable doneCv;
+  };
+
+  void run(int count, void *fn, JobFn call, int maxThreads);
+  void workerLoop();
+  static void runJob(Job &job);
+
+  std::vector<std::thread> workers;
+  std::vector<Job *> queue; // jobs com trabalho; o chamador remove o seu
+  std::mutex queueMutex;
+  std::condition_variable queueCv;
+  bool stopping{false};
+};
@@ -3,30 +3,54 @@
 #include "../math/Vector.h"
 
 // Converter Vec3 para Vec4 homogêneo (SEM argumento padrão aqui)
-inline Vec4 toVec4(const Vec3 &v, double w) { return Vec4{v.x, v.y, v.z, w}; }
+template <typename T> inline Vec4T<T> toVec4(const Vec3T<T> &v, T w) {
+  return Vec4T<T>{v.x, v.y, v.z, w};
+}
 
 // Sobrecarga para converter Vec3 para Vec4 (w=1 por padrão)
-inline Vec4 toVec4(const Vec3 &v) { return Vec4{v.x, v.y, v.z, 1.0}; }
+template <typename T> inline Vec4T<T> toVec4(const Vec3T<T> &v) {
+  return Vec4T<T>{v.x, v.y, v.z, T(1)};
+}
 
 // Converter Vec4 para Vec3 (divisão por w)
-inline Vec3 fromVec4(const Vec4 &v) {
-  if (std::abs(v.w) < 1e-10)
-    return Vec3{0, 0, 0};
-  return Vec3{v.x / v.w, v.y / v.w, v.z / v.w};
+template <typename T> inline Vec3T<T> fromVec4(const Vec4T<T> &v) {
+  if (std::abs(v.w) < T(1e-10))
+    return Vec3T<T>{0, 0, 0};
+  return Vec3T<T>{v.x / v.w, v.y / v.w, v.z / v.w};
 }
 
-// Transformar ponto para NDC
-inline Vec3 transformToNDC(const Vec3 &p, const Mat4 &model, const Mat4 &view,
-                           const Mat4 &proj) {
+// Transformar ponto para clip space
+template <typename T>
+inline Vec4T<T> transformToClip(const Vec3T<T> &p, const Mat4T<T> &model,
+                                const Mat4T<T> &view, const Mat4T<T> &proj) {
   // Ordem correta: proj * view * model * ponto
-  Vec4 worldPos = model * toVec4(p);
-  Vec4 viewPos = view * worldPos;
-  Vec4 clipPos = proj * viewPos;
+  Vec4T<T> worldPos = model * toVec4(p);
+  Vec4T<T> viewPos = view * worldPos;
+  return proj * viewPos;
+}
+
+// Transformar ponto para NDC
+template <typename T>
+inline Vec3T<T> transformToNDC(const Vec3T<T> &p, const Mat4T<T> &model,
+                               const Mat4T<T> &view, const Mat4T<T> &proj) {
+  Vec4T<T> clipPos = transformToClip(p, model, view, proj);
 
   // Divisão perspectiva
-  if (std::abs(clipPos.w) < 1e-10)
-    return Vec3{0, 0, 0};
+  if (std::abs(clipPos.w) < T(1e-10))
+    return Vec3T<T>{0, 0, 0};
+
+  return Vec3T<T>{clipPos.x / clipPos.w, clipPos.y / clipPos.w,
+                  clipPos.z / clipPos.w};
+}
 
-  return Vec3{clipPos.x / clipPos.w, clipPos.y / clipPos.w,
-              clipPos.z / clipPos.w};
+// Profundidade gravada no z-buffer: ndc.z - P[2][2] = P[3][2] / w.
+// Mesma ordem que ndc.z (maior = mais perto), mas proporcional a
+// 1/distancia e perto de zero ao longe, onde float tem mais precisao
+// (ver "Precisão do Z-buffer" no README). Vale para a matriz de
+// Camera::projectionMatrix, em que so m[2][2] e m[3][2] geram o z.
+template <typename T>
+inline T depthFromClip(const Vec4T<T> &clipPos, const Mat4T<T> &proj) {
+  if (std::abs(clipPos.w) < T(1e-10))
+    return T(0);
+  return proj.m[3][2] / clipPos.w;
 }
@@ -0,0 +1,43 @@
+// Cabecalho da animacao: valores gigantes, NaN e totais acima do limite sao
+// recusados antes de virar alocacao.
+#include "../src/core/Animation.h"
+#include <cstdio>
+#include <sstream>
+
+static int failures = 0;
+
+static bool parses(const char *text) {
+  std::istringstream in(text);
+  Animation anim;
+  std::string error;
+  return Animation::parse(in, anim, error);
+}
+
+static void check(bool ok, const char *what) {
+  if (!ok) {
+    std::printf("FALHOU: %s\n", what);
+    ++failures;
+  }
+}
+
+int main() {
+  check(parses("size 640 480\nframes 30\nfps 24\n"), "cabecalho normal");
+  check(parses("size 8192 8192\n"), "maior frame aceito");
+  check(!parses("size 1e12 480\n"), "largura acima do int");
+  check(!parses("size 16385 1\n"), "largura acima do limite");
+  check(!parses("size 16384 16384\n"), "pixels por frame acima do limite");
+  check(!parses("size nan 480\n"), "largura NaN");
+  check(!parses("frames 1e10\n"), "frames acima do limite");
+  check(!parses("frames nan\n"), "frames NaN");
+  check(!parses("fps 1e300\n"), "fps acima do limite");
+  check(!parses("frames 1000000\nsize 8192 8192\n"),
+        "size x frames acima do total (frames antes de size)");
+  check(parses("size 1024 1024\nframes 1000000\n"), "total no limite");
+  check(!parses("cube 0 0 0 0 0 0 1 1 1 1 0.1 0.7 0.2\n"
+                "cubekey 0 1e300 0 0 0 0 0 0 1\n"),
+        "frame de keyframe acima do limite");
+  check(!parses("camkey 5e9 0 0 5 0 0 0\n"), "frame de camkey acima do int");
+  if (failures == 0)
+    std::printf("ok\n");
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,73 @@
+// BVH mantida entre frames: o culling com refit (parcial e completo) da o
+// mesmo resultado de uma construcao nova, e caixas que crescem demais
+// levam a reconstrucao.
+#include "../src/core/BVH.h"
+#include "../src/core/Scene.h"
+#include <cstdio>
+#include <random>
+#include <vector>
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  if (!ok) {
+    std::printf("FALHOU: %s\n", what);
+    ++failures;
+  }
+}
+
+int main() {
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<double> u(-50.0, 50.0);
+  const int n = 20000;
+  std::vector<Cube> cubes(n);
+  for (Cube &cube : cubes)
+    cube.position = Vec3{u(rng), u(rng), u(rng)};
+
+  CubeBVH partial, full, fresh;
+  partial.update(cubes);
+  full.update(cubes);
+
+  Camera camera;
+  camera.aspect = 1.5;
+  std::vector<int> a, b, c, changed;
+  bool same = true;
+  for (int frame = 0; frame < 200; ++frame) {
+    // Passeio aleatorio de uma parte dos cubos
+    changed.clear();
+    for (int k = 0; k < 500; ++k) {
+      int i = static_cast<int>(rng() % n);
+      cubes[i].position = cubes[i].position +
+                          Vec3{u(rng) * 0.05, u(rng) * 0.05, u(rng) * 0.05};
+      changed.push_back(i);
+    }
+    partial.update(cubes, &changed);
+    full.update(cubes);
+    fresh.build(cubes);
+
+    camera.eye = Vec3{u(rng), u(rng), u(rng)};
+    Mat4 viewProj = camera.viewMatrix() * camera.projectionMatrix();
+    Frustum frustum =
+        Frustum::fromViewProj(viewProj, camera.nearPlane, camera.farPlane);
+    partial.cull(frustum, a);
+    full.cull(frustum, b);
+    fresh.cull(frustum, c);
+    same = same && a == c && b == c;
+  }
+  check(same, "culling com refit igual ao de uma BVH nova");
+
+  // Cena refeita com o mesmo numero de cubos: as folhas antigas ficam
+  // espalhadas pela cena toda e a hierarquia e reconstruida
+  int before = partial.rebuildCount();
+  changed.clear();
+  for (int i = 0; i < n; ++i) {
+    cubes[i].position = Vec3{u(rng), u(rng), u(rng)};
+    changed.push_back(i);
+  }
+  partial.update(cubes, &changed);
+  check(partial.rebuildCount() > before, "reconstroi depois de refazer a cena");
+
+  if (failures == 0)
+    std::printf("ok\n");
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,69 @@
+// Grafo de cena no contexto retido: set_cube num cubo anexado troca o
+// material, mas a transformacao continua vindo do no.
+#include "../render_api.h"
+#include "../src/pipeline/RenderContext.h"
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  if (!ok) {
+    std::printf("FALHOU: %s\n", what);
+    ++failures;
+  }
+}
+
+static bool near(const Vec3 &a, const Vec3 &b) {
+  return std::abs(a.x - b.x) < 1e-9 && std::abs(a.y - b.y) < 1e-9 &&
+         std::abs(a.z - b.z) < 1e-9;
+}
+
+int main() {
+  render_context_t *ctx = render_context_create();
+  render_context_set_camera(ctx, 0, 5, 20, 0, 0, 0, 60, 0.1, 100);
+  render_context_set_cube_count(ctx, 2);
+  const double cube[13] = {0, 0, 0, 0, 0, 0, 1, 1, 0, 0, 0.1, 0.7, 0.2};
+  render_context_set_cube(ctx, 0, cube);
+  render_context_set_cube(ctx, 1, cube);
+
+  int parent = render_context_create_cube_node(ctx, 0, -1);
+  int child = render_context_create_cube_node(ctx, 1, parent);
+  check(parent >= 0 && child >= 0, "cria os nos");
+  check(render_context_create_cube_node(ctx, 1, -1) < 0,
+        "cubo ja anexado e recusado");
+  const double parentTrs[7] = {2, 0, 0, 0, 0, 0, 2};
+  const double childTrs[7] = {1, 1, 0, 0, 0, 0, 1};
+  render_context_set_node_transform(ctx, parent, parentTrs);
+  render_context_set_node_transform(ctx, child, childTrs);
+
+  std::vector<uint32_t> pixels(64 * 48);
+  render_context_render(ctx, 64, 48, 1, pixels.data());
+  const Cube &attached = ctx->scene.cubes[1];
+  const Vec3 world{4, 2, 0}; // (1, 1, 0) * 2 + (2, 0, 0)
+  check(near(attached.position, world), "mundo do filho");
+  check(attached.scale == 2.0, "escala do filho");
+
+  // set_cube com outra posicao e outra cor: a cor fica, a posicao nao
+  const double moved[13] = {-7, 3, 5, 0.5, 0, 0, 3, 0, 1, 0, 0.1, 0.7, 0.2};
+  render_context_set_cube(ctx, 1, moved);
+  render_context_render(ctx, 64, 48, 1, pixels.data());
+  check(near(attached.position, world), "posicao do no depois do set_cube");
+  check(near(attached.rotation, Vec3{0, 0, 0}),
+        "rotacao do no depois do set_cube");
+  check(attached.scale == 2.0, "escala do no depois do set_cube");
+  check(near(attached.material.color, Vec3{0, 1, 0}),
+        "material do set_cube");
+
+  // E continua seguindo o pai
+  const double parentMoved[7] = {2, 0, -3, 0, 0, 0, 2};
+  render_context_set_node_transform(ctx, parent, parentMoved);
+  render_context_render(ctx, 64, 48, 1, pixels.data());
+  check(near(attached.position, Vec3{4, 2, -3}), "filho segue o pai");
+
+  render_context_destroy(ctx);
+  if (failures == 0)
+    std::printf("ok\n");
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,48 @@
+// Converte uma malha para o formato binario .rmesh (src/core/Mesh.h).
+//
+//   mesh_convert modelo.obj modelo.rmesh
+//
+// O .rmesh abre por mmap, sem parsing: converta os OBJ uma vez e carregue o
+// binario no app. Imprime os tempos de leitura do OBJ e de abertura do
+// .rmesh gerado.
+#include "src/core/Mesh.h"
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+static double msSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+int main(int argc, char **argv) {
+  if (argc != 3) {
+    std::fprintf(stderr, "uso: mesh_convert ENTRADA.obj SAIDA.rmesh\n");
+    return 2;
+  }
+  std::string error;
+  auto start = std::chrono::steady_clock::now();
+  auto mesh = Mesh::load(argv[1], error);
+  if (!mesh) {
+    std::fprintf(stderr, "%s: %s\n", argv[1], error.c_str());
+    return 1;
+  }
+  double loadMs = msSince(start);
+  if (!mesh->saveBinary(argv[2], error)) {
+    std::fprintf(stderr, "%s: %s\n", argv[2], error.c_str());
+    return 1;
+  }
+
+  start = std::chrono::steady_clock::now();
+  auto mapped = Mesh::loadBinary(argv[2], error);
+  if (!mapped) {
+    std::fprintf(stderr, "%s: %s\n", argv[2], error.c_str());
+    return 1;
+  }
+  double mapMs = msSince(start);
+  std::printf("%d vertices, %d triangulos\n", mesh->vertexCount(),
+              mesh->triangleCount());
+  std::printf("%s: %.2f ms\n%s: %.3f ms\n", argv[1], loadMs, argv[2], mapMs);
+  return 0;
+}